@@ -2,14 +2,6 @@
 
 in vec3 VPosition;
 in float VTotalDeformation;
-in vec3 VDeformation;
-in vec3 VNormalElasticStrain;
-in vec3 VShearElasticStrain;
-in float VMaximumPrincipalStress;
-in float VMiddlePrincipalStress;
-in float VMinimumPrincipalStress;
-in vec3 VNormalStress;
-in vec3 VShearStress;
 
 out vec4 FColor;
 
@@ -0,0 +1,51 @@
+#include "batchrunner.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QThread>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("NumericalModelingViewerBatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Numerical Modeling Viewer batch export");
+    parser.addHelpOption();
+    parser.addPositionalArgument("jobfile", "Batch job file.");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads", "Number of jobs run in parallel.", "threads", QString::number(QThread::idealThreadCount()));
+    parser.addOption(threadsOption);
+    QCommandLineOption benchmarkOption("benchmark", "Run the benchmarks on a model instead of a job file.", "model");
+    parser.addOption(benchmarkOption);
+    parser.process(a);
+
+    if (parser.isSet(benchmarkOption))
+    {
+        return BatchRunner::runBenchmark(parser.value(benchmarkOption)) ? 0 : 1;
+    }
+
+    QTextStream err(stderr);
+    QStringList arguments = parser.positionalArguments();
+    if (arguments.count() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    QVector<BatchJob> jobs;
+    QString errorMessage;
+    if (!BatchRunner::loadJobFile(arguments[0], jobs, errorMessage))
+    {
+        err << errorMessage << "\n";
+        return 1;
+    }
+
+    bool ok = false;
+    int threadCount = parser.value(threadsOption).toInt(&ok);
+    if (!ok || threadCount <= 0)
+    {
+        err << "Invalid thread count: " << parser.value(threadsOption) << "\n";
+        return 1;
+    }
+
+    return BatchRunner::run(jobs, threadCount) ? 0 : 2;
+}
@@ -0,0 +1,360 @@
+#include "batchrunner.h"
+#include "geoutil.h"
+#include "modelloader.h"
+#include "brickedmodel.h"
+#include "meshwriter.h"
+#include "edbreader.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrent>
+
+// BatchRunnerԱʵ
+bool BatchRunner::loadJobFile(const QString& fileName, QVector<BatchJob>& jobs, QString& errorMessage)
+{
+	QFile jobFile(fileName);
+	if (!jobFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		errorMessage = QStringLiteral("޷ҵļ%1").arg(fileName);
+		return false;
+	}
+
+	QDir jobDir = QFileInfo(fileName).absoluteDir();
+	QTextStream in(&jobFile);
+	int lineNum = 0;
+	while (!in.atEnd())
+	{
+		QString line = in.readLine().simplified();
+		++lineNum;
+		if (line.isEmpty() || line.startsWith("#"))
+		{
+			continue;
+		}
+
+		QStringList tokens = line.split(' ');
+		QString key = tokens[0];
+		if (key == "model")
+		{
+			if (tokens.count() < 2)
+			{
+				errorMessage = QStringLiteral("%1ȱģļ").arg(lineNum);
+				return false;
+			}
+
+			BatchJob job;
+			job.modelFileName = jobDir.absoluteFilePath(line.mid(key.length() + 1));
+			job.outputPath = jobDir.absolutePath();
+			jobs.append(job);
+			continue;
+		}
+
+		if (jobs.isEmpty())
+		{
+			errorMessage = QStringLiteral("%1֮ǰûָģļ").arg(lineNum);
+			return false;
+		}
+
+		BatchJob& job = jobs.back();
+		bool parsed = true;
+		if (key == "output" && tokens.count() >= 2)
+		{
+			job.outputPath = jobDir.absoluteFilePath(line.mid(key.length() + 1));
+		}
+		else if (key == "volume" && tokens.count() == 1)
+		{
+			job.exportVolume = true;
+		}
+		else if (key == "clip" && tokens.count() == 7)
+		{
+			QVector<float> values;
+			parsed = parseValues(tokens, 1, values);
+			if (parsed)
+			{
+				Plane plane;
+				plane.origin = QVector3D(values[0], values[1], values[2]);
+				plane.normal = QVector3D(values[3], values[4], values[5]);
+				plane.normalize();
+				parsed = !plane.normal.isNull();
+				job.clipPlanes.append(plane);
+			}
+		}
+		else if (key == "isosurface")
+		{
+			parsed = parseValues(tokens, 1, job.isosurfaceValues);
+		}
+		else if (key == "isoline")
+		{
+			parsed = parseValues(tokens, 1, job.isolineValues);
+		}
+		else if (key == "isosurfaceRatio")
+		{
+			parsed = parseValues(tokens, 1, job.isosurfaceRatios);
+		}
+		else if (key == "isolineRatio")
+		{
+			parsed = parseValues(tokens, 1, job.isolineRatios);
+		}
+		else
+		{
+			parsed = false;
+		}
+
+		if (!parsed)
+		{
+			errorMessage = QStringLiteral("%1иʽ%2").arg(lineNum).arg(line);
+			return false;
+		}
+	}
+
+	if (jobs.isEmpty())
+	{
+		errorMessage = QStringLiteral("ҵļûҵ%1").arg(fileName);
+		return false;
+	}
+	return true;
+}
+
+BatchJobResult BatchRunner::runJob(const BatchJob& job)
+{
+	BatchJobResult result;
+	QElapsedTimer totalTimer;
+	totalTimer.start();
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	// ÿҵزģֿͣģʱש飬ש黺漰ļĶȡλòҵ̼߳乲
+	// ֿҲģ͸Ա棬Сֵ漰ֵ߼㱾ֻȡģ
+	ModelLoader loader;
+	if (!loader.load(job.modelFileName))
+	{
+		result.errorMessage = loader.getErrorMessage();
+		if (result.errorMessage.isEmpty())
+		{
+			result.errorMessage = QStringLiteral("޷ģͣ%1").arg(job.modelFileName);
+		}
+		result.totalTime = totalTimer.elapsed();
+		return result;
+	}
+	result.loadTime = profileTimer.restart();
+
+	if (!QDir().mkpath(job.outputPath))
+	{
+		result.errorMessage = QStringLiteral("޷Ŀ¼%1").arg(job.outputPath);
+		result.totalTime = totalTimer.elapsed();
+		return result;
+	}
+
+	bool written = true;
+	auto save = [&](const QString& fileName, bool saved) {
+		if (saved)
+		{
+			++result.fileNum;
+		}
+		else if (written)
+		{
+			written = false;
+			result.errorMessage = QStringLiteral("޷дļ%1").arg(fileName);
+		}
+	};
+
+	// ģͣԪֿʱ
+	if (job.exportVolume && !loader.zones.isEmpty())
+	{
+		profileTimer.restart();
+		QString fileName = outputFileName(job, "volume", -1);
+		save(fileName, MeshWriter::saveVTU(fileName, loader.nodeAttributes, loader.zones, loader.resultFields));
+		result.writeTime += profileTimer.elapsed();
+	}
+
+	// 
+	bool hasZones = !loader.zones.isEmpty() || loader.brickedModel;
+	for (int i = 0; hasZones && i < job.clipPlanes.count(); ++i)
+	{
+		profileTimer.restart();
+		QVector<NodeVertex> sectionVertices;
+		QVector<uint32_t> sectionIndices;
+		QVector<uint32_t> sectionWireframeIndices;
+		if (loader.brickedModel)
+		{
+			loader.brickedModel->clipZones(job.clipPlanes[i], loader.nodeAttributes, sectionVertices, sectionIndices, sectionWireframeIndices);
+		}
+		else
+		{
+			GeoUtil::clipZones(loader.zones, job.clipPlanes[i], loader.zoneBVH, loader.nodeAttributes.positions, loader.nodeAttributes.values(), sectionVertices, sectionIndices, sectionWireframeIndices);
+		}
+		result.clipTime += profileTimer.elapsed();
+		++result.sectionNum;
+
+		profileTimer.restart();
+		QString fileName = outputFileName(job, "section", i);
+		save(fileName, MeshWriter::savePLY(fileName, sectionVertices, sectionIndices));
+		result.writeTime += profileTimer.elapsed();
+	}
+
+	// ֵλƷΧ㣬滬һ
+	float minValue = loader.valueRange.minTotalDeformation;
+	float maxValue = loader.valueRange.maxTotalDeformation;
+	auto mapRatios = [minValue, maxValue](const QVector<float>& values, const QVector<float>& ratios) {
+		QVector<float> mappedValues = values;
+		for (float ratio : ratios)
+		{
+			mappedValues.append(minValue + (maxValue - minValue) * ratio);
+		}
+		return mappedValues;
+	};
+
+	// ֵ
+	QVector<float> isosurfaceValues = mapRatios(job.isosurfaceValues, job.isosurfaceRatios);
+	for (int i = 0; hasZones && !loader.uniformGrids.voxelData.isEmpty() && i < isosurfaceValues.count(); ++i)
+	{
+		profileTimer.restart();
+		QVector<NodeVertex> isosurfaceVertices;
+		QVector<uint32_t> isosurfaceIndices;
+		GeoUtil::genIsosurface(loader.uniformGrids, isosurfaceValues[i], isosurfaceVertices, isosurfaceIndices);
+		result.isosurfaceTime += profileTimer.elapsed();
+		++result.isosurfaceNum;
+
+		profileTimer.restart();
+		QString fileName = outputFileName(job, "isosurface", i);
+		save(fileName, MeshWriter::savePLY(fileName, isosurfaceVertices, isosurfaceIndices));
+		result.writeTime += profileTimer.elapsed();
+	}
+
+	// ֵ
+	QVector<float> isolineValues = mapRatios(job.isolineValues, job.isolineRatios);
+	for (int i = 0; i < isolineValues.count(); ++i)
+	{
+		profileTimer.restart();
+		QVector<ClipLine> clipLines = GeoUtil::genIsolines(loader.mesh, loader.nodeAttributes.positions, loader.nodeAttributes.values(), isolineValues[i], loader.faceValueTree);
+		QVector<NodeVertex> isolineVertices;
+		GeoUtil::flattenIsolines(clipLines, isolineValues[i], isolineVertices);
+		result.isolineTime += profileTimer.elapsed();
+		++result.isolineNum;
+
+		profileTimer.restart();
+		QString fileName = outputFileName(job, "isoline", i);
+		save(fileName, MeshWriter::savePLY(fileName, isolineVertices, QVector<uint32_t>(), 2));
+		result.writeTime += profileTimer.elapsed();
+	}
+
+	result.succeeded = written;
+	result.totalTime = totalTimer.elapsed();
+	return result;
+}
+
+bool BatchRunner::run(const QVector<BatchJob>& jobs, int threadCount)
+{
+	QTextStream out(stdout);
+	QElapsedTimer wallTimer;
+	wallTimer.start();
+
+	// ҵ֮䲢Уҵڲ
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(qMax(1, threadCount));
+	QVector<QFuture<BatchJobResult>> futures;
+	for (const BatchJob& job : jobs)
+	{
+		futures.append(QtConcurrent::run(&threadPool, &BatchRunner::runJob, job));
+	}
+
+	bool succeeded = true;
+	qint64 jobTime = 0;
+	for (int i = 0; i < futures.count(); ++i)
+	{
+		BatchJobResult result = futures[i].result();
+		jobTime += result.totalTime;
+		out << QString("job %1 %2: ").arg(i + 1).arg(QFileInfo(jobs[i].modelFileName).fileName());
+		if (result.succeeded)
+		{
+			out << QString("load %1 ms, clip %2 ms (%3), isosurface %4 ms (%5), isoline %6 ms (%7), write %8 ms (%9 files), total %10 ms")
+				.arg(result.loadTime).arg(result.clipTime).arg(result.sectionNum)
+				.arg(result.isosurfaceTime).arg(result.isosurfaceNum)
+				.arg(result.isolineTime).arg(result.isolineNum)
+				.arg(result.writeTime).arg(result.fileNum).arg(result.totalTime) << "\n";
+		}
+		else
+		{
+			out << "failed, " << result.errorMessage << "\n";
+			succeeded = false;
+		}
+		out.flush();
+	}
+
+	qint64 wallTime = wallTimer.elapsed();
+	out << QString("%1 jobs, %2 threads, wall %3 ms, job sum %4 ms, speedup %5")
+		.arg(jobs.count()).arg(threadPool.maxThreadCount()).arg(wallTime).arg(jobTime)
+		.arg(wallTime > 0 ? (double)jobTime / wallTime : 1.0, 0, 'f', 2) << "\n";
+	out.flush();
+	return succeeded;
+}
+
+bool BatchRunner::runBenchmark(const QString& modelFileName)
+{
+	if (!QFileInfo::exists(modelFileName))
+	{
+		QTextStream(stderr) << QStringLiteral("ģļڣ%1").arg(modelFileName) << "\n";
+		return false;
+	}
+
+	// EDBģͣԭжȡʽ뵥ӡӶȡĺʱԱ
+	if (QFileInfo(modelFileName).suffix().toLower() == "edb")
+	{
+		EDBReader::benchmark(modelFileName);
+	}
+
+	// ʹüؼԤģ
+	ModelLoader loader;
+	if (!loader.load(modelFileName))
+	{
+		QTextStream(stderr) << QStringLiteral("޷ģͣ%1").arg(modelFileName) << "\n";
+		return false;
+	}
+
+	// ߱뿪ѰַϣĽѯʱԱ
+	GeoUtil::benchmarkMeshEdges(loader.mesh);
+
+	// ԪbvhλͰSAHмʰȡʱԱȣʱ߳ı仯Ԫֿʱû嵥Ԫ
+	if (!loader.zones.isEmpty())
+	{
+		GeoUtil::benchmarkBVH(loader.zones, loader.nodeAttributes.positions, loader.nodeAttributes.values());
+	}
+
+	// ֵ밴ֵΧнbvhĲѯʱԱ
+	GeoUtil::benchmarkIntervalTree(loader.mesh, loader.nodeAttributes.values());
+	return true;
+}
+
+bool BatchRunner::parseValues(const QStringList& tokens, int first, QVector<float>& values)
+{
+	if (first >= tokens.count())
+	{
+		return false;
+	}
+
+	for (int i = first; i < tokens.count(); ++i)
+	{
+		bool ok = false;
+		float value = tokens[i].toFloat(&ok);
+		if (!ok)
+		{
+			return false;
+		}
+		values.append(value);
+	}
+	return true;
+}
+
+QString BatchRunner::outputFileName(const BatchJob& job, const QString& kind, int index)
+{
+	// ģдΪVTUдΪPLY
+	QString baseName = QFileInfo(job.modelFileName).completeBaseName();
+	if (index < 0)
+	{
+		return QDir(job.outputPath).filePath(QString("%1_%2.vtu").arg(baseName).arg(kind));
+	}
+	return QDir(job.outputPath).filePath(QString("%1_%2_%3.ply").arg(baseName).arg(kind).arg(index));
+}
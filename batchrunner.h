@@ -0,0 +1,64 @@
+#pragma once
+
+#include "geotypes.h"
+#include <QStringList>
+
+/**
+	ࣨ޽ȡģͣҵļɽ桢ֵ漰ֵ߲д̣ҵִУ
+
+	ҵļΪıʽÿһؼּ#ͷΪעͣÿmodelʼһҵ
+		model <ģļ>
+		output <Ŀ¼>
+		volume
+		clip <ԭx y z> <x y z>
+		isosurface <ֵ...>
+		isoline <ֵ...>
+		isosurfaceRatio <ֵΧڵı...>
+		isolineRatio <ֵΧڵı...>
+	volumeVTUģͣ桢ֵ漰ֵߵΪPLY·ҵļĿ¼δָĿ¼ʱҵļĿ¼
+
+	runBenchmarkԵģи׼ԣqDebug
+*/
+
+struct BatchJob
+{
+	QString modelFileName;
+	QString outputPath;
+	bool exportVolume = false;
+	QVector<Plane> clipPlanes;
+	QVector<float> isosurfaceValues;
+	QVector<float> isolineValues;
+	QVector<float> isosurfaceRatios;
+	QVector<float> isolineRatios;
+};
+
+struct BatchJobResult
+{
+	bool succeeded = false;
+	QString errorMessage;
+	int sectionNum = 0;
+	int isosurfaceNum = 0;
+	int isolineNum = 0;
+	int fileNum = 0;
+
+	// 
+	qint64 loadTime = 0;
+	qint64 clipTime = 0;
+	qint64 isosurfaceTime = 0;
+	qint64 isolineTime = 0;
+	qint64 writeTime = 0;
+	qint64 totalTime = 0;
+};
+
+class BatchRunner
+{
+public:
+	static bool loadJobFile(const QString& fileName, QVector<BatchJob>& jobs, QString& errorMessage);
+	static BatchJobResult runJob(const BatchJob& job);
+	static bool run(const QVector<BatchJob>& jobs, int threadCount);
+	static bool runBenchmark(const QString& modelFileName);
+
+private:
+	static bool parseValues(const QStringList& tokens, int first, QVector<float>& values);
+	static QString outputFileName(const BatchJob& job, const QString& kind, int index);
+};
@@ -0,0 +1,617 @@
+#include "brickedmodel.h"
+#include "geoutil.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+
+// BrickStatsԱʵ
+double BrickStats::hitRate() const
+{
+	return requestNum > 0 ? (double)hitNum / requestNum : 0.0;
+}
+
+// BrickedModel::BrickԱʵ
+int BrickedModel::Brick::cacheCost() const
+{
+	// 濪KBƣԪ鼰bvh
+	qint64 bytes = zones.memoryUsage() + tree.memoryUsage();
+	return qMax(1, (int)(bytes / 1024));
+}
+
+// BrickedModelԱʵ
+BrickedModel::BrickedModel(int maxMemoryMB) : brickCache(maxMemoryMB * 1024)
+{
+	tableOffset = 0;
+	edgeNum = 0;
+	valueVersion = 0;
+}
+
+BrickedModel::~BrickedModel()
+{
+	if (isOpen())
+	{
+		printStats();
+	}
+	close();
+}
+
+QString BrickedModel::brickFileName(const QString& fileName)
+{
+	return fileName + ".nmvbricks";
+}
+
+bool BrickedModel::build(const QString& fileName, const ZoneSet& zones, int brickZoneNum)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	ModelCache cache;
+	if (zones.isEmpty() || !cache.create(brickFileName(fileName), ModelCache::sourceFileNames(fileName)))
+	{
+		return false;
+	}
+	cache.writeValue(kBrickFileMagic);
+
+	// Ԫĵݹз֣ÿ鲻brickZoneNumԪ
+	QVector<uint32_t> zoneIndices(zones.count());
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		zoneIndices[i] = i;
+	}
+	QVector<QPair<int, int>> ranges;
+	partitionZones(zones, zoneIndices, 0, zones.count(), qMax(1, brickZoneNum), ranges);
+
+	// д뵥ԪݼbvhԪΪڱţڵΪȫֱ
+	QVector<CachedBrick> cachedBricks(ranges.count());
+	for (int b = 0; b < ranges.count(); ++b)
+	{
+		ZoneSet brickZones;
+		brickZones.reserve(ranges[b].second - ranges[b].first);
+		for (int i = ranges[b].first; i < ranges[b].second; ++i)
+		{
+			brickZones.append(zones, zoneIndices[i]);
+		}
+
+		LinearBVH tree = GeoUtil::buildBVHTree(brickZones);
+		quint64 groupMask = GeoUtil::updateBVHGroupMask(brickZones, tree);
+
+		CachedBrick& cachedBrick = cachedBricks[b];
+		cachedBrick.boundMin = tree.bound().min;
+		cachedBrick.boundMax = tree.bound().max;
+		cachedBrick.groupMask = groupMask;
+		cachedBrick.offset = cache.tell();
+		cachedBrick.zoneNum = brickZones.count();
+		cachedBrick.zoneOffset = ranges[b].first;
+
+		cache.writeZones(brickZones);
+		cache.writeBVH(tree);
+	}
+
+	// ԪڵCSRֶζȡʱԪƽڵ㣬פڴ
+	QVector<int> zoneNodeOffsets(zones.count() + 1);
+	QVector<uint32_t> zoneNodes;
+	zoneNodes.reserve(zones.count() * 8);
+	zoneNodeOffsets[0] = 0;
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		const quint32* vertices = zones.zoneVertices(i);
+		for (int j = 0; j < zones.vertexNum(i); ++j)
+		{
+			zoneNodes.append(vertices[j]);
+		}
+		zoneNodeOffsets[i + 1] = zoneNodes.count();
+	}
+
+	// ļĩβ8ֽΪƫ
+	qint64 offset = cache.tell();
+	cache.writeValue(qint64(zones.edges.count()));
+	cache.writeArray(cachedBricks);
+	cache.writeArray(zoneIndices);
+	cache.writeArray(zoneNodeOffsets);
+	cache.writeArray(zoneNodes);
+	cache.writeValue(offset);
+	bool result = cache.commit();
+
+	qint64 buildTime = profileTimer.elapsed();
+	qDebug() << "build bricks time:" << buildTime << "bricks:" << ranges.count() << "zones:" << zones.count();
+	return result;
+}
+
+bool BrickedModel::open(const QString& fileName)
+{
+	close();
+
+	quint32 magic;
+	bool result = cache.open(brickFileName(fileName), ModelCache::sourceFileNames(fileName)) &&
+		cache.readValue(magic) && magic == kBrickFileMagic &&
+		cache.seek(cache.fileSize() - sizeof(tableOffset)) &&
+		cache.readValue(tableOffset) &&
+		cache.seek(tableOffset) &&
+		cache.readValue(edgeNum) && edgeNum >= 0 && edgeNum < kInvalidIndex &&
+		cache.readArray(bricks) &&
+		cache.readArray(brickZones);
+
+	// ȫֵԪŵڿ鼰ڱŵӳ
+	zoneBricks.resize(brickZones.count());
+	zoneSlots.resize(brickZones.count());
+	for (int b = 0; result && b < bricks.count(); ++b)
+	{
+		const CachedBrick& cachedBrick = bricks[b];
+		if (cachedBrick.zoneOffset < 0 || cachedBrick.zoneNum < 0 || cachedBrick.zoneOffset + cachedBrick.zoneNum > brickZones.count())
+		{
+			result = false;
+			break;
+		}
+
+		for (int i = 0; i < cachedBrick.zoneNum; ++i)
+		{
+			uint32_t zoneIndex = brickZones[cachedBrick.zoneOffset + i];
+			if (zoneIndex >= (uint32_t)brickZones.count())
+			{
+				result = false;
+				break;
+			}
+			zoneBricks[zoneIndex] = b;
+			zoneSlots[zoneIndex] = i;
+		}
+	}
+
+	if (!result || bricks.isEmpty())
+	{
+		qDebug() << "Invalid brick file: " << brickFileName(fileName);
+		close();
+		return false;
+	}
+
+	buildBrickTree();
+	qDebug() << "open bricks:" << bricks.count() << "zones:" << brickZones.count();
+	return true;
+}
+
+void BrickedModel::close()
+{
+	brickCache.clear();
+	cache.close();
+	tableOffset = 0;
+	edgeNum = 0;
+	bricks.clear();
+	brickZones.clear();
+	brickTreeNodes.clear();
+	zoneBricks.clear();
+	zoneSlots.clear();
+}
+
+bool BrickedModel::isOpen() const
+{
+	return !brickTreeNodes.isEmpty();
+}
+
+int BrickedModel::getZoneNum() const
+{
+	return brickZones.count();
+}
+
+int BrickedModel::getBrickNum() const
+{
+	return bricks.count();
+}
+
+Bound BrickedModel::getBound() const
+{
+	return brickTreeNodes.isEmpty() ? Bound() : brickTreeNodes[0].bound;
+}
+
+bool BrickedModel::readZoneNodes(QVector<int>& zoneNodeOffsets, QVector<uint32_t>& zoneNodes)
+{
+	// Ԫ
+	return isOpen() && cache.seek(tableOffset + sizeof(edgeNum)) &&
+		cache.skipArray() && cache.skipArray() &&
+		cache.readArray(zoneNodeOffsets) &&
+		cache.readArray(zoneNodes) &&
+		zoneNodeOffsets.count() == brickZones.count() + 1;
+}
+
+void BrickedModel::invalidateValues()
+{
+	++valueVersion;
+}
+
+void BrickedModel::clipZones(const Plane& plane, const NodeAttributes& nodeAttributes, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices, quint64 groupMask)
+{
+	sectionVertices.clear();
+	sectionIndices.clear();
+	sectionWireframeIndices.clear();
+	if (!isOpen())
+	{
+		return;
+	}
+
+	for (BrickTreeNode& node : brickTreeNodes)
+	{
+		node.bound.reset();
+	}
+	QVector<int> hitBricks;
+	findBricks(0, plane, groupMask, hitBricks);
+
+	// 鹲ðȫֱ߱Ľ߽ϵĽ㲻ظ
+	QVector<uint32_t> edgeIntersections((int)edgeNum, kInvalidIndex);
+	EdgeIndex sectionWireframes;
+	for (int b : hitBricks)
+	{
+		Brick* p = brick(b, nodeAttributes.values());
+		if (p)
+		{
+			GeoUtil::clipZones(p->zones, plane, p->tree, nodeAttributes.positions, nodeAttributes.values(), edgeIntersections, sectionVertices, sectionIndices, sectionWireframes, groupMask);
+		}
+	}
+
+	for (int i = 0; i < sectionWireframes.count(); ++i)
+	{
+		Edge edge = sectionWireframes.edge(i);
+		sectionWireframeIndices.append({ edge.vertices[0], edge.vertices[1] });
+	}
+}
+
+void BrickedModel::pickZone(const Ray& ray, const NodeAttributes& nodeAttributes, QVector<uint32_t>& pickIndices, bool pickZoneMode, quint64 groupMask)
+{
+	pickIndices.clear();
+	if (!isOpen())
+	{
+		return;
+	}
+
+	QVector<int> hitBricks;
+	findBricks(0, ray, groupMask, hitBricks);
+
+	// ʰȡϲȡһ
+	QMap<float, QSet<Edge>> pickEdgesMap;
+	for (int b : hitBricks)
+	{
+		Brick* p = brick(b, nodeAttributes.values());
+		if (p)
+		{
+			GeoUtil::pickZone(p->zones, ray, p->tree, nodeAttributes.positions, pickEdgesMap, pickZoneMode, groupMask);
+		}
+	}
+
+	if (!pickEdgesMap.empty())
+	{
+		for (const auto& iter : pickEdgesMap.cbegin().value())
+		{
+			pickIndices.append({ iter.vertices[0], iter.vertices[1] });
+		}
+	}
+}
+
+void BrickedModel::sampleUniformGrids(const NodeAttributes& nodeAttributes, UniformGrids& uniformGrids)
+{
+	const std::array<int, 3>& dim = uniformGrids.dim;
+	int voxelNum = dim[0] * dim[1] * dim[2];
+	uniformGrids.sampleZones.fill(kInvalidIndex, voxelNum);
+	uniformGrids.sampleCoords.resize(voxelNum);
+	if (!isOpen())
+	{
+		GeoUtil::updateUniformGridPoints(uniformGrids);
+		return;
+	}
+
+	// Ȱط䵽Ŀ飬鶨λÿֻһ
+	QVector<QVector<int>> brickVoxels(bricks.count());
+	QVector<int> found;
+	int index = 0;
+	for (int x = 0; x < dim[0]; ++x)
+	{
+		for (int y = 0; y < dim[1]; ++y)
+		{
+			for (int z = 0; z < dim[2]; ++z, ++index)
+			{
+				found.clear();
+				findBricks(0, uniformGrids.position(x, y, z), found);
+				for (int b : found)
+				{
+					brickVoxels[b].append(index);
+				}
+			}
+		}
+	}
+
+	for (int b = 0; b < bricks.count(); ++b)
+	{
+		if (brickVoxels[b].isEmpty())
+		{
+			continue;
+		}
+
+		Brick* p = brick(b, nodeAttributes.values());
+		if (!p)
+		{
+			continue;
+		}
+
+		for (int i : brickVoxels[b])
+		{
+			uint32_t zoneIndex;
+			QVector3D position = uniformGrids.position(i / (dim[1] * dim[2]), i / dim[2] % dim[1], i % dim[2]);
+			if (uniformGrids.sampleZones[i] == kInvalidIndex && GeoUtil::locateZone(p->zones, p->tree, position, zoneIndex))
+			{
+				uniformGrids.sampleCoords[i] = p->zones.localCoords(zoneIndex, position);
+				uniformGrids.sampleZones[i] = brickZones[bricks[b].zoneOffset + zoneIndex];
+			}
+		}
+	}
+	GeoUtil::updateUniformGridPoints(uniformGrids);
+}
+
+void BrickedModel::resampleUniformGrids(const NodeAttributes& nodeAttributes, UniformGrids& uniformGrids)
+{
+	int voxelNum = uniformGrids.sampleZones.count();
+	QVector<float> values(voxelNum, 0.0f);
+	QVector<QVector<int>> brickVoxels(bricks.count());
+	for (int i = 0; i < voxelNum; ++i)
+	{
+		uint32_t zoneIndex = uniformGrids.sampleZones[i];
+		if (zoneIndex != kInvalidIndex && zoneIndex < (uint32_t)zoneBricks.count())
+		{
+			brickVoxels[zoneBricks[zoneIndex]].append(i);
+		}
+	}
+
+	// ֵÿֻһ
+	for (int b = 0; b < bricks.count(); ++b)
+	{
+		Brick* p = brickVoxels[b].isEmpty() ? nullptr : brick(b, nodeAttributes.values());
+		if (!p)
+		{
+			continue;
+		}
+
+		for (int i : brickVoxels[b])
+		{
+			values[i] = p->zones.interpValue(zoneSlots[uniformGrids.sampleZones[i]], uniformGrids.sampleCoords[i]);
+		}
+	}
+
+	// ԪǰһصֵGeoUtil::resampleUniformGridsһ£
+	uniformGrids.voxelData.resize(voxelNum);
+	float value = voxelNum > 0 ? uniformGrids.voxelData[0] : 0.0f;
+	int pointIndex = 0;
+	for (int i = 0; i < voxelNum; ++i)
+	{
+		if (uniformGrids.sampleZones[i] != kInvalidIndex)
+		{
+			value = values[i];
+			if (pointIndex < uniformGrids.points.count())
+			{
+				uniformGrids.points[pointIndex++].value = value;
+			}
+		}
+		uniformGrids.voxelData[i] = value;
+	}
+	GeoUtil::updateVoxelBlockTree(uniformGrids);
+}
+
+void BrickedModel::setMemoryBudget(int maxMemoryMB)
+{
+	int cachedNum = brickCache.count();
+	brickCache.setMaxCost(maxMemoryMB * 1024);
+	stats.evictNum += cachedNum - brickCache.count();
+}
+
+int BrickedModel::getMemoryUsage() const
+{
+	return brickCache.totalCost();
+}
+
+BrickStats BrickedModel::getStats() const
+{
+	return stats;
+}
+
+void BrickedModel::printStats() const
+{
+	qDebug() << "bricks requests:" << stats.requestNum << "hits:" << stats.hitNum << "page faults:" << stats.pageFaultNum
+		<< "evictions:" << stats.evictNum << "hit rate:" << stats.hitRate()
+		<< "read(KB):" << stats.readBytes / 1024 << "page in time:" << stats.pageInTime
+		<< "cached bricks:" << brickCache.count() << "/" << bricks.count()
+		<< "cache(KB):" << brickCache.totalCost() << "/" << brickCache.maxCost();
+}
+
+BrickedModel::Brick* BrickedModel::brick(int index, const QVector<float>& nodeValues)
+{
+	// صָһζ֮ǰЧ
+	++stats.requestNum;
+	Brick* p = brickCache.object(index);
+	if (p)
+	{
+		++stats.hitNum;
+	}
+	else
+	{
+		p = pageIn(index);
+		if (!p)
+		{
+			return nullptr;
+		}
+	}
+
+	if (p->valueVersion != valueVersion)
+	{
+		p->zones.cacheValues(nodeValues);
+		p->valueVersion = valueVersion;
+	}
+	return p;
+}
+
+BrickedModel::Brick* BrickedModel::pageIn(int index)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+	++stats.pageFaultNum;
+
+	const CachedBrick& cachedBrick = bricks[index];
+	qint64 begin = cachedBrick.offset;
+	Brick* p = new Brick;
+	bool result = cache.seek(begin) &&
+		cache.readZones(p->zones) &&
+		p->zones.count() == cachedBrick.zoneNum &&
+		cache.readBVH(p->tree, p->zones.count()) &&
+		std::all_of(p->zones.edgeIds.begin(), p->zones.edgeIds.end(), [this](quint32 edgeId) { return edgeId < edgeNum; });
+	if (!result)
+	{
+		qDebug() << "Invalid brick:" << index;
+		delete p;
+		return nullptr;
+	}
+	GeoUtil::updateBVHGroupMask(p->zones, p->tree);
+
+	// ļв浥Ԫֵ蹲פڵ
+	p->valueVersion = valueVersion - 1;
+	stats.readBytes += cache.tell() - begin;
+
+	// 鳬ڴʱ룬޼ƣ̭п
+	int cost = qMin(p->cacheCost(), brickCache.maxCost());
+	int cachedNum = brickCache.count() + 1;
+	brickCache.insert(index, p, cost);
+	stats.evictNum += qMax(0, cachedNum - brickCache.count());
+	stats.pageInTime += profileTimer.elapsed();
+	return p;
+}
+
+void BrickedModel::buildBrickTree()
+{
+	// bvhÿҶڵӦһ
+	brickTreeNodes.clear();
+	brickTreeNodes.reserve(bricks.count() * 2);
+	QVector<int> brickIndices(bricks.count());
+	for (int i = 0; i < bricks.count(); ++i)
+	{
+		brickIndices[i] = i;
+	}
+	buildBrickTree(brickIndices, 0, bricks.count());
+}
+
+int BrickedModel::buildBrickTree(QVector<int>& brickIndices, int begin, int end)
+{
+	int index = brickTreeNodes.count();
+	brickTreeNodes.append(BrickTreeNode());
+	if (end - begin == 1)
+	{
+		const CachedBrick& cachedBrick = bricks[brickIndices[begin]];
+		BrickTreeNode& node = brickTreeNodes[index];
+		node.bound.min = cachedBrick.boundMin;
+		node.bound.max = cachedBrick.boundMax;
+		node.bound.cache();
+		node.groupMask = cachedBrick.groupMask;
+		node.brick = brickIndices[begin];
+		return index;
+	}
+
+	Bound centriodBound;
+	for (int i = begin; i < end; ++i)
+	{
+		const CachedBrick& cachedBrick = bricks[brickIndices[i]];
+		centriodBound.combine((cachedBrick.boundMin + cachedBrick.boundMax) * 0.5f);
+	}
+
+	int dim = centriodBound.maxDim();
+	int mid = (begin + end) / 2;
+	std::nth_element(brickIndices.begin() + begin, brickIndices.begin() + mid, brickIndices.begin() + end,
+		[this, dim](int a, int b)
+	{
+		return bricks[a].boundMin[dim] + bricks[a].boundMax[dim] < bricks[b].boundMin[dim] + bricks[b].boundMax[dim];
+	});
+
+	int left = buildBrickTree(brickIndices, begin, mid);
+	int right = buildBrickTree(brickIndices, mid, end);
+	BrickTreeNode& node = brickTreeNodes[index];
+	node.children[0] = left;
+	node.children[1] = right;
+	node.bound.combine(brickTreeNodes[left].bound);
+	node.bound.combine(brickTreeNodes[right].bound);
+	node.bound.cache();
+	node.groupMask = brickTreeNodes[left].groupMask | brickTreeNodes[right].groupMask;
+	return index;
+}
+
+void BrickedModel::findBricks(int node, const Plane& plane, quint64 groupMask, QVector<int>& hitBricks)
+{
+	BrickTreeNode& treeNode = brickTreeNodes[node];
+	if (!(treeNode.groupMask & groupMask) || !treeNode.bound.intersect(plane))
+	{
+		return;
+	}
+
+	if (treeNode.brick >= 0)
+	{
+		hitBricks.append(treeNode.brick);
+	}
+	else
+	{
+		findBricks(treeNode.children[0], plane, groupMask, hitBricks);
+		findBricks(treeNode.children[1], plane, groupMask, hitBricks);
+	}
+}
+
+void BrickedModel::findBricks(int node, const Ray& ray, quint64 groupMask, QVector<int>& hitBricks)
+{
+	BrickTreeNode& treeNode = brickTreeNodes[node];
+	if (!(treeNode.groupMask & groupMask) || !treeNode.bound.intersect(ray))
+	{
+		return;
+	}
+
+	if (treeNode.brick >= 0)
+	{
+		hitBricks.append(treeNode.brick);
+	}
+	else
+	{
+		findBricks(treeNode.children[0], ray, groupMask, hitBricks);
+		findBricks(treeNode.children[1], ray, groupMask, hitBricks);
+	}
+}
+
+void BrickedModel::findBricks(int node, const QVector3D& point, QVector<int>& hitBricks) const
+{
+	const BrickTreeNode& treeNode = brickTreeNodes[node];
+	if (!treeNode.bound.contain(point))
+	{
+		return;
+	}
+
+	if (treeNode.brick >= 0)
+	{
+		hitBricks.append(treeNode.brick);
+	}
+	else
+	{
+		findBricks(treeNode.children[0], point, hitBricks);
+		findBricks(treeNode.children[1], point, hitBricks);
+	}
+}
+
+void BrickedModel::partitionZones(const ZoneSet& zones, QVector<uint32_t>& zoneIndices, int begin, int end, int brickZoneNum, QVector<QPair<int, int>>& ranges)
+{
+	if (end - begin <= brickZoneNum)
+	{
+		ranges.append({ begin, end });
+		return;
+	}
+
+	Bound centriodBound;
+	for (int i = begin; i < end; ++i)
+	{
+		centriodBound.combine(zones.centriod(zoneIndices[i]));
+	}
+
+	int dim = centriodBound.maxDim();
+	int mid = (begin + end) / 2;
+	std::nth_element(zoneIndices.begin() + begin, zoneIndices.begin() + mid, zoneIndices.begin() + end,
+		[&zones, dim](uint32_t a, uint32_t b)
+	{
+		return zones.centriod(a)[dim] < zones.centriod(b)[dim];
+	});
+
+	partitionZones(zones, zoneIndices, begin, mid, brickZoneNum, ranges);
+	partitionZones(zones, zoneIndices, mid, end, brickZoneNum, ranges);
+}
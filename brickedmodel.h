@@ -0,0 +1,107 @@
+#pragma once
+
+#include "modelcache.h"
+#include <QCache>
+
+/**
+	ֿģࣨԪռ仮Ϊɿ.nmvbricksļפڴֻпİΧйɵĶbvh
+	СʰȡزʱĿ飬ڴLRṶ
+*/
+
+const quint32 kBrickFileMagic = 0x4B52424E;
+const int kBrickZoneNum = 8192;
+const int kDefaultBrickCacheMB = 256;
+
+struct CachedBrick
+{
+	QVector3D boundMin;
+	QVector3D boundMax;
+	quint64 groupMask;
+	qint64 offset;
+	qint32 zoneNum;
+	qint32 zoneOffset;
+};
+
+struct BrickTreeNode
+{
+	Bound bound;
+	quint64 groupMask = kAllZoneGroups;
+	int children[2] = { -1, -1 };
+	int brick = -1;
+};
+
+struct BrickStats
+{
+	int requestNum = 0;
+	int hitNum = 0;
+	int pageFaultNum = 0;
+	int evictNum = 0;
+	qint64 readBytes = 0;
+	qint64 pageInTime = 0;		// 
+
+	double hitRate() const;
+};
+
+class BrickedModel
+{
+public:
+	BrickedModel(int maxMemoryMB = kDefaultBrickCacheMB);
+	~BrickedModel();
+
+	static QString brickFileName(const QString& fileName);
+	static bool build(const QString& fileName, const ZoneSet& zones, int brickZoneNum = kBrickZoneNum);
+
+	bool open(const QString& fileName);
+	void close();
+	bool isOpen() const;
+	int getZoneNum() const;
+	int getBrickNum() const;
+	Bound getBound() const;
+	bool readZoneNodes(QVector<int>& zoneNodeOffsets, QVector<uint32_t>& zoneNodes);
+
+	// ڵ仯ѶĿ´ʹʱ»浥Ԫڵֵ
+	void invalidateValues();
+
+	void clipZones(const Plane& plane, const NodeAttributes& nodeAttributes, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices, quint64 groupMask = kAllZoneGroups);
+	void pickZone(const Ray& ray, const NodeAttributes& nodeAttributes, QVector<uint32_t>& pickIndices, bool pickZoneMode = true, quint64 groupMask = kAllZoneGroups);
+	void sampleUniformGrids(const NodeAttributes& nodeAttributes, UniformGrids& uniformGrids);
+	void resampleUniformGrids(const NodeAttributes& nodeAttributes, UniformGrids& uniformGrids);
+
+	void setMemoryBudget(int maxMemoryMB);
+	int getMemoryUsage() const;	// KB
+	BrickStats getStats() const;
+	void printStats() const;
+
+private:
+	struct Brick
+	{
+		ZoneSet zones;
+		LinearBVH tree;
+		int valueVersion = 0;
+
+		int cacheCost() const;
+	};
+
+	Brick* brick(int index, const QVector<float>& nodeValues);
+	Brick* pageIn(int index);
+	void buildBrickTree();
+	int buildBrickTree(QVector<int>& brickIndices, int begin, int end);
+	void findBricks(int node, const Plane& plane, quint64 groupMask, QVector<int>& hitBricks);
+	void findBricks(int node, const Ray& ray, quint64 groupMask, QVector<int>& hitBricks);
+	void findBricks(int node, const QVector3D& point, QVector<int>& hitBricks) const;
+
+	static void partitionZones(const ZoneSet& zones, QVector<uint32_t>& zoneIndices, int begin, int end, int brickZoneNum, QVector<QPair<int, int>>& ranges);
+
+	ModelCache cache;
+	qint64 tableOffset;
+	qint64 edgeNum;
+	QVector<CachedBrick> bricks;
+	QVector<uint32_t> brickZones;
+	QVector<BrickTreeNode> brickTreeNodes;
+	QVector<int> zoneBricks;
+	QVector<int> zoneSlots;
+	int valueVersion;
+
+	QCache<int, Brick> brickCache;
+	BrickStats stats;
+};
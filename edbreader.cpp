@@ -0,0 +1,494 @@
+#include "edbreader.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+// ʱֻȡλֶΣӦ䡢ӦֶResultFieldStore״ʹʱȡ
+static const char* kResultColumns = "NODEID, USUM, UX, UY, UZ";
+
+// EDBReaderԱʵ
+bool EDBReader::load(const QString& fileName, EDBModel& model, int threadCount)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	if (threadCount <= 0)
+	{
+		threadCount = QThread::idealThreadCount();
+	}
+
+	// ͳƸԤֱд
+	int nodeNum = 0;
+	int zoneNum = 0;
+	int facetNum = 0;
+	bool result = withConnection(fileName, [&](QSqlDatabase& db) {
+		nodeNum = countRows(db, "NODES");
+		zoneNum = countRows(db, "ELEMENTS");
+		facetNum = countRows(db, "EXTERIOR");
+		return nodeNum >= 0 && zoneNum >= 0 && facetNum >= 0;
+	});
+	if (!result)
+	{
+		return false;
+	}
+
+	model.nodeAttributes.resize(nodeNum);
+	model.valueRange.reset();
+	model.zoneTypes.clear();
+	model.zones.resize(zoneNum);
+	model.facets.resize(facetNum);
+
+	// NODESRESULTSֱд鼰λֶ飬ͻ
+	QVector3D* positions = model.nodeAttributes.positions.data();
+	QVector<std::function<bool(QSqlDatabase&)>> tasks = {
+		[positions, nodeNum](QSqlDatabase& db) { return readNodes(db, positions, nodeNum); },
+		[&model](QSqlDatabase& db) { return readResults(db, model.nodeAttributes, model.valueRange); },
+		[&model](QSqlDatabase& db) { return readZoneTypes(db, model.zoneTypes) && readZones(db, model.zones); },
+		[&model](QSqlDatabase& db) { return readFacets(db, model.facets); }
+	};
+
+	threadCount = qMin(threadCount, tasks.count());
+	if (threadCount > 1)
+	{
+		// ÿűʹöֻ
+		QThreadPool threadPool;
+		threadPool.setMaxThreadCount(threadCount);
+		QVector<QFuture<bool>> futures;
+		for (const std::function<bool(QSqlDatabase&)>& task : tasks)
+		{
+			futures.append(QtConcurrent::run(&threadPool, [&fileName, &task]() {
+				return withConnection(fileName, task);
+			}));
+		}
+		for (QFuture<bool>& future : futures)
+		{
+			result = future.result() && result;
+		}
+	}
+	else
+	{
+		result = withConnection(fileName, [&tasks](QSqlDatabase& db) {
+			for (const std::function<bool(QSqlDatabase&)>& task : tasks)
+			{
+				if (!task(db))
+				{
+					return false;
+				}
+			}
+			return true;
+		});
+	}
+
+	qint64 readTime = qMax(profileTimer.elapsed(), (qint64)1);
+	qint64 rowNum = (qint64)nodeNum * 2 + zoneNum + facetNum;
+	qDebug() << "read edb time:" << readTime << "threads:" << threadCount << "rows/s:" << rowNum * 1000 / readTime;
+	return result;
+}
+
+bool EDBReader::loadLegacy(const QString& fileName, EDBModel& model)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	model.valueRange.reset();
+	bool result = withConnection(fileName, [&model](QSqlDatabase& db) {
+		return readLegacy(db, model);
+	});
+
+	qDebug() << "read edb (legacy) time:" << profileTimer.elapsed();
+	return result;
+}
+
+void EDBReader::benchmark(const QString& fileName)
+{
+	QElapsedTimer timer;
+	timer.start();
+	EDBModel legacyModel;
+	if (!loadLegacy(fileName, legacyModel))
+	{
+		qDebug() << "edb benchmark: failed to read" << fileName;
+		return;
+	}
+	qint64 legacyTime = qMax(timer.elapsed(), (qint64)1);
+	qDebug() << "edb benchmark nodes:" << legacyModel.nodeAttributes.count() << "zones:" << legacyModel.zones.count()
+		<< "facets:" << legacyModel.facets.count() << "legacy time:" << legacyTime;
+
+	// ӴжȡӲжȡֱԭʽԱ
+	const int threadCounts[2] = { 1, 0 };
+	for (int threadCount : threadCounts)
+	{
+		EDBModel model;
+		timer.restart();
+		bool result = load(fileName, model, threadCount);
+		qint64 time = qMax(timer.elapsed(), (qint64)1);
+		qDebug() << "edb benchmark" << (threadCount == 1 ? "serial" : "parallel") << "time:" << time
+			<< "speedup:" << (double)legacyTime / time << "identical:" << (result && isSameModel(legacyModel, model));
+	}
+}
+
+bool EDBReader::readResultField(const QString& fileName, const QString& column, int nodeNum, QVector<float>& values)
+{
+	values.fill(0.0f, nodeNum);
+	return withConnection(fileName, [&column, nodeNum, &values](QSqlDatabase& db) {
+		QSqlQuery query(db);
+		query.setForwardOnly(true);
+		if (!query.exec(QString("SELECT NODEID, %1 FROM RESULTS").arg(column)))
+		{
+			return false;
+		}
+
+		float* data = values.data();
+		while (query.next())
+		{
+			int index = query.value(0).toInt() - 1;
+			if (index < 0 || index >= nodeNum)
+			{
+				return false;
+			}
+			data[index] = query.value(1).toFloat();
+		}
+		return true;
+	});
+}
+
+bool EDBReader::withConnection(const QString& fileName, const std::function<bool(QSqlDatabase&)>& func)
+{
+	// ֻڴ߳ʹãƳ
+	static QAtomicInt connectionID;
+	const QString connectionName = QString("EDBReader%1").arg(connectionID.fetchAndAddRelaxed(1));
+	bool result = false;
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+		db.setDatabaseName(fileName);
+		db.setConnectOptions("QSQLITE_OPEN_READONLY");
+		if (db.open())
+		{
+			result = func(db);
+			db.close();
+		}
+		else
+		{
+			qDebug() << "Failed to open database: " << fileName;
+		}
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+	return result;
+}
+
+int EDBReader::countRows(QSqlDatabase& db, const QString& table)
+{
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec(QString("SELECT COUNT(*) FROM %1").arg(table)) || !query.next())
+	{
+		return -1;
+	}
+	return query.value(0).toInt();
+}
+
+bool EDBReader::readNodes(QSqlDatabase& db, QVector3D* positions, int nodeNum)
+{
+	// ѯڵռ꣬˳д
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec("SELECT X, Y, Z FROM NODES"))
+	{
+		return false;
+	}
+
+	int index = 0;
+	while (query.next())
+	{
+		if (index >= nodeNum)
+		{
+			return false;
+		}
+
+		QVector3D& position = positions[index++];
+		for (int i = 0; i < 3; ++i)
+		{
+			position[i] = query.value(i).toFloat();
+		}
+	}
+	return index == nodeNum;
+}
+
+bool EDBReader::readResults(QSqlDatabase& db, NodeAttributes& nodeAttributes, ValueRange& valueRange)
+{
+	// ѯÿڵӦļֵ
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec(QString("SELECT %1 FROM RESULTS").arg(kResultColumns)))
+	{
+		return false;
+	}
+
+	while (query.next())
+	{
+		if (!decodeResult(query, nodeAttributes, valueRange))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool EDBReader::readZoneTypes(QSqlDatabase& db, QVector<int>& zoneTypes)
+{
+	// ѯԪϢ
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec("SELECT ID FROM ELETYPE"))
+	{
+		return false;
+	}
+
+	while (query.next())
+	{
+		zoneTypes.append(query.value(0).toInt());
+	}
+	return true;
+}
+
+bool EDBReader::readZones(QSqlDatabase& db, QVector<Zone>& zones)
+{
+	// ѯԪڵԪ8ڵ
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec("SELECT TYPE, NUM, N1, N2, N3, N4, N5, N6, N7, N8 FROM ELEMENTS"))
+	{
+		return false;
+	}
+
+	Zone* zoneData = zones.data();
+	int index = 0;
+	while (query.next())
+	{
+		if (index >= zones.count() || !decodeZone(query, 0, zoneData[index++]))
+		{
+			return false;
+		}
+	}
+	return index == zones.count();
+}
+
+bool EDBReader::readFacets(QSqlDatabase& db, QVector<Facet>& facets)
+{
+	// ѯģӦĽڵϢ
+	QSqlQuery query(db);
+	query.setForwardOnly(true);
+	if (!query.exec("SELECT ELEMID, FACETID, NUM, N1, N2, N3, N4 FROM EXTERIOR"))
+	{
+		return false;
+	}
+
+	Facet* facetData = facets.data();
+	int index = 0;
+	while (query.next())
+	{
+		if (index >= facets.count() || !decodeFacet(query, 0, facetData[index++]))
+		{
+			return false;
+		}
+	}
+	return index == facets.count();
+}
+
+bool EDBReader::readLegacy(QSqlDatabase& db, EDBModel& model)
+{
+	// ѯڵռ
+	QSqlQuery query("SELECT * FROM NODES", db);
+	while (query.next())
+	{
+		QVector3D position;
+		for (int i = 0; i < 3; ++i)
+		{
+			position[i] = query.value(i + 1).toFloat();
+		}
+		model.nodeAttributes.positions.append(position);
+	}
+	model.nodeAttributes.resize(model.nodeAttributes.positions.count());
+
+	// ѯÿڵӦļֵ
+	query.exec("SELECT * FROM RESULTS");
+	while (query.next())
+	{
+		if (!decodeResult(query, model.nodeAttributes, model.valueRange))
+		{
+			return false;
+		}
+	}
+
+	// ѯԪϢ
+	query.exec("SELECT * FROM ELETYPE");
+	while (query.next())
+	{
+		model.zoneTypes.append(query.value(0).toInt());
+	}
+
+	// ѯԪڵ
+	query.exec("SELECT * FROM ELEMENTS");
+	while (query.next())
+	{
+		Zone zone;
+		if (!decodeZone(query, 1, zone))
+		{
+			return false;
+		}
+		model.zones.append(zone);
+	}
+
+	// ѯģӦĽڵϢ
+	query.exec("SELECT * FROM EXTERIOR");
+	while (query.next())
+	{
+		Facet facet;
+		if (!decodeFacet(query, 1, facet))
+		{
+			return false;
+		}
+		model.facets.append(facet);
+	}
+	return true;
+}
+
+bool EDBReader::decodeResult(const QSqlQuery& query, NodeAttributes& nodeAttributes, ValueRange& valueRange)
+{
+	int index = query.value(0).toInt() - 1;
+	if (index < 0 || index >= nodeAttributes.count())
+	{
+		return false;
+	}
+
+	// ֻλֶΣɷʽSELECT *˳ͬкԣ
+	int i = 1;
+	float totalDeformation = query.value(i++).toFloat();
+	QVector3D deformation;
+	for (int j = 0; j < 3; ++j)
+	{
+		deformation[j] = query.value(i++).toFloat();
+	}
+
+	nodeAttributes.fields[FieldUSUM][index] = totalDeformation;
+	nodeAttributes.fields[FieldUX][index] = deformation[0];
+	nodeAttributes.fields[FieldUY][index] = deformation[1];
+	nodeAttributes.fields[FieldUZ][index] = deformation[2];
+
+	valueRange.minTotalDeformation = qMin(valueRange.minTotalDeformation, totalDeformation);
+	valueRange.maxTotalDeformation = qMax(valueRange.maxTotalDeformation, totalDeformation);
+	valueRange.minDeformation = qMinVec3(valueRange.minDeformation, deformation);
+	valueRange.maxDeformation = qMaxVec3(valueRange.maxDeformation, deformation);
+	return true;
+}
+
+bool EDBReader::decodeZone(const QSqlQuery& query, int column, Zone& zone)
+{
+	int type = query.value(column).toInt();
+	if (type == 1)
+	{
+		zone.type = Brick;
+	}
+	else if (type == 2)
+	{
+		zone.type = Tetrahedron;
+	}
+	else if (type == 3)
+	{
+		// f3gridģ͵EDBԪ
+		zone.type = Wedge;
+	}
+	else
+	{
+		return false;
+	}
+
+	zone.vertexNum = query.value(column + 1).toInt();
+	if (zone.vertexNum < 0 || zone.vertexNum > 8)
+	{
+		return false;
+	}
+
+	static const int orders[8] = { 0, 1, 3, 4, 2, 7, 5, 6 };
+	for (int i = 0; i < zone.vertexNum; ++i)
+	{
+		int o = zone.type == Brick ? orders[i] : i;
+		zone.vertices[i] = query.value(column + 2 + o).toInt() - 1;
+	}
+	return true;
+}
+
+bool EDBReader::decodeFacet(const QSqlQuery& query, int column, Facet& facet)
+{
+	facet.elemID = query.value(column).toInt() - 1;
+	facet.facetID = query.value(column + 1).toInt() - 1;
+	facet.num = query.value(column + 2).toInt();
+	if (facet.num == 4)
+	{
+		facet.type = Q4;
+	}
+	else if (facet.num == 3)
+	{
+		facet.type = T3;
+	}
+	else if (facet.num < 0 || facet.num > 4)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < facet.num; ++i)
+	{
+		facet.indices[i] = query.value(column + 3 + i).toInt() - 1;
+	}
+	return true;
+}
+
+bool EDBReader::isSameModel(const EDBModel& model0, const EDBModel& model1)
+{
+	if (model0.nodeAttributes.count() != model1.nodeAttributes.count() || model0.zoneTypes != model1.zoneTypes ||
+		model0.zones.count() != model1.zones.count() || model0.facets.count() != model1.facets.count())
+	{
+		return false;
+	}
+
+	const NodeAttributes& nodeAttributes0 = model0.nodeAttributes;
+	const NodeAttributes& nodeAttributes1 = model1.nodeAttributes;
+	if (memcmp(nodeAttributes0.positions.constData(), nodeAttributes1.positions.constData(), nodeAttributes0.count() * sizeof(QVector3D)) != 0)
+	{
+		return false;
+	}
+	for (int f = FieldUSUM; f <= FieldUZ; ++f)
+	{
+		if (memcmp(nodeAttributes0.fields[f].constData(), nodeAttributes1.fields[f].constData(), nodeAttributes0.count() * sizeof(float)) != 0)
+		{
+			return false;
+		}
+	}
+
+	for (int i = 0; i < model0.zones.count(); ++i)
+	{
+		const Zone& zone0 = model0.zones[i];
+		const Zone& zone1 = model1.zones[i];
+		if (zone0.type != zone1.type || zone0.vertexNum != zone1.vertexNum ||
+			memcmp(zone0.vertices, zone1.vertices, zone0.vertexNum * sizeof(quint32)) != 0)
+		{
+			return false;
+		}
+	}
+
+	for (int i = 0; i < model0.facets.count(); ++i)
+	{
+		const Facet& facet0 = model0.facets[i];
+		const Facet& facet1 = model1.facets[i];
+		if (facet0.type != facet1.type || facet0.elemID != facet1.elemID || facet0.facetID != facet1.facetID ||
+			facet0.num != facet1.num || memcmp(facet0.indices, facet1.indices, facet0.num * sizeof(quint32)) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
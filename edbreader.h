@@ -0,0 +1,46 @@
+#pragma once
+
+#include "geotypes.h"
+#include <functional>
+
+class QSqlDatabase;
+class QSqlQuery;
+
+/**
+	EDBSQLiteģݶȡֻࣨѯҪУݱʹöӲжȡ
+*/
+
+struct EDBModel
+{
+	NodeAttributes nodeAttributes;
+	ValueRange valueRange;
+	QVector<int> zoneTypes;
+	QVector<Zone> zones;
+	QVector<Facet> facets;
+};
+
+class EDBReader
+{
+public:
+	static bool load(const QString& fileName, EDBModel& model, int threadCount = 0);
+	// ԭеSELECT *жȡʽܶԱ
+	static bool loadLegacy(const QString& fileName, EDBModel& model);
+	static void benchmark(const QString& fileName);
+	// ڵŶȡеĵ
+	static bool readResultField(const QString& fileName, const QString& column, int nodeNum, QVector<float>& values);
+
+private:
+	static bool withConnection(const QString& fileName, const std::function<bool(QSqlDatabase&)>& func);
+	static int countRows(QSqlDatabase& db, const QString& table);
+	static bool readNodes(QSqlDatabase& db, QVector3D* positions, int nodeNum);
+	static bool readResults(QSqlDatabase& db, NodeAttributes& nodeAttributes, ValueRange& valueRange);
+	static bool readZoneTypes(QSqlDatabase& db, QVector<int>& zoneTypes);
+	static bool readZones(QSqlDatabase& db, QVector<Zone>& zones);
+	static bool readFacets(QSqlDatabase& db, QVector<Facet>& facets);
+	static bool readLegacy(QSqlDatabase& db, EDBModel& model);
+
+	static bool decodeResult(const QSqlQuery& query, NodeAttributes& nodeAttributes, ValueRange& valueRange);
+	static bool decodeZone(const QSqlQuery& query, int column, Zone& zone);
+	static bool decodeFacet(const QSqlQuery& query, int column, Facet& facet);
+	static bool isSameModel(const EDBModel& model0, const EDBModel& model1);
+};
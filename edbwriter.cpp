@@ -0,0 +1,488 @@
+#include "edbwriter.h"
+#include "resultfieldstore.h"
+#include <QDebug>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+// ÿ󶨵
+static const int kBatchRowNum = 8192;
+
+// ExportTable˳һµݱ
+static const char* kTableNames[ExportTableNum] = { "NODES", "RESULTS", "ELETYPE", "ELEMENTS", "EXTERIOR", "FACETS", "ELEMEDGES", "RSTTYPE" };
+
+// EDBWriterԱʵ
+EDBWriter::EDBWriter(QObject* parent) : QObject(parent)
+{
+	currentTable = NodeTable;
+	tableRowNum = 0;
+	writtenRowNum = 0;
+	lastProgress = -1;
+}
+
+bool EDBWriter::save(const QString& fileName, const NodeAttributes& nodeAttributes, const ZoneSet& zones, const QVector<Facet>& exteriorFacets, ResultFieldStore* resultFields)
+{
+	// дʱļɹ滻Ŀļpage_sizeֻԿݿЧ
+	const QString tempFileName = fileName + ".part";
+	if (QFile::exists(tempFileName) && !QFile::remove(tempFileName))
+	{
+		qDebug() << "Failed to remove file: " << tempFileName;
+		return false;
+	}
+
+	const QString connectionName = "EDBWriter";
+	bool result = false;
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+		db.setDatabaseName(tempFileName);
+		if (db.open())
+		{
+			result = writeTables(db, nodeAttributes, zones, exteriorFacets, resultFields);
+			db.close();
+		}
+		else
+		{
+			qDebug() << "Failed to open database: " << tempFileName;
+		}
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	if (result && QFile::exists(fileName) && !QFile::remove(fileName))
+	{
+		qDebug() << "Failed to remove file: " << fileName;
+		result = false;
+	}
+	if (result)
+	{
+		result = QFile::rename(tempFileName, fileName);
+	}
+	if (!result)
+	{
+		QFile::remove(tempFileName);
+	}
+	return result;
+}
+
+void EDBWriter::cancel()
+{
+	canceled.store(1);
+}
+
+bool EDBWriter::isCanceled() const
+{
+	return canceled.load() != 0;
+}
+
+QString EDBWriter::getTableName(int table)
+{
+	switch (table)
+	{
+	case NodeTable:
+		return QStringLiteral("ڵ");
+	case ResultTable:
+		return QStringLiteral("");
+	case ZoneTypeTable:
+		return QStringLiteral("Ԫ");
+	case ZoneTable:
+		return QStringLiteral("Ԫ");
+	case ExteriorTable:
+		return QStringLiteral("");
+	case ZoneFacetTable:
+		return QStringLiteral("Ԫ");
+	case ZoneEdgeTable:
+		return QStringLiteral("Ԫ");
+	case ResultTypeTable:
+		return QStringLiteral("");
+	default:
+		return QString();
+	}
+}
+
+bool EDBWriter::writeTables(QSqlDatabase& db, const NodeAttributes& nodeAttributes, const ZoneSet& zones, const QVector<Facet>& exteriorFacets, ResultFieldStore* resultFields)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	// дʱرͬ־ڴУԿɻع
+	QSqlQuery query(db);
+	query.exec("PRAGMA page_size = 65536");
+	query.exec("PRAGMA journal_mode = MEMORY");
+	query.exec("PRAGMA synchronous = OFF");
+	query.exec("PRAGMA temp_store = MEMORY");
+	query.exec("PRAGMA cache_size = -65536");
+	query.finish();
+
+	db.transaction();
+	bool result = writeNodes(db, nodeAttributes) &&
+		writeResults(db, nodeAttributes, resultFields) &&
+		writeZoneTypes(db) &&
+		writeZones(db, zones) &&
+		writeExteriorFacets(db, exteriorFacets) &&
+		writeZoneFacets(db, zones) &&
+		writeZoneEdges(db, zones) &&
+		writeResultTypes(db);
+	if (!result)
+	{
+		// ȡʱعʱļɾ
+		if (!isCanceled())
+		{
+			qDebug() << "Failed to export database: " << db.lastError().text();
+		}
+		db.rollback();
+		return false;
+	}
+
+	result = db.commit();
+	qDebug() << "export edb time:" << profileTimer.elapsed();
+	return result;
+}
+
+bool EDBWriter::writeNodes(QSqlDatabase& db, const NodeAttributes& nodeAttributes)
+{
+	// ڵռ
+	QSqlQuery query(db);
+	if (!prepareTable(query, NodeTable, "ID INTEGER primary key, X REAL, Y REAL, Z REAL", 4, nodeAttributes.count()))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns(4);
+	for (int i = 0; i < nodeAttributes.count(); ++i)
+	{
+		const QVector3D& position = nodeAttributes.positions[i];
+		columns[0].append(i + 1);
+		columns[1].append(position[0]);
+		columns[2].append(position[1]);
+		columns[3].append(position[2]);
+		if (!insertRows(query, columns, false))
+		{
+			return false;
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeResults(QSqlDatabase& db, const NodeAttributes& nodeAttributes, ResultFieldStore* resultFields)
+{
+	// ÿڵӦļֵ
+	QSqlQuery query(db);
+	if (!prepareTable(query, ResultTable, "NODEID INTEGER primary key, "
+		"USUM REAL, UX REAL, UY REAL, UZ REAL, "
+		"EPTOX REAL, EPTOY REAL, EPTOZ REAL, "
+		"EPTOXY REAL, EPTOYZ REAL, EPTOXZ REAL, "
+		"S1 REAL, S2 REAL, S3 REAL, "
+		"SX REAL, SY REAL, SZ REAL, "
+		"SXY REAL, SYZ REAL, SXZ REAL", 20, nodeAttributes.count()))
+	{
+		return false;
+	}
+
+	// λʱ䲽仯ȡԽڵݣֶδʽ洢ȡȡʧʱȡڵѼصֶ
+	QVector<QVector<float>> fieldValues(ResultFieldTypeNum);
+	for (int f = 0; f < ResultFieldTypeNum; ++f)
+	{
+		if (f > FieldUZ && resultFields && resultFields->field(f, fieldValues[f]) && fieldValues[f].count() == nodeAttributes.count())
+		{
+			continue;
+		}
+
+		if (nodeAttributes.hasField(f))
+		{
+			fieldValues[f] = nodeAttributes.fields[f];
+		}
+		else
+		{
+			fieldValues[f].fill(0.0f, nodeAttributes.count());
+		}
+	}
+
+	QVector<QVariantList> columns(20);
+	for (int i = 0; i < nodeAttributes.count(); ++i)
+	{
+		columns[0].append(i + 1);
+		for (int f = 0; f < ResultFieldTypeNum; ++f)
+		{
+			columns[f + 1].append(fieldValues[f][i]);
+		}
+		if (!insertRows(query, columns, false))
+		{
+			return false;
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeZoneTypes(QSqlDatabase& db)
+{
+	// ԪϢ
+	QSqlQuery query(db);
+	if (!prepareTable(query, ZoneTypeTable, "ID INTEGER primary key, TYPE INTEGER, TYPENAME TEXT", 3, 2))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns = {
+		{ 1, 2 },
+		{ 0, 4 },
+		{ "185", "154" }
+	};
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeZones(QSqlDatabase& db, const ZoneSet& zones)
+{
+	// Ԫڵ
+	QString columnDefs("ID INTEGER primary key, TYPE INTEGER, NUM INTEGER");
+	for (int i = 0; i < 50; ++i)
+	{
+		columnDefs += QString(", N%1 INTEGER").arg(i + 1);
+	}
+
+	QSqlQuery query(db);
+	if (!prepareTable(query, ZoneTable, columnDefs, 53, zones.count()))
+	{
+		return false;
+	}
+
+	static const int reorders[8] = { 0, 1, 4, 2, 3, 6, 7, 5 };
+	QVector<QVariantList> columns(53);
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		ZoneType type = zones.type(i);
+		int vertexNum = zones.vertexNum(i);
+		const quint32* vertices = zones.zoneVertices(i);
+		columns[0].append(i + 1);
+		columns[1].append((int)type);
+		columns[2].append(vertexNum);
+		for (int j = 0; j < 50; ++j)
+		{
+			int index = 0;
+			if (j < vertexNum)
+			{
+				index = vertices[type == Brick ? reorders[j] : j] + 1;
+			}
+			columns[j + 3].append(index);
+		}
+		if (!insertRows(query, columns, false))
+		{
+			return false;
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeExteriorFacets(QSqlDatabase& db, const QVector<Facet>& exteriorFacets)
+{
+	// ģӦĽڵϢ
+	QString columnDefs("ID INT primary key, ELEMID INT, FACETID INT, NUM INT");
+	for (int i = 0; i < 50; ++i)
+	{
+		columnDefs += QString(", N%1 INT").arg(i + 1);
+	}
+
+	QSqlQuery query(db);
+	if (!prepareTable(query, ExteriorTable, columnDefs, 54, exteriorFacets.count()))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns(54);
+	for (int i = 0; i < exteriorFacets.count(); ++i)
+	{
+		const Facet& facet = exteriorFacets[i];
+		columns[0].append(i + 1);
+		columns[1].append(facet.elemID + 1);
+		columns[2].append(facet.facetID + 1);
+		columns[3].append(facet.num);
+		for (int j = 0; j < 50; ++j)
+		{
+			columns[j + 4].append(j < facet.num ? (int)facet.indices[j] + 1 : 0);
+		}
+		if (!insertRows(query, columns, false))
+		{
+			return false;
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeZoneFacets(QSqlDatabase& db, const ZoneSet& zones)
+{
+	// ԪбӦĽڵϢ
+	QString columnDefs("ID INTEGER primary key, ELEMID INTEGER, NUM INTEGER");
+	for (int i = 0; i < 50; ++i)
+	{
+		columnDefs += QString(", N%1 INTEGER").arg(i + 1);
+	}
+
+	int zoneFacetNum = 0;
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		zoneFacetNum += zones.facetNum(i);
+	}
+
+	QSqlQuery query(db);
+	if (!prepareTable(query, ZoneFacetTable, columnDefs, 53, zoneFacetNum))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns(53);
+	int facetID = 0;
+	for (int z = 0; z < zones.count(); ++z)
+	{
+		for (int f = 0; f < zones.facetNum(z); ++f)
+		{
+			Facet facet = zones.facet(z, f);
+			columns[0].append(++facetID);
+			columns[1].append(facet.elemID + 1);
+			columns[2].append(facet.num);
+			for (int i = 0; i < 50; ++i)
+			{
+				columns[i + 3].append(i < facet.num ? (int)facet.indices[i] + 1 : 0);
+			}
+			if (!insertRows(query, columns, false))
+			{
+				return false;
+			}
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeZoneEdges(QSqlDatabase& db, const ZoneSet& zones)
+{
+	// ԪϢÿͨ
+	QString columnDefs("ID INTEGER primary key, ELEMID INTEGER, EDGENUM INTEGER");
+	for (int i = 0; i < 20; ++i)
+	{
+		columnDefs += QString(", startIdx%1 INTEGER, endIdx%1 INTEGER").arg(i + 1);
+	}
+
+	QSqlQuery query(db);
+	if (!prepareTable(query, ZoneEdgeTable, columnDefs, 43, zones.count()))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns(43);
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		int edgeNum = zones.edgeNum(i);
+		columns[0].append(i + 1);
+		columns[1].append(i + 1);
+		columns[2].append(edgeNum);
+		for (int j = 0; j < 20; ++j)
+		{
+			Edge edge = j < edgeNum ? zones.edge(i, j) : Edge{};
+			columns[j * 2 + 3].append(j < edgeNum ? (int)edge.vertices[0] + 1 : 0);
+			columns[j * 2 + 4].append(j < edgeNum ? (int)edge.vertices[1] + 1 : 0);
+		}
+		if (!insertRows(query, columns, false))
+		{
+			return false;
+		}
+	}
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::writeResultTypes(QSqlDatabase& db)
+{
+	// ͡Ʊ
+	QSqlQuery query(db);
+	if (!prepareTable(query, ResultTypeTable, "ID INTEGER primary key, Code TEXT, Name TEXT, Type TEXT, Unit TEXT", 5, 19))
+	{
+		return false;
+	}
+
+	QVector<QVariantList> columns(5);
+	auto addResultType = [&columns](const QString& code, const QString& name, const QString& type, const QString& unit) {
+		columns[0].append(columns[0].count() + 1);
+		columns[1].append(code);
+		columns[2].append(name);
+		columns[3].append(type);
+		columns[4].append(unit);
+	};
+	addResultType("USUM", QStringLiteral("HDY_λ"), "Total Deformation", "m");
+	addResultType("UX", QStringLiteral("HDY_Xλ"), "Directional Deformation(X Axis)", "m");
+	addResultType("UY", QStringLiteral("HDY_Yλ"), "Directional Deformation(Y Axis)", "m");
+	addResultType("UZ", QStringLiteral("HDY_Zλ"), "Directional Deformation(Z Axis)", "m");
+	addResultType("EPTOX", QStringLiteral("HDY_XӦ"), "Normal Elastic Strain(X Axis)", "m/m");
+	addResultType("EPTOY", QStringLiteral("HDY_YӦ"), "Normal Elastic Strain(Y Axis)", "m/m");
+	addResultType("EPTOZ", QStringLiteral("HDY_ZӦ"), "Normal Elastic Strain(Z Axis)", "m/m");
+	addResultType("EPTOXY", QStringLiteral("HDY_XYƽӦ"), "Shear Elastic Strain(XY Plane)", "m/m");
+	addResultType("EPTOYZ", QStringLiteral("HDY_YZƽӦ"), "Shear Elastic Strain(YZ Plane)", "m/m");
+	addResultType("EPTOXZ", QStringLiteral("HDY_XZƽӦ"), "Shear Elastic Strain(XZ Plane)", "m/m");
+	addResultType("S1", QStringLiteral("HDY_Ӧ"), "Maximum Principal Stress", "Pa");
+	addResultType("S2", QStringLiteral("HDY_мӦ"), "Middle Principal Stress", "Pa");
+	addResultType("S3", QStringLiteral("HDY_СӦ"), "Minimum Principal Stress", "Pa");
+	addResultType("SX", QStringLiteral("HDY_XӦ"), "Normal Stress(X Axis)", "Pa");
+	addResultType("SY", QStringLiteral("HDY_YӦ"), "Normal Stress(Y Axis)", "Pa");
+	addResultType("SZ", QStringLiteral("HDY_ZӦ"), "Normal Stress(Z Axis)", "Pa");
+	addResultType("SXY", QStringLiteral("HDY_XYƽӦ"), "Shear Stress(XY Plane)", "Pa");
+	addResultType("SYZ", QStringLiteral("HDY_YZƽӦ"), "Shear Stress(YZ Plane)", "Pa");
+	addResultType("SXZ", QStringLiteral("HDY_XZƽӦ"), "Shear Stress(XZ Plane)", "Pa");
+	return insertRows(query, columns, true) && finishTable();
+}
+
+bool EDBWriter::prepareTable(QSqlQuery& query, ExportTable table, const QString& columns, int columnNum, int rowNum)
+{
+	currentTable = table;
+	tableRowNum = rowNum;
+	writtenRowNum = 0;
+	tableTimer.start();
+	emit onTableProgress(table, 0);
+
+	const QString tableName = kTableNames[table];
+	if (isCanceled() || !query.exec(QString("create table %1(%2)").arg(tableName, columns)))
+	{
+		return false;
+	}
+
+	QStringList placeholders;
+	for (int i = 0; i < columnNum; ++i)
+	{
+		placeholders.append("?");
+	}
+	return query.prepare(QString("INSERT INTO %1 VALUES(%2)").arg(tableName, placeholders.join(", ")));
+}
+
+bool EDBWriter::insertRows(QSqlQuery& query, QVector<QVariantList>& columns, bool flush)
+{
+	// ܹһдһа󶨣ִԤ
+	int rowNum = columns[0].count();
+	if (rowNum == 0 || (!flush && rowNum < kBatchRowNum))
+	{
+		return true;
+	}
+
+	for (int i = 0; i < columns.count(); ++i)
+	{
+		query.bindValue(i, columns[i]);
+	}
+	bool result = query.execBatch();
+	for (QVariantList& column : columns)
+	{
+		column.clear();
+	}
+
+	// ÿдȡȰٷֱȱ仯ʱŷź
+	writtenRowNum += rowNum;
+	int progress = tableRowNum > 0 ? (int)((qint64)writtenRowNum * 100 / tableRowNum) : 100;
+	int key = currentTable * 1000 + progress;
+	if (key != lastProgress)
+	{
+		lastProgress = key;
+		emit onTableProgress(currentTable, progress);
+	}
+	return result && !isCanceled();
+}
+
+bool EDBWriter::finishTable()
+{
+	qint64 time = tableTimer.elapsed();
+	qDebug() << "export table" << kTableNames[currentTable] << "rows:" << writtenRowNum << "time:" << time << "rows/s:" << writtenRowNum * 1000.0 / qMax(time, (qint64)1);
+	return !isCanceled();
+}
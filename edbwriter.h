@@ -0,0 +1,62 @@
+#ifndef EDBWRITER_H
+#define EDBWRITER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QVariant>
+
+#include "geotypes.h"
+
+class QSqlDatabase;
+class QSqlQuery;
+class ResultFieldStore;
+
+enum ExportTable
+{
+	NodeTable, ResultTable, ZoneTypeTable, ZoneTable, ExteriorTable, ZoneFacetTable, ZoneEdgeTable, ResultTypeTable, ExportTableNum
+};
+
+/**
+	EDBSQLiteģݵࣨÿűʹһԤINSERT䣬д룬ڹ߳У
+*/
+
+class EDBWriter : public QObject
+{
+	Q_OBJECT
+public:
+	EDBWriter(QObject* parent = nullptr);
+
+	bool save(const QString& fileName, const NodeAttributes& nodeAttributes, const ZoneSet& zones, const QVector<Facet>& exteriorFacets, ResultFieldStore* resultFields = nullptr);
+	void cancel();
+	bool isCanceled() const;
+
+	static QString getTableName(int table);
+
+signals:
+	void onTableProgress(int table, int progress);
+
+private:
+	bool writeTables(QSqlDatabase& db, const NodeAttributes& nodeAttributes, const ZoneSet& zones, const QVector<Facet>& exteriorFacets, ResultFieldStore* resultFields);
+	bool writeNodes(QSqlDatabase& db, const NodeAttributes& nodeAttributes);
+	bool writeResults(QSqlDatabase& db, const NodeAttributes& nodeAttributes, ResultFieldStore* resultFields);
+	bool writeZoneTypes(QSqlDatabase& db);
+	bool writeZones(QSqlDatabase& db, const ZoneSet& zones);
+	bool writeExteriorFacets(QSqlDatabase& db, const QVector<Facet>& exteriorFacets);
+	bool writeZoneFacets(QSqlDatabase& db, const ZoneSet& zones);
+	bool writeZoneEdges(QSqlDatabase& db, const ZoneSet& zones);
+	bool writeResultTypes(QSqlDatabase& db);
+
+	bool prepareTable(QSqlQuery& query, ExportTable table, const QString& columns, int columnNum, int rowNum);
+	bool insertRows(QSqlQuery& query, QVector<QVariantList>& columns, bool flush);
+	bool finishTable();
+
+	QAtomicInt canceled;
+	ExportTable currentTable;
+	int tableRowNum;
+	int writtenRowNum;
+	int lastProgress;
+	QElapsedTimer tableTimer;
+};
+
+#endif // EDBWRITER_H
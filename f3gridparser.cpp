@@ -0,0 +1,461 @@
+#include "f3gridparser.h"
+#include <QFile>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QFutureSynchronizer>
+#include <QtConcurrent>
+#include <charconv>
+#include <cstring>
+
+// F3GridParserԱʵ
+bool F3GridParser::load(const QString& fileName, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets, QStringList& groupNames, int threadCount)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	qint64 size = file.size();
+	uchar* data = file.map(0, size);
+	if (!data)
+	{
+		qDebug() << "Failed to map file: " << fileName;
+		return false;
+	}
+	const char* begin = reinterpret_cast<const char*>(data);
+	const char* end = begin + size;
+
+	if (threadCount <= 0)
+	{
+		threadCount = QThread::idealThreadCount();
+	}
+
+	bool result = false;
+	if (threadCount > 1)
+	{
+		result = parseParallel(begin, end, positions, zones, facets, threadCount);
+	}
+	else
+	{
+		// Ԥɨ¼Ԥ
+		F3GridRecordCount count = countRecords(begin, end);
+		positions.reserve(positions.count() + count.gridPointNum);
+		zones.reserve(zones.count() + count.zoneNum);
+		facets.reserve(facets.count() + count.faceNum);
+
+		result = parse(begin, end, positions, zones, facets);
+	}
+
+	// Ԫıв¼ͷ޷ֿڵԪɺ˳
+	result = result && parseZoneGroups(begin, end, zones, groupNames);
+	file.unmap(data);
+	file.close();
+
+	qint64 parseTime = qMax(profileTimer.elapsed(), (qint64)1);
+	qDebug() << "parse f3grid time:" << parseTime << "threads:" << threadCount << "throughput(MB/s):" << size / 1048576.0 / parseTime * 1000.0;
+	return result;
+}
+
+F3GridRecordCount F3GridParser::countRecords(const char* begin, const char* end)
+{
+	F3GridRecordCount count;
+	const char* p = begin;
+	while (p < end)
+	{
+		if (isRecordHeader(p, end, 'G'))
+		{
+			count.gridPointNum++;
+		}
+		else if (isRecordHeader(p, end, 'Z'))
+		{
+			count.zoneNum++;
+		}
+		else if (isRecordHeader(p, end, 'F'))
+		{
+			count.faceNum++;
+		}
+		p = findLineEnd(p, end) + 1;
+	}
+	return count;
+}
+
+bool F3GridParser::parse(const char* begin, const char* end, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets)
+{
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* lineEnd = findLineEnd(p, end);
+		if (isRecordHeader(p, lineEnd, 'G'))
+		{
+			QVector3D position;
+			if (!parseGridPoint(p + 1, lineEnd, position))
+			{
+				return false;
+			}
+			positions.append(position);
+		}
+		else if (isRecordHeader(p, lineEnd, 'Z'))
+		{
+			Zone zone;
+			if (!parseZone(p + 1, lineEnd, zone))
+			{
+				return false;
+			}
+			zones.append(zone);
+		}
+		else if (isRecordHeader(p, lineEnd, 'F'))
+		{
+			Facet facet;
+			if (!parseFace(p + 1, lineEnd, facet))
+			{
+				return false;
+			}
+			facets.append(facet);
+		}
+		p = lineEnd + 1;
+	}
+	return true;
+}
+
+bool F3GridParser::parseParallel(const char* begin, const char* end, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets, int threadCount)
+{
+	// ÿ̷ֿ߳飬ƽGRIDPOINTS/ZONES/FACESνٶȵĲ
+	QVector<F3GridChunk> chunks = splitChunks(begin, end, threadCount * 4);
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(threadCount);
+	QFutureSynchronizer<void> synchronizer;
+	for (F3GridChunk& chunk : chunks)
+	{
+		synchronizer.addFuture(QtConcurrent::run(&threadPool, [&chunk]() {
+			F3GridRecordCount count = countRecords(chunk.begin, chunk.end);
+			chunk.positions.reserve(count.gridPointNum);
+			chunk.zones.reserve(count.zoneNum);
+			chunk.facets.reserve(count.faceNum);
+			chunk.result = parse(chunk.begin, chunk.end, chunk.positions, chunk.zones, chunk.facets);
+		}));
+	}
+	synchronizer.waitForFinished();
+
+	F3GridRecordCount total;
+	for (const F3GridChunk& chunk : chunks)
+	{
+		if (!chunk.result)
+		{
+			return false;
+		}
+		total.gridPointNum += chunk.positions.count();
+		total.zoneNum += chunk.zones.count();
+		total.faceNum += chunk.facets.count();
+	}
+
+	// ֿļе˳ϲ봮нһ
+	positions.reserve(positions.count() + total.gridPointNum);
+	zones.reserve(zones.count() + total.zoneNum);
+	facets.reserve(facets.count() + total.faceNum);
+	for (const F3GridChunk& chunk : chunks)
+	{
+		positions.append(chunk.positions);
+		zones.append(chunk.zones);
+		facets.append(chunk.facets);
+	}
+	return true;
+}
+
+QVector<F3GridChunk> F3GridParser::splitChunks(const char* begin, const char* end, int chunkNum)
+{
+	// ֽֿ֣߽뵽β֤ÿ¼ֻһֿ
+	QVector<F3GridChunk> chunks;
+	chunks.reserve(chunkNum);
+	qint64 chunkSize = qMax((qint64)(end - begin) / qMax(chunkNum, 1), (qint64)1);
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* chunkEnd = end;
+		if (end - p > chunkSize)
+		{
+			chunkEnd = qMin(findLineEnd(p + chunkSize - 1, end) + 1, end);
+		}
+
+		F3GridChunk chunk;
+		chunk.begin = p;
+		chunk.end = chunkEnd;
+		chunks.append(chunk);
+		p = chunkEnd;
+	}
+	return chunks;
+}
+
+bool F3GridParser::parseZoneGroups(const char* begin, const char* end, QVector<Zone>& zones, QStringList& groupNames)
+{
+	// ԪÿSLOTֻһ飬ֻʹļеһSLOTķ
+	QString primarySlot;
+	QVector<int> zoneGroups(zones.count(), -1);
+	int group = -1;
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* lineEnd = findLineEnd(p, end);
+		if (lineEnd - p >= 6 && memcmp(p, "ZGROUP", 6) == 0)
+		{
+			QString name;
+			QString slot = QStringLiteral("Default");
+			const char* q = p + 6;
+			const char* token;
+			int length;
+			if (!parseName(q, lineEnd, name))
+			{
+				return false;
+			}
+			if (parseToken(q, lineEnd, token, length) && length == 4 && memcmp(token, "SLOT", 4) == 0 && !parseName(q, lineEnd, slot))
+			{
+				return false;
+			}
+
+			if (primarySlot.isEmpty())
+			{
+				primarySlot = slot;
+			}
+
+			group = -1;
+			if (slot == primarySlot)
+			{
+				group = groupNames.indexOf(name);
+				if (group < 0)
+				{
+					group = groupNames.count();
+					groupNames.append(name);
+				}
+			}
+		}
+		else if (p < lineEnd && (*p == '*' || isalpha((uchar)*p)))
+		{
+			// λؼֽǰ
+			group = -1;
+		}
+		else if (group >= 0)
+		{
+			int id;
+			const char* q = p;
+			while (parseInt(q, lineEnd, id))
+			{
+				if (id >= 1 && id <= zoneGroups.count())
+				{
+					zoneGroups[id - 1] = group;
+				}
+			}
+		}
+		p = lineEnd + 1;
+	}
+
+	if (groupNames.isEmpty())
+	{
+		return true;
+	}
+
+	// δĵԪNone
+	int noneGroup = -1;
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		if (zoneGroups[i] < 0)
+		{
+			if (noneGroup < 0)
+			{
+				noneGroup = groupNames.count();
+				groupNames.append(QStringLiteral("None"));
+			}
+			zoneGroups[i] = noneGroup;
+		}
+		zones[i].group = zoneGroups[i];
+	}
+	return true;
+}
+
+const char* F3GridParser::findLineEnd(const char* p, const char* end)
+{
+	const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+	return lineEnd ? lineEnd : end;
+}
+
+const char* F3GridParser::skipSpaces(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+	{
+		++p;
+	}
+	return p;
+}
+
+bool F3GridParser::parseToken(const char*& p, const char* end, const char*& token, int& length)
+{
+	p = skipSpaces(p, end);
+	token = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+	{
+		++p;
+	}
+	length = p - token;
+	return length > 0;
+}
+
+bool F3GridParser::parseName(const char*& p, const char* end, QString& name)
+{
+	// ƿɴ˫ţʱɰո
+	p = skipSpaces(p, end);
+	if (p < end && *p == '"')
+	{
+		const char* nameEnd = static_cast<const char*>(memchr(p + 1, '"', end - p - 1));
+		if (!nameEnd)
+		{
+			return false;
+		}
+		name = QString::fromUtf8(p + 1, nameEnd - p - 1);
+		p = nameEnd + 1;
+		return true;
+	}
+
+	const char* token;
+	int length;
+	if (!parseToken(p, end, token, length))
+	{
+		return false;
+	}
+	name = QString::fromUtf8(token, length);
+	return true;
+}
+
+bool F3GridParser::parseInt(const char*& p, const char* end, int& value)
+{
+	p = skipSpaces(p, end);
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+	p = result.ptr;
+	return true;
+}
+
+bool F3GridParser::parseUInt(const char*& p, const char* end, uint32_t& value)
+{
+	p = skipSpaces(p, end);
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+	p = result.ptr;
+	return true;
+}
+
+bool F3GridParser::parseFloat(const char*& p, const char* end, float& value)
+{
+	p = skipSpaces(p, end);
+	if (p < end && *p == '+')
+	{
+		++p;
+	}
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+	{
+		return false;
+	}
+	p = result.ptr;
+	return true;
+}
+
+bool F3GridParser::isRecordHeader(const char* p, const char* end, char header)
+{
+	// ¼ͷΪַZGROUP/FGROUPȹؼ
+	return end - p >= 2 && p[0] == header && (p[1] == ' ' || p[1] == '\t');
+}
+
+bool F3GridParser::parseGridPoint(const char* p, const char* end, QVector3D& position)
+{
+	int index;
+	return parseInt(p, end, index) &&
+		parseFloat(p, end, position[0]) &&
+		parseFloat(p, end, position[1]) &&
+		parseFloat(p, end, position[2]);
+}
+
+bool F3GridParser::parseZone(const char* p, const char* end, Zone& zone)
+{
+	const char* type;
+	int length;
+	int index;
+	if (!parseToken(p, end, type, length) || !parseInt(p, end, index))
+	{
+		return false;
+	}
+
+	if (length == 2 && memcmp(type, "W6", 2) == 0)
+	{
+		zone.type = Wedge;
+		zone.vertexNum = 6;
+	}
+	else if (length == 2 && memcmp(type, "B8", 2) == 0)
+	{
+		zone.type = Brick;
+		zone.vertexNum = 8;
+	}
+	else
+	{
+		qDebug() << "Unknown zone type: " << QString::fromLatin1(type, length);
+		return false;
+	}
+
+	for (int i = 0; i < zone.vertexNum; ++i)
+	{
+		if (!parseUInt(p, end, zone.vertices[i]))
+		{
+			return false;
+		}
+		zone.vertices[i] -= 1;
+	}
+	return true;
+}
+
+bool F3GridParser::parseFace(const char* p, const char* end, Facet& facet)
+{
+	const char* type;
+	int length;
+	int index;
+	if (!parseToken(p, end, type, length) || !parseInt(p, end, index))
+	{
+		return false;
+	}
+
+	if (length == 2 && memcmp(type, "Q4", 2) == 0)
+	{
+		facet.type = Q4;
+		facet.num = 4;
+	}
+	else if (length == 2 && memcmp(type, "T3", 2) == 0)
+	{
+		facet.type = T3;
+		facet.num = 3;
+	}
+	else
+	{
+		qDebug() << "Unknown face type: " << QString::fromLatin1(type, length);
+		return false;
+	}
+
+	for (int i = 0; i < facet.num; ++i)
+	{
+		if (!parseUInt(p, end, facet.indices[i]))
+		{
+			return false;
+		}
+		facet.indices[i] -= 1;
+	}
+	facet.elemID = 0;
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "geotypes.h"
+
+/**
+	f3gridļࣨڴӳ䣬ԭؽֵ
+*/
+
+struct F3GridRecordCount
+{
+	int gridPointNum = 0;
+	int zoneNum = 0;
+	int faceNum = 0;
+};
+
+struct F3GridChunk
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	QVector<QVector3D> positions;
+	QVector<Zone> zones;
+	QVector<Facet> facets;
+	bool result = true;
+};
+
+class F3GridParser
+{
+public:
+	static bool load(const QString& fileName, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets, QStringList& groupNames, int threadCount = 0);
+	static F3GridRecordCount countRecords(const char* begin, const char* end);
+	static bool parse(const char* begin, const char* end, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets);
+	static bool parseParallel(const char* begin, const char* end, QVector<QVector3D>& positions, QVector<Zone>& zones, QVector<Facet>& facets, int threadCount);
+	static QVector<F3GridChunk> splitChunks(const char* begin, const char* end, int chunkNum);
+	static bool parseZoneGroups(const char* begin, const char* end, QVector<Zone>& zones, QStringList& groupNames);
+
+	static const char* findLineEnd(const char* p, const char* end);
+	static const char* skipSpaces(const char* p, const char* end);
+	static bool parseToken(const char*& p, const char* end, const char*& token, int& length);
+	static bool parseName(const char*& p, const char* end, QString& name);
+	static bool parseInt(const char*& p, const char* end, int& value);
+	static bool parseUInt(const char*& p, const char* end, uint32_t& value);
+	static bool parseFloat(const char*& p, const char* end, float& value);
+
+private:
+	static bool isRecordHeader(const char* p, const char* end, char header);
+	static bool parseGridPoint(const char* p, const char* end, QVector3D& position);
+	static bool parseZone(const char* p, const char* end, Zone& zone);
+	static bool parseFace(const char* p, const char* end, Facet& facet);
+};
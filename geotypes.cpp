@@ -126,7 +126,406 @@ void Bound::reset()
 	intersectFlag = -1;
 }
 
-int Zone::facetID = 0;
+// AABBԱʵ
+int AABB::maxDim() const
+{
+	return qMaxDim(max - min);
+}
+
+float AABB::surfaceArea() const
+{
+	QVector3D size = max - min;
+	if (size.x() < 0.0f || size.y() < 0.0f || size.z() < 0.0f)
+	{
+		return 0.0f;
+	}
+	return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+void AABB::combine(const QVector3D& position)
+{
+	min = qMinVec3(min, position);
+	max = qMaxVec3(max, position);
+}
+
+void AABB::combine(const AABB& bound)
+{
+	min = qMinVec3(min, bound.min);
+	max = qMaxVec3(max, bound.max);
+}
+
+bool AABB::intersect(const Plane& plane) const
+{
+	// ֻطСǵ
+	QVector3D nearCorner;
+	QVector3D farCorner;
+	for (int i = 0; i < 3; ++i)
+	{
+		bool positive = plane.normal[i] >= 0.0f;
+		nearCorner[i] = positive ? min[i] : max[i];
+		farCorner[i] = positive ? max[i] : min[i];
+	}
+	return plane.checkSide(nearCorner) != plane.checkSide(farCorner);
+}
+
+bool AABB::intersect(const Ray& ray) const
+{
+	double tx1 = (min.x() - ray.origin.x()) * ray.invDirection.x();
+	double tx2 = (max.x() - ray.origin.x()) * ray.invDirection.x();
+
+	double tmin = qMin(tx1, tx2);
+	double tmax = qMax(tx1, tx2);
+
+	double ty1 = (min.y() - ray.origin.y()) * ray.invDirection.y();
+	double ty2 = (max.y() - ray.origin.y()) * ray.invDirection.y();
+
+	tmin = qMax(tmin, qMin(ty1, ty2));
+	tmax = qMin(tmax, qMax(ty1, ty2));
+
+	return tmax >= tmin;
+}
+
+bool AABB::contain(const QVector3D& point) const
+{
+	return point[0] >= min[0] && point[0] <= max[0] &&
+		point[1] >= min[1] && point[1] <= max[1] &&
+		point[2] >= min[2] && point[2] <= max[2];
+}
+
+Bound AABB::toBound() const
+{
+	Bound bound;
+	bound.min = min;
+	bound.max = max;
+	bound.cache();
+	bound.reset();
+	return bound;
+}
+
+// LinearBVHԱʵ
+bool LinearBVH::isValid(int primitiveNum) const
+{
+	// ӽڵűλڸڵ֮󣬱֤Խ
+	for (int i = 0; i < nodes.count(); ++i)
+	{
+		const LinearBVHNode& node = nodes[i];
+		if (node.isLeaf())
+		{
+			if (node.offset < 0 || node.offset + node.primitiveNum > primitives.count())
+			{
+				return false;
+			}
+		}
+		else if (i + 1 >= nodes.count() || node.offset <= i + 1 || node.offset >= nodes.count())
+		{
+			return false;
+		}
+	}
+
+	for (uint32_t primitive : primitives)
+	{
+		if (primitive >= (uint32_t)primitiveNum)
+		{
+			return false;
+		}
+	}
+	return groupMasks.isEmpty() || groupMasks.count() == nodes.count();
+}
+
+void LinearBVH::clear()
+{
+	nodes.clear();
+	primitives.clear();
+	groupMasks.clear();
+}
+
+qint64 LinearBVH::memoryUsage() const
+{
+	return nodes.capacity() * (qint64)sizeof(LinearBVHNode) +
+		primitives.capacity() * (qint64)sizeof(uint32_t) +
+		groupMasks.capacity() * (qint64)sizeof(quint64);
+}
+
+void IntervalTree::clear()
+{
+	nodes.clear();
+	lowerEntries.clear();
+	upperEntries.clear();
+}
+
+qint64 IntervalTree::memoryUsage() const
+{
+	return nodes.capacity() * (qint64)sizeof(IntervalTreeNode) +
+		(lowerEntries.capacity() + upperEntries.capacity()) * (qint64)sizeof(IntervalEntry);
+}
+
+// EdgeFacesԱʵ
+void EdgeFaces::append(uint32_t face)
+{
+	if (num < kInlineFaceNum)
+	{
+		inlineFaces[num++] = face;
+		return;
+	}
+
+	if (num == kInlineFaceNum)
+	{
+		extraFaces.reserve(kInlineFaceNum * 2);
+		extraFaces.append(inlineFaces[0]);
+		extraFaces.append(inlineFaces[1]);
+	}
+	extraFaces.append(face);
+	++num;
+}
+
+// EdgeIndexԱʵ
+void EdgeIndex::reserve(int edgeNum)
+{
+	// װʲ1/2
+	int bucketNum = 16;
+	while (bucketNum < edgeNum * 2)
+	{
+		bucketNum <<= 1;
+	}
+	if (bucketNum > buckets.count())
+	{
+		rehash(bucketNum);
+	}
+	keys.reserve(edgeNum);
+}
+
+void EdgeIndex::clear()
+{
+	keys.clear();
+	buckets.clear();
+}
+
+int EdgeIndex::find(quint32 v0, quint32 v1) const
+{
+	if (buckets.isEmpty())
+	{
+		return -1;
+	}
+
+	quint64 key = qEdgeKey(v0, v1);
+	int mask = buckets.count() - 1;
+	for (int i = hash(key) & mask; ; i = (i + 1) & mask)
+	{
+		const Bucket& bucket = buckets[i];
+		if (bucket.edgeId < 0)
+		{
+			return -1;
+		}
+		if (bucket.key == key)
+		{
+			return bucket.edgeId;
+		}
+	}
+}
+
+int EdgeIndex::insert(quint32 v0, quint32 v1, bool* inserted)
+{
+	if ((keys.count() + 1) * 2 > buckets.count())
+	{
+		rehash(qMax(16, buckets.count() * 2));
+	}
+
+	quint64 key = qEdgeKey(v0, v1);
+	int mask = buckets.count() - 1;
+	int i = hash(key) & mask;
+	for (; buckets[i].edgeId >= 0; i = (i + 1) & mask)
+	{
+		if (buckets[i].key == key)
+		{
+			if (inserted)
+			{
+				*inserted = false;
+			}
+			return buckets[i].edgeId;
+		}
+	}
+
+	buckets[i] = Bucket{ key, keys.count() };
+	keys.append(key);
+	if (inserted)
+	{
+		*inserted = true;
+	}
+	return buckets[i].edgeId;
+}
+
+qint64 EdgeIndex::memoryUsage() const
+{
+	return keys.capacity() * (qint64)sizeof(quint64) + buckets.capacity() * (qint64)sizeof(Bucket);
+}
+
+quint32 EdgeIndex::hash(quint64 key)
+{
+	// 64λϺڵʱҲܾȷֲ
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ull;
+	key ^= key >> 33;
+	return quint32(key);
+}
+
+void EdgeIndex::rehash(int bucketNum)
+{
+	buckets.fill(Bucket{ 0, -1 }, bucketNum);
+	int mask = bucketNum - 1;
+	for (int edgeId = 0; edgeId < keys.count(); ++edgeId)
+	{
+		int i = hash(keys[edgeId]) & mask;
+		while (buckets[i].edgeId >= 0)
+		{
+			i = (i + 1) & mask;
+		}
+		buckets[i] = Bucket{ keys[edgeId], edgeId };
+	}
+}
+
+// NodeAttributesԱʵ
+int NodeAttributes::count() const
+{
+	return positions.count();
+}
+
+void NodeAttributes::resize(int nodeNum)
+{
+	positions.resize(nodeNum);
+	for (int f = FieldUSUM; f <= FieldUZ; ++f)
+	{
+		fields[f].resize(nodeNum);
+	}
+}
+
+void NodeAttributes::clear()
+{
+	positions.clear();
+	for (QVector<float>& values : fields)
+	{
+		values.clear();
+	}
+	displayField = FieldUSUM;
+}
+
+bool NodeAttributes::hasField(int field) const
+{
+	return field >= 0 && field < ResultFieldTypeNum && fields[field].count() == positions.count();
+}
+
+QVector<float>& NodeAttributes::field(int field)
+{
+	QVector<float>& values = fields[field];
+	if (values.count() != positions.count())
+	{
+		values.resize(positions.count());
+	}
+	return values;
+}
+
+const QVector<float>& NodeAttributes::values() const
+{
+	return fields[displayField];
+}
+
+bool NodeAttributes::hasDeformation() const
+{
+	return hasField(FieldUX) && hasField(FieldUY) && hasField(FieldUZ);
+}
+
+void NodeAttributes::deform(float scale, QVector<QVector3D>& deformedPositions) const
+{
+	const QVector<float>& deformationX = fields[FieldUX];
+	const QVector<float>& deformationY = fields[FieldUY];
+	const QVector<float>& deformationZ = fields[FieldUZ];
+	deformedPositions.resize(positions.count());
+	for (int i = 0; i < positions.count(); ++i)
+	{
+		deformedPositions[i] = positions[i] + QVector3D(deformationX[i], deformationY[i], deformationZ[i]) * scale;
+	}
+}
+
+qint64 NodeAttributes::memoryUsage() const
+{
+	qint64 bytes = positions.capacity() * sizeof(QVector3D);
+	for (const QVector<float>& values : fields)
+	{
+		bytes += values.capacity() * sizeof(float);
+	}
+	return bytes;
+}
+
+// ValueRangeԱʵ
+void ValueRange::setFieldRange(int field, float minValue, float maxValue)
+{
+	switch (field)
+	{
+	case FieldUX: case FieldUY: case FieldUZ:
+		minDeformation[field - FieldUX] = minValue;
+		maxDeformation[field - FieldUX] = maxValue;
+		break;
+	case FieldEPTOX: case FieldEPTOY: case FieldEPTOZ:
+		minNormalElasticStrain[field - FieldEPTOX] = minValue;
+		maxNormalElasticStrain[field - FieldEPTOX] = maxValue;
+		break;
+	case FieldEPTOXY: case FieldEPTOYZ: case FieldEPTOXZ:
+		minShearElasticStrain[field - FieldEPTOXY] = minValue;
+		maxShearElasticStrain[field - FieldEPTOXY] = maxValue;
+		break;
+	case FieldS1:
+		minMaximumPrincipalStress = minValue;
+		maxMaximumPrincipalStress = maxValue;
+		break;
+	case FieldS2:
+		minMiddlePrincipalStress = minValue;
+		maxMiddlePrincipalStress = maxValue;
+		break;
+	case FieldS3:
+		minMinimumPrincipalStress = minValue;
+		maxMinimumPrincipalStress = maxValue;
+		break;
+	case FieldSX: case FieldSY: case FieldSZ:
+		minNormalStress[field - FieldSX] = minValue;
+		maxNormalStress[field - FieldSX] = maxValue;
+		break;
+	case FieldSXY: case FieldSYZ: case FieldSXZ:
+		minShearStress[field - FieldSXY] = minValue;
+		maxShearStress[field - FieldSXY] = maxValue;
+		break;
+	default:
+		minTotalDeformation = minValue;
+		maxTotalDeformation = maxValue;
+		break;
+	}
+}
+
+QVector2D ValueRange::getFieldRange(int field) const
+{
+	switch (field)
+	{
+	case FieldUX: case FieldUY: case FieldUZ:
+		return QVector2D(minDeformation[field - FieldUX], maxDeformation[field - FieldUX]);
+	case FieldEPTOX: case FieldEPTOY: case FieldEPTOZ:
+		return QVector2D(minNormalElasticStrain[field - FieldEPTOX], maxNormalElasticStrain[field - FieldEPTOX]);
+	case FieldEPTOXY: case FieldEPTOYZ: case FieldEPTOXZ:
+		return QVector2D(minShearElasticStrain[field - FieldEPTOXY], maxShearElasticStrain[field - FieldEPTOXY]);
+	case FieldS1:
+		return QVector2D(minMaximumPrincipalStress, maxMaximumPrincipalStress);
+	case FieldS2:
+		return QVector2D(minMiddlePrincipalStress, maxMiddlePrincipalStress);
+	case FieldS3:
+		return QVector2D(minMinimumPrincipalStress, maxMinimumPrincipalStress);
+	case FieldSX: case FieldSY: case FieldSZ:
+		return QVector2D(minNormalStress[field - FieldSX], maxNormalStress[field - FieldSX]);
+	case FieldSXY: case FieldSYZ: case FieldSXZ:
+		return QVector2D(minShearStress[field - FieldSXY], maxShearStress[field - FieldSXY]);
+	default:
+		return QVector2D(minTotalDeformation, maxTotalDeformation);
+	}
+}
+
 bool Zone::isValid() const
 {
 	QSet<uint32_t> vertexSet;
@@ -137,84 +536,329 @@ bool Zone::isValid() const
 	return vertexSet.count() > 3;
 }
 
-// ZoneԱʵ
-void Zone::cache(const QVector<NodeVertex>& nodeVertices)
+// Ԫ͵˱ڵ˳FLAC3Dһ£Ľڵ㰴ⷨʱУ
+static const ZoneTopology kBrickTopology = {
+	8, 12, 6,
+	{ {0, 1}, {1, 4}, {4, 2}, {2, 0}, {3, 6}, {6, 7}, {7, 5}, {5, 3}, {0, 3}, {1, 6}, {4, 7}, {2, 5} },
+	{ 4, 4, 4, 4, 4, 4 },
+	{ {0, 2, 4, 1}, {0, 3, 5, 2}, {2, 5, 7, 4}, {1, 4, 7, 6}, {0, 1, 6, 3}, {3, 6, 7, 5} },
+	{ 0, 1, 2, 3, 4, 5, 6, 7 }
+};
+
+static const ZoneTopology kDegeneratedBrickTopology = {
+	8, 11, 6,
+	{ {0, 1}, {1, 4}, {4, 2}, {2, 0}, {3, 6}, {6, 5}, {5, 3}, {0, 3}, {1, 6}, {4, 6}, {2, 5} },
+	{ 4, 4, 4, 3, 4, 3 },
+	{ {0, 2, 4, 1}, {0, 3, 5, 2}, {2, 5, 6, 4}, {1, 4, 6}, {0, 1, 6, 3}, {3, 6, 5} },
+	{ 0, 1, 2, 3, 4, 5, 6, 6 }
+};
+
+static const ZoneTopology kWedgeTopology = {
+	6, 9, 5,
+	{ {0, 1}, {1, 3}, {3, 0}, {2, 4}, {4, 5}, {5, 2}, {1, 4}, {3, 5}, {0, 2} },
+	{ 3, 3, 4, 4, 4 },
+	{ {0, 1, 3}, {2, 5, 4}, {0, 2, 4, 1}, {1, 3, 5, 4}, {0, 3, 5, 2} },
+	{ 0, 1, 2, 3, 4, 5, 3, 5 }
+};
+
+static const ZoneTopology kPyramidTopology = {
+	5, 8, 5,
+	{ {0, 1}, {1, 4}, {4, 2}, {2, 0}, {0, 3}, {1, 3}, {4, 3}, {2, 3} },
+	{ 4, 3, 3, 3, 3 },
+	{ {0, 2, 4, 1}, {0, 1, 3}, {1, 4, 3}, {2, 3, 4}, {0, 3, 2} },
+	{ 0, 1, 2, 3, 4, 3, 3, 3 }
+};
+
+static const ZoneTopology kTetrahedronTopology = {
+	4, 6, 4,
+	{ {0, 1}, {0, 2}, {1, 2}, {0, 3}, {1, 3}, {2, 3} },
+	{ 3, 3, 3, 3 },
+	{ {0, 1, 3}, {0, 3, 2}, {1, 2, 3}, {0, 2, 1} },
+	{ 0, 1, 2, 3, 2, 3, 3, 3 }
+};
+
+static const ZoneTopology kEmptyTopology = {};
+
+// ZoneSetԱʵ
+const ZoneTopology& ZoneSet::topology(int type)
 {
-	// ¼Ԫÿֵ
-	for (int i = 0; i < vertexNum; ++i)
+	switch (type)
 	{
-		values[i] = nodeVertices[vertices[i]].totalDeformation;
+	case Brick:
+		return kBrickTopology;
+	case DegeneratedBrick:
+		return kDegeneratedBrickTopology;
+	case Wedge:
+		return kWedgeTopology;
+	case Pyramid:
+		return kPyramidTopology;
+	case Tetrahedron:
+		return kTetrahedronTopology;
+	default:
+		return kEmptyTopology;
 	}
-	if (type == Wedge)
+}
+
+bool ZoneSet::isValid() const
+{
+	int zoneNum = types.count();
+	if (groups.count() != zoneNum || vertices.count() != zoneNum * kZoneVertexStride ||
+		boundMins.count() != zoneNum || boundMaxs.count() != zoneNum ||
+		planes.count() != zoneNum * kZonePlaneStride || origins.count() != zoneNum || invertedBases.count() != zoneNum * 3 ||
+		edgeOffsets.count() != zoneNum + 1 || edgeOffsets[0] != 0 || edgeOffsets[zoneNum] != edgeIds.count())
 	{
-		values[6] = values[3];
-		values[7] = values[5];
+		return false;
 	}
-	else if (type == Pyramid)
+
+	for (int i = 0; i < zoneNum; ++i)
 	{
-		values[5] = values[6] = values[7] = values[3];
+		const ZoneTopology& topo = topology(types[i]);
+		if (topo.vertexNum == 0 || groups[i] < 0 || edgeOffsets[i + 1] - edgeOffsets[i] != topo.edgeNum)
+		{
+			return false;
+		}
 	}
-	else if (type == DegeneratedBrick)
+
+	for (quint32 edgeId : edgeIds)
 	{
-		values[7] = values[6];
+		if (!edges.isEmpty() && edgeId >= (quint32)edges.count())
+		{
+			return false;
+		}
 	}
-	else if (type == Tetrahedron)
+	return true;
+}
+
+void ZoneSet::reserve(int zoneNum)
+{
+	types.reserve(zoneNum);
+	groups.reserve(zoneNum);
+	vertices.reserve(zoneNum * kZoneVertexStride);
+	boundMins.reserve(zoneNum);
+	boundMaxs.reserve(zoneNum);
+	planes.reserve(zoneNum * kZonePlaneStride);
+	origins.reserve(zoneNum);
+	invertedBases.reserve(zoneNum * 3);
+	edgeOffsets.reserve(zoneNum + 1);
+	edgeIds.reserve(zoneNum * 12);
+}
+
+void ZoneSet::clear()
+{
+	types.clear();
+	groups.clear();
+	vertices.clear();
+	boundMins.clear();
+	boundMaxs.clear();
+	planes.clear();
+	origins.clear();
+	invertedBases.clear();
+	nodeValues.clear();
+	edges.clear();
+	edgeOffsets.clear();
+	edgeIds.clear();
+}
+
+bool ZoneSet::append(const Zone& zone, const QVector<QVector3D>& positions)
+{
+	const ZoneTopology& topo = topology(zone.type);
+	if (topo.vertexNum == 0 || topo.vertexNum != zone.vertexNum)
 	{
-		values[4] = values[2];
-		values[5] = values[6] = values[7] = values[3];
+		return false;
 	}
 
-	// ¼Ԫÿ
-	if (type == Brick || type == DegeneratedBrick)
+	types.append((quint8)zone.type);
+	groups.append(zone.group);
+	for (int i = 0; i < kZoneVertexStride; ++i)
 	{
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[2]].position, nodeVertices[vertices[1]].position));
-		planes.append(Plane(nodeVertices[vertices[3]].position, nodeVertices[vertices[6]].position, nodeVertices[vertices[5]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[3]].position, nodeVertices[vertices[2]].position));
-		planes.append(Plane(nodeVertices[vertices[1]].position, nodeVertices[vertices[4]].position, nodeVertices[vertices[6]].position));
-		planes.append(Plane(nodeVertices[vertices[2]].position, nodeVertices[vertices[5]].position, nodeVertices[vertices[4]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[1]].position, nodeVertices[vertices[3]].position));
+		// δʹõĽڵλòһڵ㣬֤ʱЧ
+		vertices.append(i < topo.vertexNum ? zone.vertices[i] : zone.vertices[0]);
 	}
-	else if (type == Wedge || type == Pyramid)
+
+	int zoneIndex = count() - 1;
+	boundMins.resize(count());
+	boundMaxs.resize(count());
+	planes.resize(count() * kZonePlaneStride);
+	origins.resize(count());
+	invertedBases.resize(count() * 3);
+	updateGeometry(positions, zoneIndex, zoneIndex + 1);
+	return true;
+}
+
+void ZoneSet::updateGeometry(const QVector<QVector3D>& positions, int zoneBegin, int zoneEnd)
+{
+	for (int z = zoneBegin; z < zoneEnd; ++z)
 	{
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[2]].position, nodeVertices[vertices[1]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[3]].position, nodeVertices[vertices[2]].position));
-		planes.append(Plane(nodeVertices[vertices[1]].position, nodeVertices[vertices[4]].position, nodeVertices[vertices[6]].position));
-		planes.append(Plane(nodeVertices[vertices[2]].position, nodeVertices[vertices[5]].position, nodeVertices[vertices[4]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[1]].position, nodeVertices[vertices[3]].position));
+		const ZoneTopology& topo = topology(types[z]);
+		const quint32* zoneVertices = vertices.constData() + z * kZoneVertexStride;
+		AABB bound;
+		for (int i = 0; i < kZoneVertexStride; ++i)
+		{
+			bound.combine(positions[zoneVertices[i]]);
+		}
+		boundMins[z] = bound.min;
+		boundMaxs[z] = bound.max;
+
+		// ÿȡǰڵ㼰һڵȷƽ棬˻治ж
+		for (int i = 0; i < kZonePlaneStride; ++i)
+		{
+			QVector4D equation;
+			if (i < topo.facetNum)
+			{
+				const int* facet = topo.facets[i];
+				Plane plane(positions[zoneVertices[facet[0]]], positions[zoneVertices[facet[1]]], positions[zoneVertices[facet[topo.facetSizes[i] - 1]]]);
+				if (!plane.degenerated)
+				{
+					equation = QVector4D(plane.normal, plane.dist);
+				}
+			}
+			planes[z * kZonePlaneStride + i] = equation;
+		}
+
+		// ¼ԪĻ
+		QVector3D origin = positions[zoneVertices[0]];
+		QVector3D axis[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			axis[i] = positions[zoneVertices[i + 1]] - origin;
+		}
+		QMatrix4x4 basisMatrix(axis[0][0], axis[1][0], axis[2][0], 0.0f,
+			axis[0][1], axis[1][1], axis[2][1], 0.0f,
+			axis[0][2], axis[1][2], axis[2][2], 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+		bool invertible = false;
+		QMatrix4x4 invertedBasisMatrix = basisMatrix.inverted(&invertible);
+		if (!invertible)
+		{
+			qDebug() << "Invertible!";
+		}
+		origins[z] = origin;
+		for (int i = 0; i < 3; ++i)
+		{
+			invertedBases[z * 3 + i] = invertedBasisMatrix.row(i).toVector3D();
+		}
 	}
-	else if (type == Tetrahedron)
+}
+
+void ZoneSet::append(const ZoneSet& zoneSet, int zoneIndex)
+{
+	types.append(zoneSet.types[zoneIndex]);
+	groups.append(zoneSet.groups[zoneIndex]);
+	for (int i = 0; i < kZoneVertexStride; ++i)
 	{
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[2]].position, nodeVertices[vertices[1]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[3]].position, nodeVertices[vertices[2]].position));
-		planes.append(Plane(nodeVertices[vertices[1]].position, nodeVertices[vertices[4]].position, nodeVertices[vertices[6]].position));
-		planes.append(Plane(nodeVertices[vertices[0]].position, nodeVertices[vertices[1]].position, nodeVertices[vertices[3]].position));
+		vertices.append(zoneSet.vertices[zoneIndex * kZoneVertexStride + i]);
 	}
-
-	// ¼ԪĻ
-	origin = nodeVertices[vertices[0]].position;
-	QVector3D axis[3];
+	boundMins.append(zoneSet.boundMins[zoneIndex]);
+	boundMaxs.append(zoneSet.boundMaxs[zoneIndex]);
+	for (int i = 0; i < kZonePlaneStride; ++i)
+	{
+		planes.append(zoneSet.planes[zoneIndex * kZonePlaneStride + i]);
+	}
+	origins.append(zoneSet.origins[zoneIndex]);
 	for (int i = 0; i < 3; ++i)
 	{
-		axis[i] = nodeVertices[vertices[i + 1]].position - origin;
+		invertedBases.append(zoneSet.invertedBases[zoneIndex * 3 + i]);
 	}
-	QMatrix4x4 basisMatrix(axis[0][0], axis[1][0], axis[2][0], 0.0f,
-		axis[0][1], axis[1][1], axis[2][1], 0.0f,
-		axis[0][2], axis[1][2], axis[2][2], 0.0f,
-		0.0f, 0.0f, 0.0f, 1.0f);
-	bool invertible = false;
-	invertedBasisMatrix = basisMatrix.inverted(&invertible);
-	if (!invertible)
+
+	// ߱űΪȫֱ
+	if (edgeOffsets.isEmpty())
+	{
+		edgeOffsets.append(0);
+	}
+	for (int i = zoneSet.edgeOffsets[zoneIndex]; i < zoneSet.edgeOffsets[zoneIndex + 1]; ++i)
+	{
+		edgeIds.append(zoneSet.edgeIds[i]);
+	}
+	edgeOffsets.append(edgeIds.count());
+}
+
+void ZoneSet::buildEdges()
+{
+	// ڵԪıֻ¼һ
+	QHash<quint64, quint32> edgeMap;
+	edgeMap.reserve(count() * 4);
+	edges.clear();
+	edgeOffsets.resize(count() + 1);
+	edgeIds.clear();
+	edgeIds.reserve(count() * 12);
+	edgeOffsets[0] = 0;
+	for (int i = 0; i < count(); ++i)
+	{
+		int edgeNum = this->edgeNum(i);
+		for (int j = 0; j < edgeNum; ++j)
+		{
+			Edge edge = this->edge(i, j);
+			quint64 key = qEdgeKey(edge.vertices[0], edge.vertices[1]);
+			auto iter = edgeMap.find(key);
+			if (iter == edgeMap.end())
+			{
+				iter = edgeMap.insert(key, edges.count());
+				edges.append(Edge{ quint32(key >> 32), quint32(key) });
+			}
+			edgeIds.append(iter.value());
+		}
+		edgeOffsets[i + 1] = edgeIds.count();
+	}
+	edges.squeeze();
+}
+
+Zone ZoneSet::zone(int zoneIndex) const
+{
+	Zone zone;
+	zone.type = type(zoneIndex);
+	zone.vertexNum = vertexNum(zoneIndex);
+	memcpy(zone.vertices, zoneVertices(zoneIndex), sizeof(zone.vertices));
+	zone.group = groups[zoneIndex];
+	return zone;
+}
+
+Edge ZoneSet::edge(int zoneIndex, int edgeIndex) const
+{
+	const int* edge = topology(types[zoneIndex]).edges[edgeIndex];
+	const quint32* zoneVertex = zoneVertices(zoneIndex);
+	return Edge{ zoneVertex[edge[0]], zoneVertex[edge[1]] };
+}
+
+Facet ZoneSet::facet(int zoneIndex, int facetIndex) const
+{
+	// ˱ɣ
+	const ZoneTopology& topo = topology(types[zoneIndex]);
+	const quint32* zoneVertex = zoneVertices(zoneIndex);
+	Facet facet;
+	facet.num = topo.facetSizes[facetIndex];
+	facet.type = facet.num == 3 ? T3 : Q4;
+	facet.elemID = zoneIndex;
+	facet.facetID = -1;
+	for (int i = 0; i < 4; ++i)
 	{
-		qDebug() << "Invertible!";
+		facet.indices[i] = i < facet.num ? zoneVertex[topo.facets[facetIndex][i]] : 0;
 	}
+	return facet;
+}
+
+Bound ZoneSet::bound(int zoneIndex) const
+{
+	Bound bound;
+	bound.min = boundMins[zoneIndex];
+	bound.max = boundMaxs[zoneIndex];
+	bound.cache();
+	return bound;
 }
 
-bool Zone::contain(const QVector3D& point) const
+void ZoneSet::cacheValues(const QVector<float>& nodeValues)
 {
-	bool first = planes[0].checkSide(point);
-	for (int i = 1; i < planes.count(); ++i)
+	// ڵֵʽֵʱ˱Ľǵȡֵ
+	this->nodeValues = nodeValues;
+}
+
+bool ZoneSet::contain(int zoneIndex, const QVector3D& point) const
+{
+	const QVector4D* equations = planes.constData() + zoneIndex * kZonePlaneStride;
+	int facetNum = this->facetNum(zoneIndex);
+	bool first = QVector3D::dotProduct(point, equations[0].toVector3D()) > equations[0].w();
+	for (int i = 1; i < facetNum; ++i)
 	{
-		bool other = planes[i].checkSide(point);
+		bool other = QVector3D::dotProduct(point, equations[i].toVector3D()) > equations[i].w();
 		if (other != first)
 		{
 			return false;
@@ -223,20 +867,73 @@ bool Zone::contain(const QVector3D& point) const
 	return true;
 }
 
-bool Zone::interp(const QVector3D& point, float& value) const
+bool ZoneSet::interp(int zoneIndex, const QVector3D& point, float& value) const
 {
-	if (!contain(point))
+	if (!contain(zoneIndex, point))
 	{
 		return false;
 	}
 
-	QVector4D t = invertedBasisMatrix * QVector4D(point - origin, 0.0f);
-	value = qTriLerp(values[0], values[1], values[2], values[4],
-		values[3], values[6], values[5], values[7],
-		t[0], t[1], t[2]);
+	value = interpValue(zoneIndex, localCoords(zoneIndex, point));
 	return true;
 }
 
+QVector3D ZoneSet::localCoords(int zoneIndex, const QVector3D& point) const
+{
+	const QVector3D* rows = invertedBases.constData() + zoneIndex * 3;
+	QVector3D offset = point - origins[zoneIndex];
+	return QVector3D(QVector3D::dotProduct(rows[0], offset),
+		QVector3D::dotProduct(rows[1], offset),
+		QVector3D::dotProduct(rows[2], offset));
+}
+
+float ZoneSet::interpValue(int zoneIndex, const QVector3D& coords) const
+{
+	const int* corners = topology(types[zoneIndex]).corners;
+	const quint32* zoneVertex = zoneVertices(zoneIndex);
+	float values[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		values[i] = nodeValues[zoneVertex[corners[i]]];
+	}
+	return qTriLerp(values[0], values[1], values[2], values[4],
+		values[3], values[6], values[5], values[7],
+		coords[0], coords[1], coords[2]);
+}
+
+qint64 ZoneSet::memoryUsage() const
+{
+	return types.capacity() * (qint64)sizeof(quint8) +
+		groups.capacity() * (qint64)sizeof(qint32) +
+		vertices.capacity() * (qint64)sizeof(quint32) +
+		(boundMins.capacity() + boundMaxs.capacity() + origins.capacity() + invertedBases.capacity()) * (qint64)sizeof(QVector3D) +
+		planes.capacity() * (qint64)sizeof(QVector4D) +
+		edges.capacity() * (qint64)sizeof(Edge) +
+		edgeOffsets.capacity() * (qint64)sizeof(qint32) +
+		edgeIds.capacity() * (qint64)sizeof(quint32);
+}
+
+// UniformGridsԱʵ
+QVector3D UniformGrids::position(int x, int y, int z) const
+{
+	QVector3D position;
+	position[0] = qLerp(bound.min[0], bound.max[0], (float)x / (dim[0] - 1));
+	position[1] = qLerp(bound.min[1], bound.max[1], (float)y / (dim[1] - 1));
+	position[2] = qLerp(bound.min[2], bound.max[2], (float)z / (dim[2] - 1));
+	return position;
+}
+
+std::array<int, 3> UniformGrids::blockDim() const
+{
+	// ÿdim - 1صԪ
+	std::array<int, 3> blockDim;
+	for (int i = 0; i < 3; ++i)
+	{
+		blockDim[i] = dim[i] > 1 ? (dim[i] - 2) / kVoxelBlockSize + 1 : 0;
+	}
+	return blockDim;
+}
+
 int qMaxDim(const QVector3D& v)
 {
 	if (qAbs(v[0]) > qAbs(v[1]) && qAbs(v[0]) > qAbs(v[2]))
@@ -298,23 +995,23 @@ QSet<Edge> Facet::getEdges() const
 	}
 }
 
-bool Facet::intersect(const QVector<NodeVertex>& nodeVertices, const Ray& ray, float& t) const
+bool Facet::intersect(const QVector<QVector3D>& positions, const Ray& ray, float& t) const
 {
-	if (intersect(nodeVertices, indices[0], indices[1], indices[3], ray, t))
+	if (intersect(positions, indices[0], indices[1], indices[3], ray, t))
 	{
 		return true;
 	}
-	if (type == Q4 && intersect(nodeVertices, indices[1], indices[2], indices[3], ray, t))
+	if (type == Q4 && intersect(positions, indices[1], indices[2], indices[3], ray, t))
 	{
 		return true;
 	}
 	return false;
 }
 
-bool Facet::intersect(const QVector<NodeVertex>& nodeVertices, quint32 i0, quint32 i1, quint32 i2, const Ray& ray, float& t) const
+bool Facet::intersect(const QVector<QVector3D>& positions, quint32 i0, quint32 i1, quint32 i2, const Ray& ray, float& t) const
 {
-	QVector3D v0v1 = nodeVertices[i1].position - nodeVertices[i0].position;
-	QVector3D v0v2 = nodeVertices[i2].position - nodeVertices[i0].position;
+	QVector3D v0v1 = positions[i1] - positions[i0];
+	QVector3D v0v2 = positions[i2] - positions[i0];
 	QVector3D pvec = QVector3D::crossProduct(ray.direction, v0v2);
 	float det = QVector3D::dotProduct(v0v1, pvec);
 
@@ -324,7 +1021,7 @@ bool Facet::intersect(const QVector<NodeVertex>& nodeVertices, quint32 i0, quint
 	float invDet = 1 / det;
 	float u, v;
 
-	QVector3D tvec = ray.origin - nodeVertices[i0].position;
+	QVector3D tvec = ray.origin - positions[i0];
 	u = QVector3D::dotProduct(tvec, pvec) * invDet;
 	if (u < 0.0f || u > 1.0f) return false;
 
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <QMatrix4x4>
+#include <QVector2D>
 #include <QVector>
 #include <QList>
 #include <QSet>
 #include <QMap>
+#include <QStringList>
 #include <array>
 
 #define SAFE_DELETE(p) { if(p) { delete (p); (p)=NULL; } }
@@ -14,6 +16,9 @@ const float kMinVal = -kMaxVal;
 const uint32_t kInvalidIndex = 1e8;
 const QVector3D kMaxVec3 = QVector3D(kMaxVal, kMaxVal, kMaxVal);
 const QVector3D kMinVec3 = QVector3D(kMinVal, kMinVal, kMinVal);
+const int kMaxZoneGroupNum = 64;
+const quint64 kAllZoneGroups = ~0ull;
+const int kVoxelBlockSize = 8;
 
 struct Plane
 {
@@ -72,25 +77,136 @@ struct Edge
 	std::array<uint32_t, 2> vertices;
 };
 
+// ߵĹ淶뷽޹أСڵڸ32λ
+inline quint64 qEdgeKey(quint32 v0, quint32 v1)
+{
+	return v0 < v1 ? ((quint64)v0 << 32 | v1) : ((quint64)v1 << 32 | v0);
+}
+
+// ߵС飨ÿ棬ţʱת浽ϣ
+class EdgeFaces
+{
+public:
+	int count() const { return num; }
+	bool isEmpty() const { return num == 0; }
+	const uint32_t* begin() const { return num <= kInlineFaceNum ? inlineFaces : extraFaces.constData(); }
+	const uint32_t* end() const { return begin() + num; }
+	uint32_t operator[](int i) const { return begin()[i]; }
+	void append(uint32_t face);
+
+private:
+	static const int kInlineFaceNum = 2;
+	uint32_t inlineFaces[kInlineFaceNum];
+	int num = 0;
+	QVector<uint32_t> extraFaces;
+};
+
+// ߵܱŵĿѰַϣ̽⣬ͰֱӴŹ淶߼Ű˳䣬֧ɾ
+class EdgeIndex
+{
+public:
+	int count() const { return keys.count(); }
+	bool isEmpty() const { return keys.isEmpty(); }
+	void reserve(int edgeNum);
+	void clear();
+	int find(quint32 v0, quint32 v1) const;
+	int insert(quint32 v0, quint32 v1, bool* inserted = nullptr);
+	Edge edge(int edgeId) const { return Edge{ quint32(keys[edgeId] >> 32), quint32(keys[edgeId]) }; }
+	qint64 memoryUsage() const;
+
+private:
+	struct Bucket
+	{
+		quint64 key;
+		qint32 edgeId;
+	};
+
+	static quint32 hash(quint64 key);
+	void rehash(int bucketNum);
+
+	QVector<quint64> keys;
+	QVector<Bucket> buckets;	// ͰΪ2ݣΪ-1ʾͰ
+};
+
+// ԱΪĹϣֵ߱ųܴ
+template <typename T>
+class EdgeHashMap
+{
+public:
+	int count() const { return index.count(); }
+	bool isEmpty() const { return index.isEmpty(); }
+	void reserve(int edgeNum) { index.reserve(edgeNum); values.reserve(edgeNum); }
+	void clear() { index.clear(); values.clear(); }
+	int find(const Edge& edge) const { return index.find(edge.vertices[0], edge.vertices[1]); }
+	bool contains(const Edge& edge) const { return find(edge) >= 0; }
+	Edge edge(int edgeId) const { return index.edge(edgeId); }
+	T& value(int edgeId) { return values[edgeId]; }
+	const T& value(int edgeId) const { return values[edgeId]; }
+
+	// ߲ʱĬֵ룬ر߱
+	int insert(const Edge& edge)
+	{
+		bool inserted;
+		int edgeId = index.insert(edge.vertices[0], edge.vertices[1], &inserted);
+		if (inserted)
+		{
+			values.append(T());
+		}
+		return edgeId;
+	}
+
+	int insert(const Edge& edge, const T& value)
+	{
+		int edgeId = insert(edge);
+		values[edgeId] = value;
+		return edgeId;
+	}
+
+	T& operator[](const Edge& edge)
+	{
+		return values[insert(edge)];
+	}
+
+	// ߲ʱĬֵ
+	const T& operator[](const Edge& edge) const
+	{
+		static const T defaultValue = T();
+		int edgeId = find(edge);
+		return edgeId >= 0 ? values[edgeId] : defaultValue;
+	}
+
+private:
+	EdgeIndex index;
+	QVector<T> values;
+};
+
 struct Face
 {
 	std::array<uint32_t, 3> vertices;
 	std::array<Edge, 3> edges;
 	Bound bound;
-	bool visited = false;
 };
 
 struct Mesh
 {
 	QVector<QVector3D> vertices;
-	QMap<Edge, QVector<uint32_t>> edges;
+	EdgeHashMap<EdgeFaces> edges;
 	QVector<Face> faces;
 
+	// ڽӱCSRiߵ˳гñߵ漰ñߵıţ
+	// ߽߼¼һΪkInvalidIndex
+	QVector<qint32> adjacencyOffsets;
+	QVector<uint32_t> adjacentFaces;
+	QVector<qint32> adjacentEdges;
+
 	void clear()
 	{
 		vertices.clear();
 		edges.clear();
 		faces.clear();
+		adjacencyOffsets.clear();
+		adjacentFaces.clear();
+		adjacentEdges.clear();
 	}
 };
 
@@ -99,29 +215,114 @@ struct ClipLine
 	QList<QVector3D> vertices;
 };
 
-struct BVHTreeNode
+// հΧУ24ֽڣǵ
+struct AABB
 {
-	QVector<uint32_t> zones;
-	QVector<uint32_t> faces;
+	QVector3D min = kMaxVec3;
+	QVector3D max = kMinVec3;
 
-	Bound bound;
-	BVHTreeNode* children[2] = { nullptr, nullptr };
-	int depth = 0;
-	bool isLeaf = false;
+	QVector3D centriod() const { return (min + max) * 0.5f; }
+	int maxDim() const;
+	float surfaceArea() const;
+	void combine(const QVector3D& position);
+	void combine(const AABB& bound);
+	bool intersect(const Plane& plane) const;
+	bool intersect(const Ray& ray) const;
+	bool contain(const QVector3D& point) const;
+	Bound toBound() const;
+};
+
+// bvhڵ㣺ҶڵͼԪΪprimitives[offset, offset + primitiveNum)
+// ڲڵӽڵoffsetΪӽڵı
+struct LinearBVHNode
+{
+	AABB bound;
+	qint32 offset;
+	qint32 primitiveNum;
+
+	bool isLeaf() const { return primitiveNum > 0; }
+};
+
+// bvhڵ㰴˳飬ҶڵùͼԪ飩
+struct LinearBVH
+{
+	QVector<LinearBVHNode> nodes;
+	QVector<uint32_t> primitives;
+	QVector<quint64> groupMasks;	// ԪڵеԪλǣΪʱ
+
+	bool isEmpty() const { return nodes.isEmpty(); }
+	AABB bound() const { return nodes.isEmpty() ? AABB() : nodes[0].bound; }
+	quint64 groupMask(int index) const { return groupMasks.isEmpty() ? kAllZoneGroups : groupMasks[index]; }
+	bool isValid(int primitiveNum) const;
+	void clear();
+	qint64 memoryUsage() const;
+};
+
+// е˵㼰ͼԪ
+struct IntervalEntry
+{
+	float value;
+	uint32_t primitive;
+};
+
+// ڵ㣺centerλڶ˵[offset, offset + intervalNum)
+// lowerEntriesа½upperEntriesаϽ罵ţ
+// Ͻ綼Сcenter½綼center-1ʾӽڵ
+struct IntervalTreeNode
+{
+	float center;
+	qint32 offset;
+	qint32 intervalNum;
+	qint32 left;
+	qint32 right;
+};
+
+// ֵڵ㰴˳飩
+// ѯֵΧֵȫͼԪӶO(log n + k)
+struct IntervalTree
+{
+	QVector<IntervalTreeNode> nodes;
+	QVector<IntervalEntry> lowerEntries;
+	QVector<IntervalEntry> upperEntries;
+
+	bool isEmpty() const { return nodes.isEmpty(); }
+	void clear();
+	qint64 memoryUsage() const;
+};
+
+// ڵֶΣ˳EDBһ
+enum ResultFieldType
+{
+	FieldUSUM, FieldUX, FieldUY, FieldUZ,
+	FieldEPTOX, FieldEPTOY, FieldEPTOZ, FieldEPTOXY, FieldEPTOYZ, FieldEPTOXZ,
+	FieldS1, FieldS2, FieldS3,
+	FieldSX, FieldSY, FieldSZ, FieldSXY, FieldSYZ, FieldSXZ,
+	ResultFieldTypeNum
 };
 
+// 桢ֵ桢ֵ߼صĶ㣨꼰ʾֶεֵGPU沼һ£
 struct NodeVertex
 {
 	QVector3D position;
-	float totalDeformation = 0.0f;
-	QVector3D deformation;
-	QVector3D normalElasticStrain;
-	QVector3D shearElasticStrain;
-	float maximumPrincipalStress = 0.0f;
-	float middlePrincipalStress = 0.0f;
-	float minimumPrincipalStress = 0.0f;
-	QVector3D normalStress;
-	QVector3D shearStress;
+	float value = 0.0f;
+};
+
+// ڵԣṹֶΰֶηֱţ㷨ֻõ飻λֶγפֶδʱΪգ
+struct NodeAttributes
+{
+	QVector<QVector3D> positions;
+	std::array<QVector<float>, ResultFieldTypeNum> fields;
+	int displayField = FieldUSUM;
+
+	int count() const;
+	void resize(int nodeNum);
+	void clear();
+	bool hasField(int field) const;
+	QVector<float>& field(int field);
+	const QVector<float>& values() const;	// ʾֶΣĬΪλƣ
+	bool hasDeformation() const;
+	void deform(float scale, QVector<QVector3D>& deformedPositions) const;	// ڵλƳԷŴϵ
+	qint64 memoryUsage() const;	// ֽ
 };
 
 struct ValueRange
@@ -182,6 +383,10 @@ struct ValueRange
 		minShearStress = kMaxVec3;
 		maxShearStress = kMinVec3;
 	}
+
+	// ֶδȡֵΧֶ״μʱ¼
+	void setFieldRange(int field, float minValue, float maxValue);
+	QVector2D getFieldRange(int field) const;
 };
 
 enum ZoneType
@@ -203,34 +408,100 @@ struct Facet
 	quint32 indices[4];
 
 	QSet<Edge> getEdges() const;
-	bool intersect(const QVector<NodeVertex>& nodeVertices, const Ray& ray, float& t) const;
+	bool intersect(const QVector<QVector3D>& positions, const Ray& ray, float& t) const;
 
 private:
-	bool intersect(const QVector<NodeVertex>& nodeVertices, quint32 i0, quint32 i1, quint32 i2, const Ray& ray, float& t) const;
+	bool intersect(const QVector<QVector3D>& positions, quint32 i0, quint32 i1, quint32 i2, const Ray& ray, float& t) const;
 };
 
+// õĵԪ¼͡ڵ㼰飩غת浽ZoneSet
 struct Zone
 {
 	ZoneType type;
 	int vertexNum;
-	int edgeNum;
 	quint32 vertices[8];
-	quint32 edges[24];
-	QVector<Facet> facets;
-	static int facetID;
+	int group = 0;
 
-	Bound bound;
-	bool visited = false;
+	bool isValid() const;
+};
 
-	float values[8];
-	QMatrix4x4 invertedBasisMatrix;
-	QVector<Plane> planes;
-	QVector3D origin;
+// Ԫ͵˱Ԫıߡ漰ֵǵƵԪ洢
+struct ZoneTopology
+{
+	int vertexNum;
+	int edgeNum;
+	int facetNum;
+	int edges[12][2];
+	int facetSizes[6];
+	int facets[6][4];
+	int corners[8];		// Բֵ8ǵӦĵԪڵ㣨˻Ԫظʹýڵ㣩
+};
 
+const int kZoneVertexStride = 8;
+const int kZonePlaneStride = 6;
+
+// Ԫϣṹ鲼֣еԪðԪѰַƽ̹飩
+struct ZoneSet
+{
+	QVector<quint8> types;
+	QVector<qint32> groups;
+	QVector<quint32> vertices;			// ÿԪkZoneVertexStride
+	QVector<QVector3D> boundMins;
+	QVector<QVector3D> boundMaxs;
+	QVector<QVector4D> planes;			// ÿԪkZonePlaneStridexyzΪwΪԭľ룬ʱ
+	QVector<QVector3D> origins;
+	QVector<QVector3D> invertedBases;	// ÿԪ3
+	QVector<float> nodeValues;			// ڵݹռڴ
+
+	// ȫΨһߣСڵǰԪ߱ŵCSRԪı߰˱˳У
+	// ֿģеĵԪӼֻ߱ţ
+	QVector<Edge> edges;
+	QVector<qint32> edgeOffsets;
+	QVector<quint32> edgeIds;
+
+	static const ZoneTopology& topology(int type);
+
+	int count() const { return types.count(); }
+	bool isEmpty() const { return types.isEmpty(); }
 	bool isValid() const;
-	void cache(const QVector<NodeVertex>& nodeVertices);
-	bool contain(const QVector3D& point) const;
-	bool interp(const QVector3D& point, float& value) const;
+	void reserve(int zoneNum);
+	void clear();
+	bool append(const Zone& zone, const QVector<QVector3D>& positions);
+	void append(const ZoneSet& zoneSet, int zoneIndex);
+	void updateGeometry(const QVector<QVector3D>& positions, int zoneBegin, int zoneEnd);	// ڵƶ¼㵥ԪİΧС淽̼
+	void buildEdges();
+	Zone zone(int zoneIndex) const;
+
+	ZoneType type(int zoneIndex) const { return (ZoneType)types[zoneIndex]; }
+	int group(int zoneIndex) const { return groups[zoneIndex]; }
+	int vertexNum(int zoneIndex) const { return topology(types[zoneIndex]).vertexNum; }
+	const quint32* zoneVertices(int zoneIndex) const { return vertices.constData() + zoneIndex * kZoneVertexStride; }
+	int edgeNum(int zoneIndex) const { return topology(types[zoneIndex]).edgeNum; }
+	Edge edge(int zoneIndex, int edgeIndex) const;
+	const quint32* zoneEdgeIds(int zoneIndex) const { return edgeIds.constData() + edgeOffsets[zoneIndex]; }
+	int facetNum(int zoneIndex) const { return topology(types[zoneIndex]).facetNum; }
+	Facet facet(int zoneIndex, int facetIndex) const;
+	Bound bound(int zoneIndex) const;
+	QVector3D centriod(int zoneIndex) const { return (boundMins[zoneIndex] + boundMaxs[zoneIndex]) * 0.5f; }
+
+	void cacheValues(const QVector<float>& nodeValues);
+	bool contain(int zoneIndex, const QVector3D& point) const;
+	bool interp(int zoneIndex, const QVector3D& point, float& value) const;
+	QVector3D localCoords(int zoneIndex, const QVector3D& point) const;
+	float interpValue(int zoneIndex, const QVector3D& coords) const;
+
+	qint64 memoryUsage() const;	// ֽڣĽڵֵ
+};
+
+struct ZoneGroup
+{
+	QString name;
+
+	// 鵥ԪzoneIndices/wireframeIndicesе
+	int zoneIndexBegin = 0;
+	int zoneIndexNum = 0;
+	int wireframeIndexBegin = 0;
+	int wireframeIndexNum = 0;
 };
 
 struct UniformGrids
@@ -240,13 +511,31 @@ struct UniformGrids
 	QVector<NodeVertex> points;
 	QVector<float> voxelData;
 
+	// ڵԪԪھֲ꣬뼸أڽ仯ʱ²ֵ
+	QVector<uint32_t> sampleZones;
+	QVector<QVector3D> sampleCoords;
+
+	// ؿ飨ÿkVoxelBlockSize^3صԪֵΧֵ
+	IntervalTree blockTree;
+
+	QVector3D position(int x, int y, int z) const;
+	std::array<int, 3> blockDim() const;
 	void clear()
 	{
 		points.clear();
 		voxelData.clear();
+		sampleZones.clear();
+		sampleCoords.clear();
+		blockTree.clear();
 	}
 };
 
+// Ԫеλλ鹲һλ
+inline quint64 qZoneGroupBit(int group)
+{
+	return 1ull << qBound(0, group, kMaxZoneGroupNum - 1);
+}
+
 // Edgeغ͹ϣ
 inline bool operator<(const Edge& lhs, const Edge& rhs)
 {
@@ -324,28 +613,12 @@ inline QVector3D qMaxVec3(const QVector3D& lhs, const QVector3D& rhs)
 
 inline float qMax3(float a, float b, float c)
 {
-	if (a > b && a > c)
-	{
-		return a;
-	}
-	if (b > a && b > c)
-	{
-		return b;
-	}
-	return c;
+	return qMax(qMax(a, b), c);
 }
 
 inline float qMin3(float a, float b, float c)
 {
-	if (a < b && a < c)
-	{
-		return a;
-	}
-	if (b < a && b < c)
-	{
-		return b;
-	}
-	return c;
+	return qMin(qMin(a, b), c);
 }
 
 template <typename T>
@@ -1,11 +1,17 @@
 #include "geoutil.h"
-#include <QQueue>
 #include <QFile>
 #include <QTextStream>
 #include <QElapsedTimer>
+#include <QDebug>
+#include <QThread>
+#include <QThreadPool>
+#include <QFutureSynchronizer>
+#include <QtConcurrent>
 #include <QtAlgorithms>
 #include <algorithm>
+#include <limits>
 #include <fstream>
+#include <dualmc/dualmc.h>
 
 // GeoUtilԱʵ
 void GeoUtil::loadObjMesh(const char* fileName, Mesh& mesh)
@@ -64,21 +70,13 @@ void GeoUtil::addFace(Mesh& mesh, uint32_t v0, uint32_t v1, uint32_t v2)
 	mesh.faces.append(Face{ v0, v1, v2 });
 	Face& face = mesh.faces.back();
 
+	// ıͳһ¼Ϊ淶Сڵǰ
 	Edge edges[3] = { { v0, v1 }, { v1, v2 }, { v0, v2 } };
 	for (int j = 0; j < 3; ++j)
 	{
-		Edge& edge = edges[j];
-		auto iter = mesh.edges.find(edge);
-		if (iter == mesh.edges.end())
-		{
-			mesh.edges.insert(edge, { faceIndex });
-		}
-		else
-		{
-			edge = iter.key();
-			iter.value().append(faceIndex);
-		}
-		face.edges[j] = edge;
+		int edgeId = mesh.edges.insert(edges[j]);
+		mesh.edges.value(edgeId).append(faceIndex);
+		face.edges[j] = mesh.edges.edge(edgeId);
 	}
 
 	for (uint32_t v : face.vertices)
@@ -90,14 +88,16 @@ void GeoUtil::addFace(Mesh& mesh, uint32_t v0, uint32_t v1, uint32_t v2)
 
 void GeoUtil::cleanMesh(Mesh& mesh)
 {
-	traverseMesh(mesh);
+	buildFaceAdjacency(mesh);
+	QBitArray connected = traverseMesh(mesh);
 
 	// ɾϷظ ||  || Σ
 	QSet<Face> uniqueFaces;
 	QVector<Face> invalidFaces;
 	QVector<Face> validFaces;
-	QMap<Edge, QVector<uint32_t>> validEdges;
-	QMap<Edge, QVector<uint32_t>> invalidEdges;
+	EdgeHashMap<EdgeFaces> validEdges;
+	EdgeHashMap<EdgeFaces> invalidEdges;
+	validEdges.reserve(mesh.edges.count());
 	int validFaceIndex = 0;
 	int invalidFaceIndex = 0;
 
@@ -116,7 +116,7 @@ void GeoUtil::cleanMesh(Mesh& mesh)
 		{
 			invalidFaceCounter[0]++;
 		}
-		if (!face.visited)
+		if (!connected.testBit(i))
 		{
 			invalidFaceCounter[1]++;
 		}
@@ -125,7 +125,7 @@ void GeoUtil::cleanMesh(Mesh& mesh)
 			invalidFaceCounter[2]++;
 		}
 
-		if (existed || !face.visited || !isManifordFace(mesh, face))
+		if (existed || !connected.testBit(i) || !isManifordFace(mesh, face))
 		{
 			for (Edge& edge : face.edges)
 			{
@@ -151,64 +151,167 @@ void GeoUtil::cleanMesh(Mesh& mesh)
 	mesh.edges = validEdges;
 	//mesh.faces = invalidFaces;
 	//mesh.edges = invalidEdges;
+	buildFaceAdjacency(mesh);
 }
 
-void GeoUtil::fixWindingOrder(Mesh& mesh)
+void GeoUtil::buildFaceAdjacency(Mesh& mesh)
 {
-	// ñ
-	resetMeshVisited(mesh);
-
-	QQueue<uint32_t> queue;
-	queue.enqueue(0);
-	mesh.faces[0].visited = true;
-	
-	while (!queue.isEmpty())
+	int faceNum = mesh.faces.count();
+	mesh.adjacencyOffsets.resize(faceNum + 1);
+	mesh.adjacentFaces.clear();
+	mesh.adjacentEdges.clear();
+	mesh.adjacentFaces.reserve(faceNum * 3);
+	mesh.adjacentEdges.reserve(faceNum * 3);
+	for (int i = 0; i < faceNum; ++i)
 	{
-		const Face& mainFace = mesh.faces[queue.dequeue()];
-		for (const Edge& edge : mainFace.edges)
+		mesh.adjacencyOffsets[i] = mesh.adjacentFaces.count();
+		for (const Edge& edge : mesh.faces[i].edges)
 		{
-			for (uint32_t f : mesh.edges[edge])
+			int edgeId = mesh.edges.find(edge);
+			bool shared = false;
+			for (uint32_t f : mesh.edges.value(edgeId))
 			{
-				Face& neighborFace = mesh.faces[f];
-				if (!neighborFace.visited)
+				if (f != (uint32_t)i)
 				{
-					neighborFace.visited = true;
-					fixWindingOrder(mesh, mainFace, neighborFace);
-					queue.enqueue(f);
+					mesh.adjacentFaces.append(f);
+					mesh.adjacentEdges.append(edgeId);
+					shared = true;
 				}
 			}
+
+			if (!shared)
+			{
+				mesh.adjacentFaces.append(kInvalidIndex);
+				mesh.adjacentEdges.append(edgeId);
+			}
+		}
+	}
+	mesh.adjacencyOffsets[faceNum] = mesh.adjacentFaces.count();
+}
+
+void GeoUtil::fixWindingOrder(Mesh& mesh)
+{
+	if (mesh.faces.isEmpty())
+	{
+		return;
+	}
+
+	// ڽӱȱΪͨ
+	QBitArray visited(mesh.faces.count());
+	QVector<uint32_t> queue;
+	queue.reserve(mesh.faces.count());
+	queue.append(0);
+	visited.setBit(0);
+
+	for (int head = 0; head < queue.count(); ++head)
+	{
+		uint32_t mainFace = queue[head];
+		for (int i = mesh.adjacencyOffsets[mainFace]; i < mesh.adjacencyOffsets[mainFace + 1]; ++i)
+		{
+			uint32_t f = mesh.adjacentFaces[i];
+			if (f != kInvalidIndex && !visited.testBit(f))
+			{
+				visited.setBit(f);
+				fixWindingOrder(mesh, mesh.faces[mainFace], mesh.faces[f]);
+				queue.append(f);
+			}
 		}
 	}
 }
 
-void GeoUtil::clipZones(QVector<Zone>& zones, const Plane& plane, BVHTreeNode* root, QVector<NodeVertex>& nodeVertices, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices)
+template <typename NodeTest, typename LeafVisitor>
+bool GeoUtil::traverseBVH(const LinearBVH& tree, NodeTest nodeTest, LeafVisitor leafVisitor)
 {
-	resetZoneVisited(zones);
-	resetBVHTree(root);
+	// ջݹ飺ͨڲڵֱӽӽڵ㣬ӽڵջ
+	// ֤ҵķ˳ǰʱӽڵ㲻ᱻ
+	if (tree.isEmpty())
+	{
+		return false;
+	}
 
+	QVarLengthArray<int, kBVHStackSize> stack;
+	int index = 0;
+	while (true)
+	{
+		const LinearBVHNode& node = tree.nodes[index];
+		if (nodeTest(index))
+		{
+			if (!node.isLeaf())
+			{
+				stack.append(node.offset);
+				index = index + 1;
+				continue;
+			}
+
+			if (leafVisitor(tree.primitives.constData() + node.offset, node.primitiveNum))
+			{
+				return true;
+			}
+		}
+
+		if (stack.isEmpty())
+		{
+			return false;
+		}
+		index = stack.last();
+		stack.removeLast();
+	}
+}
+
+template <typename Visitor>
+void GeoUtil::queryIntervalTree(const IntervalTree& tree, float value, Visitor visitor)
+{
+	// ֵСڷֵֽʱڵ½粻ֵ䶼ֵֻѯ
+	// ڷֵֽʱԳƵذϽѯڷֵֽʱе䶼ֵ
+	// ˵ÿڵһʱֵΪNaNʱͼԪ
+	int index = tree.isEmpty() ? -1 : 0;
+	while (index >= 0)
+	{
+		const IntervalTreeNode& node = tree.nodes[index];
+		if (value < node.center)
+		{
+			const IntervalEntry* entries = tree.lowerEntries.constData() + node.offset;
+			for (int i = 0; i < node.intervalNum && entries[i].value <= value; ++i)
+			{
+				visitor(entries[i].primitive);
+			}
+			index = node.left;
+		}
+		else
+		{
+			const IntervalEntry* entries = tree.upperEntries.constData() + node.offset;
+			for (int i = 0; i < node.intervalNum && entries[i].value >= value; ++i)
+			{
+				visitor(entries[i].primitive);
+			}
+			index = value > node.center ? node.right : -1;
+		}
+	}
+}
+
+void GeoUtil::clipZones(const ZoneSet& zones, const Plane& plane, const LinearBVH& tree, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices, quint64 groupMask)
+{
 	sectionVertices.clear();
 	sectionIndices.clear();
 	sectionWireframeIndices.clear();
-	QMap<Edge, uint32_t> intersectionIndexMap;
-	QSet<Edge> sectionWireframes;
+	QVector<uint32_t> edgeIntersections(zones.edges.count(), kInvalidIndex);
+	EdgeIndex sectionWireframes;
 
-	clipZones(zones, plane, root, nodeVertices, intersectionIndexMap, sectionVertices, sectionIndices, sectionWireframes);
+	clipZones(zones, plane, tree, positions, nodeValues, edgeIntersections, sectionVertices, sectionIndices, sectionWireframes, groupMask);
 
-	for (const Edge& edge : sectionWireframes)
+	for (int i = 0; i < sectionWireframes.count(); ++i)
 	{
+		Edge edge = sectionWireframes.edge(i);
 		sectionWireframeIndices.append({ edge.vertices[0], edge.vertices[1] });
 	}
 }
 
-void GeoUtil::pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* root, const QVector<NodeVertex>& nodeVertices, QVector<uint32_t>& pickIndices, bool pickZoneMode)
+void GeoUtil::pickZone(const ZoneSet& zones, const Ray& ray, const LinearBVH& tree, const QVector<QVector3D>& positions, QVector<uint32_t>& pickIndices, bool pickZoneMode, quint64 groupMask)
 {
-	resetZoneVisited(zones);
-	resetBVHTree(root);
-
 	pickIndices.clear();
 	QMap<float, QSet<Edge>> pickEdgesMap;
 
-	pickZone(zones, ray, root, nodeVertices, pickEdgesMap, pickZoneMode);
+	pickZone(zones, ray, tree, positions, pickEdgesMap, pickZoneMode, groupMask);
 
 	if (!pickEdgesMap.empty())
 	{
@@ -219,44 +322,51 @@ void GeoUtil::pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* root,
 	}
 }
 
-QVector<ClipLine> GeoUtil::genIsolines(Mesh& mesh, QVector<NodeVertex>& nodeVertices, float value, BVHTreeNode* root)
+QVector<ClipLine> GeoUtil::genIsolines(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, float value, const IntervalTree& tree)
 {
 	QVector<ClipLine> clipLines;
-	resetMeshVisited(mesh);
-	resetBVHTree(root);
 
 	QElapsedTimer profileTimer;
 	profileTimer.start();
-	QMap<Edge, QVector3D> hits;
-	findAllIsoEdges(mesh, nodeVertices, value, root, hits);
-	resetMeshVisited(mesh);
+	IsoEdgeHits hits;
+	hits.edgeHits.fill(-1, mesh.edges.count());
+	findAllIsoEdges(mesh, positions, nodeValues, value, tree, hits);
+	QBitArray faceVisited(mesh.faces.count());
 	qint64 t0 = profileTimer.restart();
 
-	while (!hits.isEmpty())
+	// 㲻ɾֵߵĽ㰴űǣ棬ٰڽӱ
+	QBitArray hitUsed(hits.edges.count());
+	QVector<QPair<qint32, bool>> queue;
+	for (int start = 0; start < hits.edges.count(); ++start)
 	{
+		if (hitUsed.testBit(start))
+		{
+			continue;
+		}
+
 		ClipLine clipLine;
-		QQueue<QPair<Edge, bool>> queue;
-		queue.enqueue({ hits.begin().key(), true });
-		clipLine.vertices.push_front(hits.begin().value());
-		hits.remove(hits.begin().key());
+		queue.clear();
+		queue.append({ hits.edges[start], true });
+		clipLine.vertices.push_front(hits.positions[start]);
+		hitUsed.setBit(start);
 
-		while (!queue.isEmpty())
+		for (int head = 0; head < queue.count(); ++head)
 		{
-			QPair<Edge, bool> pair = queue.dequeue();
-			const Edge& mainEdge = pair.first;
-			bool positive = pair.second;
-			for (uint32_t f : mesh.edges[mainEdge])
+			qint32 mainEdge = queue[head].first;
+			bool positive = queue[head].second;
+			for (uint32_t f : mesh.edges.value(mainEdge))
 			{
-				Face& neighborFace = mesh.faces[f];
-				if (!neighborFace.visited)
+				if (!faceVisited.testBit(f))
 				{
-					neighborFace.visited = true;
+					faceVisited.setBit(f);
 
-					for (const Edge& neighborEdge : neighborFace.edges)
+					for (int i = mesh.adjacencyOffsets[f]; i < mesh.adjacencyOffsets[f + 1]; ++i)
 					{
-						if (!(neighborEdge == mainEdge) && hits.contains(neighborEdge))
+						qint32 neighborEdge = mesh.adjacentEdges[i];
+						int hit = neighborEdge == mainEdge ? -1 : hits.edgeHits[neighborEdge];
+						if (hit >= 0 && !hitUsed.testBit(hit))
 						{
-							QVector3D intersection = hits[neighborEdge];
+							const QVector3D& intersection = hits.positions[hit];
 							if (positive)
 							{
 								if (!qIsNearlyEqual(intersection, clipLine.vertices.back()))
@@ -272,8 +382,8 @@ QVector<ClipLine> GeoUtil::genIsolines(Mesh& mesh, QVector<NodeVertex>& nodeVert
 								}
 							}
 
-							hits.remove(neighborEdge);
-							queue.enqueue({ neighborEdge, positive });
+							hitUsed.setBit(hit);
+							queue.append({ neighborEdge, positive });
 							positive = !positive;
 
 							break;
@@ -292,49 +402,34 @@ QVector<ClipLine> GeoUtil::genIsolines(Mesh& mesh, QVector<NodeVertex>& nodeVert
 	return clipLines;
 }
 
-void GeoUtil::findAllIsoEdges(Mesh& mesh, QVector<NodeVertex>& nodeVertices, float value, BVHTreeNode* node, QMap<Edge, QVector3D>& hits)
+void GeoUtil::findAllIsoEdges(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, float value, const IntervalTree& tree, IsoEdgeHits& hits)
 {
-	if (node->isLeaf)
+	// ֵֻΧֵ棬ÿֻλһڵУҪʱ
+	queryIntervalTree(tree, value, [&](uint32_t face)
 	{
-		for (uint32_t f : node->faces)
-		{
-			Face& face = mesh.faces[f];
-			if (!face.visited)
-			{
-				face.visited = true;
-				findIsoEdges(mesh, nodeVertices, mesh.faces[f], value, hits);
-			}
-		}
-	}
-	else
-	{
-		QVector3D isoPoint(value, value, value);
-		if (node->children[0]->bound.contain(isoPoint))
-		{
-			findAllIsoEdges(mesh, nodeVertices, value, node->children[0], hits);
-		}
-		if (node->children[1]->bound.contain(isoPoint))
-		{
-			findAllIsoEdges(mesh, nodeVertices, value, node->children[1], hits);
-		}
-	}
+		findIsoEdges(mesh, positions, nodeValues, face, value, hits);
+	});
 }
 
-void GeoUtil::findIsoEdges(const Mesh& mesh, QVector<NodeVertex>& nodeVertices, const Face& face, float value, QMap<Edge, QVector3D>& hits)
+void GeoUtil::findIsoEdges(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, int faceIndex, float value, IsoEdgeHits& hits)
 {
-	for (const Edge& edge : face.edges)
+	for (int i = mesh.adjacencyOffsets[faceIndex]; i < mesh.adjacencyOffsets[faceIndex + 1]; ++i)
 	{
-		if (hits.contains(edge))
+		qint32 edgeId = mesh.adjacentEdges[i];
+		if (hits.edgeHits[edgeId] >= 0)
 		{
 			continue;
 		}
 
-		const NodeVertex& nv0 = nodeVertices[edge.vertices[0]];
-		const NodeVertex& nv1 = nodeVertices[edge.vertices[1]];
-		if ((value - nv0.totalDeformation) * (value - nv1.totalDeformation) <= 0)
+		Edge edge = mesh.edges.edge(edgeId);
+		float value0 = nodeValues[edge.vertices[0]];
+		float value1 = nodeValues[edge.vertices[1]];
+		if ((value - value0) * (value - value1) <= 0)
 		{
-			QVector3D intersection = qLerp(nv0.position, nv1.position, (value - nv0.totalDeformation) / (nv1.totalDeformation - nv0.totalDeformation));
-			hits[edge] = intersection;
+			QVector3D intersection = qLerp(positions[edge.vertices[0]], positions[edge.vertices[1]], (value - value0) / (value1 - value0));
+			hits.edgeHits[edgeId] = hits.edges.count();
+			hits.edges.append(edgeId);
+			hits.positions.append(intersection);
 		}
 	}
 }
@@ -360,33 +455,45 @@ void GeoUtil::flipWindingOrder(Face& face)
 	qSwap(face.vertices[0], face.vertices[1]);
 }
 
-bool GeoUtil::clipZone(const Zone& zone, const Plane& plane, QVector<NodeVertex>& nodeVertices, QMap<Edge, uint32_t>& intersectionIndexMap, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QSet<Edge>& sectionWireframes)
+bool GeoUtil::clipZone(const ZoneSet& zones, int zoneIndex, const Plane& plane, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<uint32_t>& edgeIntersections, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, EdgeIndex& sectionWireframes)
 {
+	// ȫֱ߱ż¼㣬Ѽıߣཻıߣظ㣻
+	// ͳһСڵǰ󽻣ڵԪͬһߵĽһ
 	QVector<uint32_t> intersectionIndices;
-	for (int i = 0; i < zone.edgeNum; ++i)
+	const quint32* edgeIds = zones.zoneEdgeIds(zoneIndex);
+	int edgeNum = zones.edgeNum(zoneIndex);
+	for (int i = 0; i < edgeNum; ++i)
 	{
-		Edge edge{ zone.edges[i * 2], zone.edges[i * 2 + 1] };
-		if (intersectionIndexMap.contains(edge))
+		uint32_t& edgeIntersection = edgeIntersections[edgeIds[i]];
+		if (edgeIntersection == kNoIntersection)
 		{
-			uint32_t index = intersectionIndexMap[edge];
-			intersectionIndices.append(index);
+			continue;
+		}
+		else if (edgeIntersection != kInvalidIndex)
+		{
+			intersectionIndices.append(edgeIntersection);
 		}
 		else
 		{
-			const NodeVertex& nv0 = nodeVertices[edge.vertices[0]];
-			const NodeVertex& nv1 = nodeVertices[edge.vertices[1]];
-			QVector3D v0 = nv0.position;
-			QVector3D v1 = nv1.position;
+			Edge edge = zones.edge(zoneIndex, i);
+			if (edge.vertices[0] > edge.vertices[1])
+			{
+				qSwap(edge.vertices[0], edge.vertices[1]);
+			}
+			QVector3D v0 = positions[edge.vertices[0]];
+			QVector3D v1 = positions[edge.vertices[1]];
 			QVector3D v01 = v1 - v0;
 			float dnv01 = QVector3D::dotProduct(plane.normal, v01);
 			if (qFuzzyIsNull(dnv01))
 			{
+				edgeIntersection = kNoIntersection;
 				continue;
 			}
 
 			float t = (plane.dist - QVector3D::dotProduct(plane.normal, v0)) / dnv01;
 			if (t < 0.0f || t > 1.0f)
 			{
+				edgeIntersection = kNoIntersection;
 				continue;
 			}
 
@@ -394,12 +501,12 @@ bool GeoUtil::clipZone(const Zone& zone, const Plane& plane, QVector<NodeVertex>
 
 			NodeVertex nodeVertex;
 			nodeVertex.position = intersection;
-			nodeVertex.totalDeformation = qLerp(nv0.totalDeformation, nv1.totalDeformation, t);
+			nodeVertex.value = qLerp(nodeValues[edge.vertices[0]], nodeValues[edge.vertices[1]], t);
 
 			uint32_t index = sectionVertices.count();
 			intersectionIndices.append(index);
 			sectionVertices.append(nodeVertex);
-			intersectionIndexMap[edge] = index;
+			edgeIntersection = index;
 		}
 	}
 
@@ -424,7 +531,7 @@ bool GeoUtil::clipZone(const Zone& zone, const Plane& plane, QVector<NodeVertex>
 	// 
 	for (int i = 0; i < intersectionIndices.count(); ++i)
 	{
-		sectionWireframes.insert({ intersectionIndices[i], intersectionIndices[(i + 1) % intersectionIndices.count()] });
+		sectionWireframes.insert(intersectionIndices[i], intersectionIndices[(i + 1) % intersectionIndices.count()]);
 	}
 
 	return true;
@@ -443,61 +550,142 @@ bool GeoUtil::isManifordFace(const Mesh& mesh, const Face& face, bool strict)
 	return true;
 }
 
-void GeoUtil::traverseMesh(Mesh& mesh)
+QBitArray GeoUtil::traverseMesh(const Mesh& mesh)
 {
-	// ñ
-	resetMeshVisited(mesh);
+	// ڽӱ棬ؿɵ
+	QBitArray visited(mesh.faces.count());
+	if (mesh.faces.isEmpty())
+	{
+		return visited;
+	}
 
-	// 
-	QQueue<uint32_t> queue;
-	queue.enqueue(0);
-	mesh.faces[0].visited = true;
+	QVector<uint32_t> queue;
+	queue.reserve(mesh.faces.count());
+	queue.append(0);
+	visited.setBit(0);
 
-	while (!queue.isEmpty())
+	for (int head = 0; head < queue.count(); ++head)
 	{
-		const Face& mainFace = mesh.faces[queue.dequeue()];
-		for (const Edge& edge : mainFace.edges)
+		uint32_t mainFace = queue[head];
+		for (int i = mesh.adjacencyOffsets[mainFace]; i < mesh.adjacencyOffsets[mainFace + 1]; ++i)
 		{
-			for (uint32_t f : mesh.edges[edge])
+			uint32_t f = mesh.adjacentFaces[i];
+			if (f != kInvalidIndex && !visited.testBit(f))
 			{
-				Face& neighborFace = mesh.faces[f];
-				if (!neighborFace.visited)
-				{
-					neighborFace.visited = true;
-					queue.enqueue(f);
-				}
+				visited.setBit(f);
+				queue.append(f);
 			}
 		}
 	}
+	return visited;
 }
 
-void GeoUtil::resetMeshVisited(Mesh& mesh)
+void GeoUtil::flattenIsolines(const QVector<ClipLine>& clipLines, float value, QVector<NodeVertex>& isolineVertices)
 {
-	for (Face& face : mesh.faces)
+	// ÿֵ߲Ϊ߶Σÿ㹹һ
+	isolineVertices.clear();
+	for (const ClipLine& clipLine : clipLines)
 	{
-		face.visited = false;
+		const QList<QVector3D>& vertices = clipLine.vertices;
+		for (int i = 0; i < vertices.count() - 1; ++i)
+		{
+			isolineVertices.append({ NodeVertex{vertices[i], value}, NodeVertex{vertices[i + 1], value} });
+		}
 	}
 }
 
-void GeoUtil::resetZoneVisited(QVector<Zone>& zones)
+void GeoUtil::genIsosurface(const UniformGrids& uniformGrids, float value, QVector<NodeVertex>& isosurfaceVertices, QVector<uint32_t>& isosurfaceIndices)
 {
-	for (Zone& zone : zones)
+	isosurfaceVertices.clear();
+	isosurfaceIndices.clear();
+
+	// ؿҳֵΧֵĿ飬ֵֻܴЩеصԪ
+	// ЩصԪΧһغȡȡĽͬ
+	const std::array<int, 3>& dim = uniformGrids.dim;
+	std::array<int, 3> begin = { 0, 0, 0 };
+	std::array<int, 3> end = dim;
+	if (!uniformGrids.blockTree.isEmpty())
 	{
-		zone.visited = false;
+		std::array<int, 3> blockDim = uniformGrids.blockDim();
+		std::array<int, 3> cellBegin = dim;
+		std::array<int, 3> cellEnd = { 0, 0, 0 };
+		queryIntervalTree(uniformGrids.blockTree, value, [&](uint32_t block)
+		{
+			std::array<int, 3> blockCoords = { (int)block / (blockDim[1] * blockDim[2]), (int)block / blockDim[2] % blockDim[1], (int)block % blockDim[2] };
+			for (int i = 0; i < 3; ++i)
+			{
+				cellBegin[i] = qMin(cellBegin[i], blockCoords[i] * kVoxelBlockSize);
+				cellEnd[i] = qMax(cellEnd[i], blockCoords[i] * kVoxelBlockSize + kVoxelBlockSize);
+			}
+		});
+		if (cellEnd[0] == 0)
+		{
+			return;
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			begin[i] = cellBegin[i];
+			end[i] = qMin(cellEnd[i] + 2, dim[i]);
+		}
+	}
+
+	// ȡΧСʱΪ
+	std::array<int, 3> subDim = { end[0] - begin[0], end[1] - begin[1], end[2] - begin[2] };
+	const float* voxelData = uniformGrids.voxelData.constData();
+	QVector<float> subVoxelData;
+	if (subDim != dim)
+	{
+		subVoxelData.resize(subDim[0] * subDim[1] * subDim[2]);
+		float* dst = subVoxelData.data();
+		for (int x = begin[0]; x < end[0]; ++x)
+		{
+			for (int y = begin[1]; y < end[1]; ++y, dst += subDim[2])
+			{
+				memcpy(dst, voxelData + (x * dim[1] + y) * dim[2] + begin[2], subDim[2] * sizeof(float));
+			}
+		}
+		voxelData = subVoxelData.constData();
+	}
+
+	dualmc::DualMC<float> builder;
+	std::vector<dualmc::Vertex> vertices;
+	std::vector<dualmc::Quad> quads;
+	builder.build(voxelData,
+		subDim[2], subDim[1], subDim[0],
+		value, false, false, vertices, quads);
+
+	// ӳģ꣬ıβΪ
+	isosurfaceVertices.reserve((int)vertices.size());
+	QVector3D dimVector(dim[0], dim[1], dim[2]);
+	QVector3D offset(begin[0], begin[1], begin[2]);
+	for (const auto& vertex : vertices)
+	{
+		QVector3D position = QVector3D(vertex.z, vertex.y, vertex.x) + offset;
+		position = qMapClampRange(position, QVector3D(0.0f, 0.0f, 0.0f), dimVector, uniformGrids.bound.min, uniformGrids.bound.max);
+		isosurfaceVertices.append({ position, value });
+	}
+
+	isosurfaceIndices.reserve((int)quads.size() * 6);
+	for (const auto& quad : quads)
+	{
+		isosurfaceIndices.append({ (uint32_t)quad.i0, (uint32_t)quad.i1, (uint32_t)quad.i2 });
+		isosurfaceIndices.append({ (uint32_t)quad.i0, (uint32_t)quad.i2, (uint32_t)quad.i3 });
 	}
 }
 
 bool GeoUtil::validateMesh(Mesh& mesh)
 {
-	traverseMesh(mesh);
+	QBitArray connected = traverseMesh(mesh);
 
 	QSet<Face> uniqueFaces;
-	for (Face& face : mesh.faces)
+	for (int i = 0; i < mesh.faces.count(); ++i)
 	{
+		const Face& face = mesh.faces[i];
 		uniqueFaces.insert(face);
 
 		// ͨ
-		if (!face.visited)
+		if (!connected.testBit(i))
 		{
 			return false;
 		}
@@ -518,282 +706,1151 @@ bool GeoUtil::validateMesh(Mesh& mesh)
 	return true;
 }
 
-bool GeoUtil::interpZones(const QVector<Zone>& zones, BVHTreeNode* node, const QVector3D& point, float& value)
+void GeoUtil::benchmarkMeshEdges(const Mesh& mesh)
 {
-	if (node->isLeaf)
+	// ֱԭеѰַϣٰ߲߱ѯμͬķʷʽ
+	QElapsedTimer timer;
+	timer.start();
+	QMap<Edge, QVector<uint32_t>> legacyEdges;
+	for (int i = 0; i < mesh.faces.count(); ++i)
 	{
-		for (uint32_t z : node->zones)
+		for (const Edge& edge : mesh.faces[i].edges)
 		{
-			const Zone& zone = zones[z];
-			if (zone.interp(point, value))
-			{
-				return true;
-			}
+			legacyEdges[edge].append(i);
 		}
-		return false;
 	}
-	else
+	qint64 legacyBuildTime = qMax(timer.restart(), (qint64)1);
+
+	qint64 legacySum = 0;
+	for (const Face& face : mesh.faces)
 	{
-		if (node->children[0]->bound.contain(point) && interpZones(zones, node->children[0], point, value))
+		for (const Edge& edge : face.edges)
 		{
-			return true;
+			legacySum += legacyEdges.value(edge).count();
 		}
-		if (node->children[1]->bound.contain(point) && interpZones(zones, node->children[1], point, value))
+	}
+	qint64 legacyLookupTime = qMax(timer.restart(), (qint64)1);
+
+	EdgeHashMap<EdgeFaces> edges;
+	edges.reserve(mesh.faces.count() * 3 / 2);
+	for (int i = 0; i < mesh.faces.count(); ++i)
+	{
+		for (const Edge& edge : mesh.faces[i].edges)
 		{
-			return true;
+			edges[edge].append(i);
 		}
+	}
+	qint64 buildTime = qMax(timer.restart(), (qint64)1);
 
-		return false;
+	qint64 sum = 0;
+	const EdgeHashMap<EdgeFaces>& constEdges = edges;
+	for (const Face& face : mesh.faces)
+	{
+		for (const Edge& edge : face.edges)
+		{
+			sum += constEdges[edge].count();
+		}
 	}
+	qint64 lookupTime = qMax(timer.restart(), (qint64)1);
+
+	// ıȽϺԲͬı߿ȣ߱ͬʱ˵ԭ߱ڳͻ
+	bool identical = legacyEdges.count() == edges.count() && legacySum == sum;
+	qDebug() << "mesh edges benchmark faces:" << mesh.faces.count() << "edges:" << edges.count() << "legacy edges:" << legacyEdges.count()
+		<< "build time:" << legacyBuildTime << "->" << buildTime << "speedup:" << (double)legacyBuildTime / buildTime
+		<< "lookup time:" << legacyLookupTime << "->" << lookupTime << "speedup:" << (double)legacyLookupTime / lookupTime
+		<< "identical:" << identical;
 }
 
-bool GeoUtil::inZones(const QVector<Zone>& zones, BVHTreeNode* node, const QVector3D& point)
+bool GeoUtil::interpZones(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point, float& value)
 {
-	if (node->isLeaf)
+	return traverseBVH(tree,
+		[&tree, &point](int index)
+	{
+		return tree.nodes[index].bound.contain(point);
+	},
+		[&zones, &point, &value](const uint32_t* zoneIndices, int zoneNum)
 	{
-		for (uint32_t z : node->zones)
+		for (int i = 0; i < zoneNum; ++i)
 		{
-			const Zone& zone = zones[z];
-			if (zone.contain(point))
+			if (zones.interp(zoneIndices[i], point, value))
 			{
 				return true;
 			}
 		}
 		return false;
-	}
-	else
+	});
+}
+
+bool GeoUtil::locateZone(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point, uint32_t& zoneIndex)
+{
+	// interpZonesı˳һ£֤ҵͬһԪ
+	return traverseBVH(tree,
+		[&tree, &point](int index)
 	{
-		if (node->children[0]->bound.contain(point) && inZones(zones, node->children[0], point))
+		return tree.nodes[index].bound.contain(point);
+	},
+		[&zones, &point, &zoneIndex](const uint32_t* zoneIndices, int zoneNum)
+	{
+		for (int i = 0; i < zoneNum; ++i)
 		{
-			return true;
+			if (zones.contain(zoneIndices[i], point))
+			{
+				zoneIndex = zoneIndices[i];
+				return true;
+			}
 		}
-		if (node->children[1]->bound.contain(point) && inZones(zones, node->children[1], point))
+		return false;
+	});
+}
+
+void GeoUtil::sampleUniformGrids(const ZoneSet& zones, const LinearBVH& tree, UniformGrids& uniformGrids)
+{
+	const std::array<int, 3>& dim = uniformGrids.dim;
+	int voxelNum = dim[0] * dim[1] * dim[2];
+	uniformGrids.sampleZones.resize(voxelNum);
+	uniformGrids.sampleCoords.resize(voxelNum);
+
+	int index = 0;
+	for (int x = 0; x < dim[0]; ++x)
+	{
+		for (int y = 0; y < dim[1]; ++y)
 		{
-			return true;
+			for (int z = 0; z < dim[2]; ++z, ++index)
+			{
+				QVector3D position = uniformGrids.position(x, y, z);
+				uint32_t zoneIndex = kInvalidIndex;
+				if (locateZone(zones, tree, position, zoneIndex))
+				{
+					uniformGrids.sampleCoords[index] = zones.localCoords(zoneIndex, position);
+				}
+				uniformGrids.sampleZones[index] = zoneIndex;
+			}
 		}
+	}
+	updateUniformGridPoints(uniformGrids);
+}
 
-		return false;
+void GeoUtil::resampleUniformGrids(const ZoneSet& zones, UniformGrids& uniformGrids)
+{
+	// ԪǰһصֵinterpUniformGridsһ£
+	int voxelNum = uniformGrids.sampleZones.count();
+	uniformGrids.voxelData.resize(voxelNum);
+	float value = voxelNum > 0 ? uniformGrids.voxelData[0] : 0.0f;
+	int pointIndex = 0;
+	for (int i = 0; i < voxelNum; ++i)
+	{
+		uint32_t zoneIndex = uniformGrids.sampleZones[i];
+		if (zoneIndex != kInvalidIndex)
+		{
+			value = zones.interpValue(zoneIndex, uniformGrids.sampleCoords[i]);
+			if (pointIndex < uniformGrids.points.count())
+			{
+				uniformGrids.points[pointIndex++].value = value;
+			}
+		}
+		uniformGrids.voxelData[i] = value;
 	}
+	updateVoxelBlockTree(uniformGrids);
 }
 
-BVHTreeNode* GeoUtil::buildBVHTree(const QVector<Zone>& zones)
+void GeoUtil::updateUniformGridPoints(UniformGrids& uniformGrids)
 {
-	QVector<uint32_t> zoneIndices;
-	for (int i = 0; i < zones.count(); ++i)
+	// κλģڲػ仯ڵԪؽڲ㣬ֵresampleUniformGrids
+	const std::array<int, 3>& dim = uniformGrids.dim;
+	uniformGrids.points.clear();
+	int index = 0;
+	for (int x = 0; x < dim[0]; ++x)
 	{
-		zoneIndices.append(i);
+		for (int y = 0; y < dim[1]; ++y)
+		{
+			for (int z = 0; z < dim[2]; ++z, ++index)
+			{
+				if (index < uniformGrids.sampleZones.count() && uniformGrids.sampleZones[index] != kInvalidIndex)
+				{
+					uniformGrids.points.append({ uniformGrids.position(x, y, z), 0.0f });
+				}
+			}
+		}
 	}
-	return buildBVHTree(zones, zoneIndices, 0, zoneIndices.count());
 }
 
-BVHTreeNode* GeoUtil::buildBVHTree(const Mesh& mesh)
+IntervalTree GeoUtil::buildIntervalTree(const Mesh& mesh, const QVector<float>& nodeValues)
 {
-	QVector<uint32_t> faces;
+	// ֵΧΪֵСֵ
+	QVector<float> mins(mesh.faces.count());
+	QVector<float> maxs(mesh.faces.count());
 	for (int i = 0; i < mesh.faces.count(); ++i)
 	{
-		faces.append(i);
+		const Face& face = mesh.faces[i];
+		float value0 = nodeValues[face.vertices[0]];
+		float value1 = nodeValues[face.vertices[1]];
+		float value2 = nodeValues[face.vertices[2]];
+		mins[i] = qMin3(value0, value1, value2);
+		maxs[i] = qMax3(value0, value1, value2);
 	}
-	return buildBVHTree(mesh, faces, 0, mesh.faces.count());
+	return buildIntervalTree(mins, maxs);
 }
 
-BVHTreeNode* GeoUtil::buildBVHTree(const Mesh& mesh, QVector<uint32_t>& faces, int begin, int end)
+void GeoUtil::updateVoxelBlockTree(UniformGrids& uniformGrids)
 {
-	BVHTreeNode* node = new BVHTreeNode;
-	int num = end - begin;
+	// ؿֵΧصԪȫǵ㣬ڿ鹲ñ߽ϵ
+	const std::array<int, 3>& dim = uniformGrids.dim;
+	std::array<int, 3> blockDim = uniformGrids.blockDim();
+	int blockNum = blockDim[0] * blockDim[1] * blockDim[2];
+	if (blockNum == 0 || uniformGrids.voxelData.count() != dim[0] * dim[1] * dim[2])
+	{
+		uniformGrids.blockTree.clear();
+		return;
+	}
 
-	if (num <= 3)
+	const float* voxelData = uniformGrids.voxelData.constData();
+	QVector<float> mins(blockNum);
+	QVector<float> maxs(blockNum);
+	int index = 0;
+	for (int bx = 0; bx < blockDim[0]; ++bx)
 	{
-		for (int i = begin; i < end; ++i)
+		for (int by = 0; by < blockDim[1]; ++by)
 		{
-			uint32_t f = faces[i];
-			const Bound& bound = mesh.faces[f].bound;
-			node->bound.combine(bound);
-			node->bound.cache();
+			for (int bz = 0; bz < blockDim[2]; ++bz, ++index)
+			{
+				int x0 = bx * kVoxelBlockSize, x1 = qMin(x0 + kVoxelBlockSize, dim[0] - 1);
+				int y0 = by * kVoxelBlockSize, y1 = qMin(y0 + kVoxelBlockSize, dim[1] - 1);
+				int z0 = bz * kVoxelBlockSize, z1 = qMin(z0 + kVoxelBlockSize, dim[2] - 1);
+				float minVal = voxelData[(x0 * dim[1] + y0) * dim[2] + z0];
+				float maxVal = minVal;
+				for (int x = x0; x <= x1; ++x)
+				{
+					for (int y = y0; y <= y1; ++y)
+					{
+						const float* row = voxelData + (x * dim[1] + y) * dim[2];
+						for (int z = z0; z <= z1; ++z)
+						{
+							minVal = qMin(minVal, row[z]);
+							maxVal = qMax(maxVal, row[z]);
+						}
+					}
+				}
+				mins[index] = minVal;
+				maxs[index] = maxVal;
+			}
 		}
+	}
+	uniformGrids.blockTree = buildIntervalTree(mins, maxs);
+}
 
-		for (int i = begin; i < end; ++i)
+IntervalTree GeoUtil::buildIntervalTree(const QVector<float>& mins, const QVector<float>& maxs)
+{
+	// ֵΧЧNaNͼԪ
+	IntervalTree tree;
+	QVector<uint32_t> primitives;
+	primitives.reserve(mins.count());
+	for (int i = 0; i < mins.count(); ++i)
+	{
+		if (mins[i] <= maxs[i])
 		{
-			node->faces.append(faces[i]);
+			primitives.append(i);
 		}
-		node->children[0] = node->children[1] = nullptr;
-		node->depth = 0;
-		node->isLeaf = true;
 	}
-	else
+
+	if (!primitives.isEmpty())
 	{
-		Bound centriodBound;
-		for (int i = begin; i < end; ++i)
+		tree.lowerEntries.reserve(primitives.count());
+		tree.upperEntries.reserve(primitives.count());
+		buildIntervalNode(mins, maxs, primitives.data(), tree, 0, primitives.count());
+	}
+	return tree;
+}
+
+int GeoUtil::buildIntervalNode(const QVector<float>& mins, const QVector<float>& maxs, uint32_t* primitives, IntervalTree& tree, int begin, int end)
+{
+	// ֵֽȡеλλ䱾ֵֽһ룬ΪO(log n)
+	int index = tree.nodes.count();
+	tree.nodes.append(IntervalTreeNode());
+
+	int mid = (begin + end) / 2;
+	std::nth_element(primitives + begin, primitives + mid, primitives + end, [&mins, &maxs](uint32_t a, uint32_t b)
+	{
+		return mins[a] + maxs[a] < mins[b] + maxs[b];
+	});
+	float center = (mins[primitives[mid]] + maxs[primitives[mid]]) * 0.5f;
+
+	// Ϊ ϽСڷֵֽ | ֵֽ | ½ڷֵֽ 
+	uint32_t* leftEnd = std::partition(primitives + begin, primitives + end, [&maxs, center](uint32_t p)
+	{
+		return maxs[p] < center;
+	});
+	uint32_t* rightBegin = std::partition(leftEnd, primitives + end, [&mins, center](uint32_t p)
+	{
+		return mins[p] <= center;
+	});
+
+	// ֵֽ䰴˵ţ˵ͬʱͼԪ򣬱֤ȷ
+	int offset = tree.lowerEntries.count();
+	for (uint32_t* p = leftEnd; p < rightBegin; ++p)
+	{
+		tree.lowerEntries.append({ mins[*p], *p });
+		tree.upperEntries.append({ maxs[*p], *p });
+	}
+	std::sort(tree.lowerEntries.begin() + offset, tree.lowerEntries.end(), [](const IntervalEntry& a, const IntervalEntry& b)
+	{
+		return a.value < b.value || (a.value == b.value && a.primitive < b.primitive);
+	});
+	std::sort(tree.upperEntries.begin() + offset, tree.upperEntries.end(), [](const IntervalEntry& a, const IntervalEntry& b)
+	{
+		return a.value > b.value || (a.value == b.value && a.primitive < b.primitive);
+	});
+
+	int leftBegin = begin;
+	int leftNum = leftEnd - (primitives + begin);
+	int rightNum = (primitives + end) - rightBegin;
+	int left = leftNum > 0 ? buildIntervalNode(mins, maxs, primitives, tree, leftBegin, leftBegin + leftNum) : -1;
+	int right = rightNum > 0 ? buildIntervalNode(mins, maxs, primitives, tree, end - rightNum, end) : -1;
+
+	IntervalTreeNode& node = tree.nodes[index];
+	node.center = center;
+	node.offset = offset;
+	node.intervalNum = rightBegin - leftEnd;
+	node.left = left;
+	node.right = right;
+	return index;
+}
+
+void GeoUtil::benchmarkIntervalTree(const Mesh& mesh, const QVector<float>& nodeValues)
+{
+	// ԭзȽϣΧ滻ΪֵΧbvh(v, v, v)
+	// ԭҶڵеȫ棬ͳߴֵ
+	const int kQueryNum = 1000;
+	QVector<AABB> valueBounds(mesh.faces.count());
+	float minValue = std::numeric_limits<float>::max();
+	float maxValue = std::numeric_limits<float>::lowest();
+	for (int i = 0; i < mesh.faces.count(); ++i)
+	{
+		const Face& face = mesh.faces[i];
+		float value0 = nodeValues[face.vertices[0]];
+		float value1 = nodeValues[face.vertices[1]];
+		float value2 = nodeValues[face.vertices[2]];
+		float minVal = qMin3(value0, value1, value2);
+		float maxVal = qMax3(value0, value1, value2);
+		valueBounds[i].min = QVector3D(minVal, minVal, minVal);
+		valueBounds[i].max = QVector3D(maxVal, maxVal, maxVal);
+		minValue = qMin(minValue, minVal);
+		maxValue = qMax(maxValue, maxVal);
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	LinearBVH legacyTree = buildBVHTree(valueBounds, BVHBuildOptions());
+	qint64 legacyBuildTime = qMax(timer.nsecsElapsed(), (qint64)1);
+	timer.start();
+	IntervalTree tree = buildIntervalTree(mesh, nodeValues);
+	qint64 buildTime = qMax(timer.nsecsElapsed(), (qint64)1);
+
+	qint64 legacyVisitNum = 0;
+	qint64 legacyHitNum = 0;
+	qint64 legacySum = 0;
+	timer.start();
+	for (int q = 0; q < kQueryNum; ++q)
+	{
+		float value = qLerp(minValue, maxValue, (q + 0.5f) / kQueryNum);
+		QVector3D point(value, value, value);
+		traverseBVH(legacyTree,
+			[&legacyTree, &point](int index)
 		{
-			uint32_t f = faces[i];
-			const Bound& bound = mesh.faces[f].bound;
-			centriodBound.combine(bound.centriod);
-		}
+			return legacyTree.nodes[index].bound.contain(point);
+		},
+			[&](const uint32_t* faces, int faceNum)
+		{
+			for (int i = 0; i < faceNum; ++i)
+			{
+				++legacyVisitNum;
+				if (valueBounds[faces[i]].contain(point))
+				{
+					++legacyHitNum;
+					legacySum += faces[i] + 1;
+				}
+			}
+			return false;
+		});
+	}
+	qint64 legacyQueryTime = qMax(timer.nsecsElapsed(), (qint64)1);
 
-		int dim = centriodBound.maxDim();
-		int mid = (begin + end) * 0.5f;
-		std::nth_element(&faces[begin], &faces[mid], &faces[end - 1] + 1,
-			[&mesh, dim](uint32_t a, uint32_t b)
+	qint64 visitNum = 0;
+	qint64 sum = 0;
+	timer.start();
+	for (int q = 0; q < kQueryNum; ++q)
+	{
+		float value = qLerp(minValue, maxValue, (q + 0.5f) / kQueryNum);
+		queryIntervalTree(tree, value, [&](uint32_t face)
 		{
-			return mesh.faces[a].bound.centriod[dim] < mesh.faces[b].bound.centriod[dim];
+			++visitNum;
+			sum += face + 1;
 		});
+	}
+	qint64 queryTime = qMax(timer.nsecsElapsed(), (qint64)1);
+
+	qDebug() << "interval tree benchmark faces:" << mesh.faces.count() << "queries:" << kQueryNum
+		<< "build time(us):" << legacyBuildTime / 1000 << "->" << buildTime / 1000 << "speedup:" << (double)legacyBuildTime / buildTime
+		<< "query time(us):" << legacyQueryTime / 1000 << "->" << queryTime / 1000 << "speedup:" << (double)legacyQueryTime / queryTime
+		<< "visited faces:" << legacyVisitNum << "->" << visitNum << "identical:" << (legacyHitNum == visitNum && legacySum == sum);
+}
+
+bool GeoUtil::inZones(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point)
+{
+	return traverseBVH(tree,
+		[&tree, &point](int index)
+	{
+		return tree.nodes[index].bound.contain(point);
+	},
+		[&zones, &point](const uint32_t* zoneIndices, int zoneNum)
+	{
+		for (int i = 0; i < zoneNum; ++i)
+		{
+			if (zones.contain(zoneIndices[i], point))
+			{
+				return true;
+			}
+		}
+		return false;
+	});
+}
+
+LinearBVH GeoUtil::buildBVHTree(const ZoneSet& zones, const BVHBuildOptions& options)
+{
+	QVector<AABB> bounds(zones.count());
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		bounds[i].min = zones.boundMins[i];
+		bounds[i].max = zones.boundMaxs[i];
+	}
+	return buildBVHTree(bounds, options);
+}
 
-		int depth[2] = { 0, 0 };
-		if (begin < mid)
+template <typename ChunkFunc>
+void GeoUtil::runBVHChunks(QThreadPool* threadPool, int begin, int end, ChunkFunc chunkFunc)
+{
+	// ߳ȷ䣬ֿĽɵֿ߰˳ϲ
+	int chunkNum = threadPool ? threadPool->maxThreadCount() : 1;
+	if (chunkNum <= 1)
+	{
+		chunkFunc(0, begin, end);
+		return;
+	}
+
+	QFutureSynchronizer<void> synchronizer;
+	for (int c = 0; c < chunkNum; ++c)
+	{
+		int chunkBegin = begin + (qint64)(end - begin) * c / chunkNum;
+		int chunkEnd = begin + (qint64)(end - begin) * (c + 1) / chunkNum;
+		synchronizer.addFuture(QtConcurrent::run(threadPool, [&chunkFunc, c, chunkBegin, chunkEnd]() {
+			chunkFunc(c, chunkBegin, chunkEnd);
+		}));
+	}
+	synchronizer.waitForFinished();
+}
+
+LinearBVH GeoUtil::buildBVHTree(const QVector<AABB>& bounds, const BVHBuildOptions& options)
+{
+	// ͼԪڻֹԭţҶڵֱе
+	LinearBVH tree;
+	int primitiveNum = bounds.count();
+	tree.primitives.resize(primitiveNum);
+	QVector<QVector3D> centriods(primitiveNum);
+	for (int i = 0; i < primitiveNum; ++i)
+	{
+		tree.primitives[i] = i;
+		centriods[i] = bounds[i].centriod();
+	}
+
+	if (primitiveNum == 0)
+	{
+		return tree;
+	}
+
+	int threadCount = options.threadCount;
+	if (threadCount <= 0)
+	{
+		threadCount = QThread::idealThreadCount();
+	}
+
+	tree.nodes.reserve(qMax(1, primitiveNum * 2 / kBVHLeafSize));
+	int taskSize = qMax(options.taskSize, 1);
+	if (threadCount <= 1 || primitiveNum < taskSize)
+	{
+		buildBVHNode(bounds, centriods, options, tree.primitives.data(), tree.nodes, 0, primitiveNum);
+		return tree;
+	}
+
+	// ϲڵڵǰ̻֣߳İΧСͰŷֿ鲢УͼԪֵΪй
+	// дĽڵ飬˳ƴӣڵ˳봮йȫһ
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(threadCount);
+	QVector<BVHBuildNode> topNodes;
+	QVector<QFuture<QVector<LinearBVHNode>>> subtrees;
+	buildBVHTopNode(bounds, centriods, options, tree.primitives.data(), threadPool, topNodes, subtrees, 0, primitiveNum);
+	spliceBVHNode(topNodes, subtrees, tree, 0);
+	return tree;
+}
+
+int GeoUtil::buildBVHNode(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const BVHBuildOptions& options, uint32_t* primitives, QVector<LinearBVHNode>& nodes, int begin, int end)
+{
+	int index = nodes.count();
+	nodes.append(LinearBVHNode());
+
+	AABB bound;
+	AABB centriodBound;
+	combineBVHBounds(bounds, centriods, primitives, begin, end, bound, centriodBound, nullptr);
+
+	// λΪ-1ʱΪҶڵ
+	int mid = options.method == BVHSplitSAH ?
+		splitSAH(bounds, centriods, bound, centriodBound, options, primitives, begin, end, nullptr) :
+		splitMedian(centriods, centriodBound, primitives, begin, end);
+	if (mid < 0)
+	{
+		nodes[index].offset = begin;
+		nodes[index].primitiveNum = end - begin;
+	}
+	else
+	{
+		// ӽڵ浱ǰڵ㣬ӽڵ֮
+		buildBVHNode(bounds, centriods, options, primitives, nodes, begin, mid);
+		int right = buildBVHNode(bounds, centriods, options, primitives, nodes, mid, end);
+		nodes[index].offset = right;
+		nodes[index].primitiveNum = 0;
+	}
+
+	nodes[index].bound = bound;
+	return index;
+}
+
+int GeoUtil::buildBVHTopNode(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const BVHBuildOptions& options, uint32_t* primitives, QThreadPool& threadPool, QVector<BVHBuildNode>& topNodes, QVector<QFuture<QVector<LinearBVHNode>>>& subtrees, int begin, int end)
+{
+	int index = topNodes.count();
+	topNodes.append(BVHBuildNode());
+	topNodes[index].begin = begin;
+	topNodes[index].end = end;
+
+	// ͼԪ以صֻΧм
+	if (end - begin < options.taskSize)
+	{
+		topNodes[index].subtree = subtrees.count();
+		subtrees.append(QtConcurrent::run(&threadPool, [&bounds, &centriods, &options, primitives, begin, end]() {
+			QVector<LinearBVHNode> nodes;
+			nodes.reserve(qMax(1, (end - begin) * 2 / kBVHLeafSize));
+			buildBVHNode(bounds, centriods, options, primitives, nodes, begin, end);
+			return nodes;
+		}));
+		return index;
+	}
+
+	QThreadPool* passPool = end - begin >= kBVHParallelPassSize ? &threadPool : nullptr;
+	AABB bound;
+	AABB centriodBound;
+	combineBVHBounds(bounds, centriods, primitives, begin, end, bound, centriodBound, passPool);
+	topNodes[index].bound = bound;
+
+	int mid = options.method == BVHSplitSAH ?
+		splitSAH(bounds, centriods, bound, centriodBound, options, primitives, begin, end, passPool) :
+		splitMedian(centriods, centriodBound, primitives, begin, end);
+	if (mid >= 0)
+	{
+		int left = buildBVHTopNode(bounds, centriods, options, primitives, threadPool, topNodes, subtrees, begin, mid);
+		int right = buildBVHTopNode(bounds, centriods, options, primitives, threadPool, topNodes, subtrees, mid, end);
+		topNodes[index].left = left;
+		topNodes[index].right = right;
+	}
+	return index;
+}
+
+int GeoUtil::spliceBVHNode(const QVector<BVHBuildNode>& topNodes, const QVector<QFuture<QVector<LinearBVHNode>>>& subtrees, LinearBVH& tree, int topIndex)
+{
+	const BVHBuildNode& topNode = topNodes[topIndex];
+	int index = tree.nodes.count();
+	if (topNode.subtree >= 0)
+	{
+		// ڲڵӽڵΪڵԱţƴʱڵλ
+		QVector<LinearBVHNode> nodes = subtrees[topNode.subtree].result();
+		for (LinearBVHNode& node : nodes)
 		{
-			node->children[0] = buildBVHTree(mesh, faces, begin, mid);
-			node->bound.combine(node->children[0]->bound);
-			depth[0] = node->children[0]->depth + 1;
+			if (!node.isLeaf())
+			{
+				node.offset += index;
+			}
 		}
+		tree.nodes.append(nodes);
+		return index;
+	}
 
-		if (mid < end)
+	tree.nodes.append(LinearBVHNode());
+	tree.nodes[index].bound = topNode.bound;
+	if (topNode.left < 0)
+	{
+		tree.nodes[index].offset = topNode.begin;
+		tree.nodes[index].primitiveNum = topNode.end - topNode.begin;
+	}
+	else
+	{
+		spliceBVHNode(topNodes, subtrees, tree, topNode.left);
+		int right = spliceBVHNode(topNodes, subtrees, tree, topNode.right);
+		tree.nodes[index].offset = right;
+		tree.nodes[index].primitiveNum = 0;
+	}
+	return index;
+}
+
+
+void GeoUtil::combineBVHBounds(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const uint32_t* primitives, int begin, int end, AABB& bound, AABB& centriodBound, QThreadPool* threadPool)
+{
+	// Χкϲֻȡֵֿ鷽ʽϲ˳޹
+	int chunkNum = threadPool ? threadPool->maxThreadCount() : 1;
+	QVarLengthArray<AABB, 16> chunkBounds(chunkNum);
+	QVarLengthArray<AABB, 16> chunkCentriodBounds(chunkNum);
+	runBVHChunks(threadPool, begin, end, [&](int c, int chunkBegin, int chunkEnd)
+	{
+		AABB chunkBound;
+		AABB chunkCentriodBound;
+		for (int i = chunkBegin; i < chunkEnd; ++i)
 		{
-			node->children[1] = buildBVHTree(mesh, faces, mid, end);
-			node->bound.combine(node->children[1]->bound);
-			depth[1] = node->children[1]->depth + 1;
+			chunkBound.combine(bounds[primitives[i]]);
+			chunkCentriodBound.combine(centriods[primitives[i]]);
 		}
+		chunkBounds[c] = chunkBound;
+		chunkCentriodBounds[c] = chunkCentriodBound;
+	});
 
-		node->bound.cache();
-		node->depth = qMax(depth[0], depth[1]);
+	bound = AABB();
+	centriodBound = AABB();
+	for (int c = 0; c < chunkNum; ++c)
+	{
+		bound.combine(chunkBounds[c]);
+		centriodBound.combine(chunkCentriodBounds[c]);
 	}
+}
 
-	return node;
+int GeoUtil::splitMedian(const QVector<QVector3D>& centriods, const AABB& centriodBound, uint32_t* primitives, int begin, int end)
+{
+	if (end - begin <= kBVHLeafSize)
+	{
+		return -1;
+	}
+
+	int dim = centriodBound.maxDim();
+	int mid = (begin + end) * 0.5f;
+	std::nth_element(primitives + begin, primitives + mid, primitives + end,
+		[&centriods, dim](uint32_t a, uint32_t b)
+	{
+		return centriods[a][dim] < centriods[b][dim];
+	});
+	return mid;
 }
 
-BVHTreeNode* GeoUtil::buildBVHTree(const QVector<Zone>& zones, QVector<uint32_t>& zoneIndices, int begin, int end)
+int GeoUtil::splitSAH(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const AABB& bound, const AABB& centriodBound, const BVHBuildOptions& options, uint32_t* primitives, int begin, int end, QThreadPool* threadPool)
 {
-	BVHTreeNode* node = new BVHTreeNode;
 	int num = end - begin;
+	if (num <= 1)
+	{
+		return -1;
+	}
 
-	if (num <= 3)
+	// ͬһɨаķͰֿ鲢кͰϲɨͰĻλãȡSAHС
+	int binNum = qBound(2, options.binNum, kBVHMaxBinNum);
+	auto binIndex = [&centriodBound, binNum](const QVector3D& centriod, int dim)
 	{
-		for (int i = begin; i < end; ++i)
+		float extent = centriodBound.max[dim] - centriodBound.min[dim];
+		if (extent <= 0.0f)
 		{
-			uint32_t z = zoneIndices[i];
-			const Bound& bound = zones[z].bound;
-			node->bound.combine(bound);
-			node->bound.cache();
+			return 0;
+		}
+		int b = (int)(binNum * ((centriod[dim] - centriodBound.min[dim]) / extent));
+		return qBound(0, b, binNum - 1);
+	};
+
+	// ֿͰδţÿֿڰͰ
+	int chunkNum = threadPool ? threadPool->maxThreadCount() : 1;
+	int binStride = binNum * 3;
+	QVarLengthArray<AABB, kBVHBinNum * 3> binBounds(binStride * chunkNum);
+	QVarLengthArray<int, kBVHBinNum * 3> binCounts(binStride * chunkNum);
+	runBVHChunks(threadPool, begin, end, [&](int c, int chunkBegin, int chunkEnd)
+	{
+		AABB* chunkBounds = binBounds.data() + c * binStride;
+		int* chunkCounts = binCounts.data() + c * binStride;
+		std::fill(chunkCounts, chunkCounts + binStride, 0);
+		for (int i = chunkBegin; i < chunkEnd; ++i)
+		{
+			uint32_t p = primitives[i];
+			for (int dim = 0; dim < 3; ++dim)
+			{
+				int b = dim * binNum + binIndex(centriods[p], dim);
+				chunkBounds[b].combine(bounds[p]);
+				chunkCounts[b]++;
+			}
 		}
+	});
 
-		for (int i = begin; i < end; ++i)
+	for (int c = 1; c < chunkNum; ++c)
+	{
+		for (int b = 0; b < binStride; ++b)
 		{
-			node->zones.append(zoneIndices[i]);
+			binBounds[b].combine(binBounds[c * binStride + b]);
+			binCounts[b] += binCounts[c * binStride + b];
 		}
-		node->children[0] = node->children[1] = nullptr;
-		node->depth = 0;
-		node->isLeaf = true;
 	}
-	else
+
+	float rightAreas[kBVHMaxBinNum];
+	int rightCounts[kBVHMaxBinNum];
+	float area = bound.surfaceArea();
+	float bestCost = kMaxVal;
+	int bestDim = -1;
+	int bestBin = -1;
+	for (int dim = 0; dim < 3 && area > 0.0f; ++dim)
 	{
-		Bound centriodBound;
-		for (int i = begin; i < end; ++i)
+		if (centriodBound.max[dim] <= centriodBound.min[dim])
 		{
-			uint32_t z = zoneIndices[i];
-			const Bound& bound = zones[z].bound;
-			centriodBound.combine(bound.centriod);
+			continue;
 		}
 
-		int dim = centriodBound.maxDim();
-		int mid = (begin + end) * 0.5f;
-		std::nth_element(&zoneIndices[begin], &zoneIndices[mid], &zoneIndices[end - 1] + 1,
-			[&zones, dim](uint32_t a, uint32_t b)
+		// ۻͰbҲࣨbİΧУۻͰb֮ǰֵĴ
+		AABB rightBound;
+		int rightCount = 0;
+		for (int b = binNum - 1; b > 0; --b)
 		{
-			return zones[a].bound.centriod[dim] < zones[b].bound.centriod[dim];
-		});
+			rightBound.combine(binBounds[dim * binNum + b]);
+			rightCount += binCounts[dim * binNum + b];
+			rightAreas[b] = rightBound.surfaceArea();
+			rightCounts[b] = rightCount;
+		}
 
-		int depth[2] = { 0, 0 };
-		if (begin < mid)
+		AABB leftBound;
+		int leftCount = 0;
+		for (int b = 1; b < binNum; ++b)
 		{
-			node->children[0] = buildBVHTree(zones, zoneIndices, begin, mid);
-			node->bound.combine(node->children[0]->bound);
-			depth[0] = node->children[0]->depth + 1;
+			leftBound.combine(binBounds[dim * binNum + b - 1]);
+			leftCount += binCounts[dim * binNum + b - 1];
+			if (leftCount == 0 || rightCounts[b] == 0)
+			{
+				continue;
+			}
+
+			float cost = options.traversalCost + options.intersectionCost *
+				(leftCount * leftBound.surfaceArea() + rightCounts[b] * rightAreas[b]) / area;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestDim = dim;
+				bestBin = b;
+			}
 		}
+	}
+
+	// غϻΧ˻ʱ޷ͼԪ򰴱Ŷ԰뻮
+	if (bestDim < 0)
+	{
+		return num <= options.maxLeafSize ? -1 : (begin + end) / 2;
+	}
+
+	float leafCost = options.intersectionCost * num;
+	if (num <= options.maxLeafSize && leafCost <= bestCost)
+	{
+		return -1;
+	}
 
-		if (mid < end)
+	// ȶ֣ౣԭ˳Ž߳޹
+	auto isLeft = [&centriods, &binIndex, bestDim, bestBin](uint32_t p)
+	{
+		return binIndex(centriods[p], bestDim) < bestBin;
+	};
+	if (!threadPool)
+	{
+		// ͼԪǰƣҲͼԪݴ֮
+		QVarLengthArray<uint32_t, 256> rights;
+		int mid = begin;
+		for (int i = begin; i < end; ++i)
 		{
-			node->children[1] = buildBVHTree(zones, zoneIndices, mid, end);
-			node->bound.combine(node->children[1]->bound);
-			depth[1] = node->children[1]->depth + 1;
+			uint32_t p = primitives[i];
+			if (isLeft(p))
+			{
+				primitives[mid++] = p;
+			}
+			else
+			{
+				rights.append(p);
+			}
 		}
+		std::copy(rights.constData(), rights.constData() + rights.count(), primitives + mid);
+		return mid;
+	}
+
+	// ֿͳͼԪǰ׺͵õֿʱедλãٷֿд
+	QVarLengthArray<int, 16> leftOffsets(chunkNum);
+	QVarLengthArray<int, 16> rightOffsets(chunkNum);
+	runBVHChunks(threadPool, begin, end, [&](int c, int chunkBegin, int chunkEnd)
+	{
+		leftOffsets[c] = std::count_if(primitives + chunkBegin, primitives + chunkEnd, isLeft);
+		rightOffsets[c] = chunkEnd - chunkBegin - leftOffsets[c];
+	});
 
-		node->bound.cache();
-		node->depth = qMax(depth[0], depth[1]);
+	int leftNum = 0;
+	int rightNum = 0;
+	for (int c = 0; c < chunkNum; ++c)
+	{
+		leftNum += leftOffsets[c];
+		rightNum += rightOffsets[c];
+	}
+	int mid = begin + leftNum;
+	for (int c = chunkNum - 1; c >= 0; --c)
+	{
+		leftNum -= leftOffsets[c];
+		rightNum -= rightOffsets[c];
+		leftOffsets[c] = leftNum;
+		rightOffsets[c] = rightNum;
 	}
 
-	return node;
+	QVector<uint32_t> partitioned(num);
+	runBVHChunks(threadPool, begin, end, [&](int c, int chunkBegin, int chunkEnd)
+	{
+		int left = leftOffsets[c];
+		int right = mid - begin + rightOffsets[c];
+		for (int i = chunkBegin; i < chunkEnd; ++i)
+		{
+			uint32_t p = primitives[i];
+			partitioned[isLeft(p) ? left++ : right++] = p;
+		}
+	});
+	std::copy(partitioned.constBegin(), partitioned.constEnd(), primitives + begin);
+	return mid;
 }
 
-void GeoUtil::destroyBVHTree(BVHTreeNode* root)
+BVHStats GeoUtil::getBVHStats(const LinearBVH& tree, const BVHBuildOptions& options)
 {
-	if (root)
+	// ӽڵλڸڵ֮˳ɸڵȵõӽڵ
+	BVHStats stats;
+	stats.nodeNum = tree.nodes.count();
+	float rootArea = tree.bound().surfaceArea();
+	QVector<int> depths(tree.nodes.count(), 0);
+	qint64 leafPrimitiveNum = 0;
+	qint64 leafDepthSum = 0;
+	for (int i = 0; i < tree.nodes.count(); ++i)
 	{
-		destroyBVHTree(root->children[0]);
-		destroyBVHTree(root->children[1]);
-		SAFE_DELETE(root);
+		const LinearBVHNode& node = tree.nodes[i];
+		double relativeArea = rootArea > 0.0f ? node.bound.surfaceArea() / rootArea : 1.0;
+		stats.depth = qMax(stats.depth, depths[i]);
+		if (node.isLeaf())
+		{
+			stats.sahCost += options.intersectionCost * node.primitiveNum * relativeArea;
+			stats.leafNum++;
+			stats.maxLeafSize = qMax(stats.maxLeafSize, node.primitiveNum);
+			leafPrimitiveNum += node.primitiveNum;
+			leafDepthSum += depths[i];
+		}
+		else
+		{
+			stats.sahCost += options.traversalCost * relativeArea;
+			depths[i + 1] = depths[node.offset] = depths[i] + 1;
+		}
+	}
+
+	if (stats.leafNum > 0)
+	{
+		stats.averageLeafSize = (double)leafPrimitiveNum / stats.leafNum;
+		stats.averageLeafDepth = (double)leafDepthSum / stats.leafNum;
 	}
+	return stats;
 }
 
-void GeoUtil::resetBVHTree(BVHTreeNode* node)
+void GeoUtil::benchmarkBVH(const ZoneSet& zones, const QVector<QVector3D>& positions, const QVector<float>& nodeValues)
 {
-	if (!node)
+	// ֱλּͰSAHԪȽСʰȡʱ߽һ
+	const int kPlaneNum = 32;
+	const int kRayNum = 2048;
+	BVHBuildOptions medianOptions;
+	medianOptions.method = BVHSplitMedian;
+	BVHBuildOptions sahOptions;
+
+	for (int m = 0; m < 2; ++m)
 	{
-		return;
+		const BVHBuildOptions& options = m == 0 ? medianOptions : sahOptions;
+		QElapsedTimer timer;
+		timer.start();
+		LinearBVH zoneTree = buildBVHTree(zones, options);
+		updateBVHGroupMask(zones, zoneTree);
+		qint64 zoneBuildTime = timer.restart();
+
+		// һбȾֲ
+		AABB bound = zoneTree.bound();
+		QVector3D normals[4] = { QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f), QVector3D(1.0f, 1.0f, 1.0f).normalized() };
+		qint64 sectionSum = 0;
+		QVector<NodeVertex> sectionVertices;
+		QVector<uint32_t> sectionIndices;
+		QVector<uint32_t> sectionWireframeIndices;
+		timer.restart();
+		for (const QVector3D& normal : normals)
+		{
+			for (int i = 0; i < kPlaneNum; ++i)
+			{
+				Plane plane;
+				plane.normal = normal;
+				plane.origin = qLerp(bound.min, bound.max, (i + 0.5f) / kPlaneNum);
+				plane.dist = QVector3D::dotProduct(plane.origin, plane.normal);
+				clipZones(zones, plane, zoneTree, positions, nodeValues, sectionVertices, sectionIndices, sectionWireframeIndices);
+				sectionSum += sectionVertices.count() + sectionIndices.count() + sectionWireframeIndices.count();
+			}
+		}
+		qint64 clipTime = timer.restart();
+
+		// ߴӰΧĹ̶Χڵ
+		qint64 pickSum = 0;
+		QVector<uint32_t> pickIndices;
+		QVector3D eye = bound.max + (bound.max - bound.min);
+		for (int i = 0; i < kRayNum; ++i)
+		{
+			QVector3D t((i % 31 + 0.5f) / 31.0f, (i % 37 + 0.5f) / 37.0f, (i % 41 + 0.5f) / 41.0f);
+			QVector3D target = bound.min + (bound.max - bound.min) * t;
+			pickZone(zones, Ray(eye, target - eye), zoneTree, positions, pickIndices);
+			pickSum += pickIndices.count();
+		}
+		qint64 pickTime = timer.restart();
+
+		BVHStats zoneStats = getBVHStats(zoneTree, options);
+		qDebug() << "bvh benchmark" << (m == 0 ? "median" : "sah")
+			<< "zone tree sah cost:" << zoneStats.sahCost << "nodes:" << zoneStats.nodeNum << "depth:" << zoneStats.depth
+			<< "leaf depth:" << zoneStats.averageLeafDepth << "leaf size:" << zoneStats.averageLeafSize << "/" << zoneStats.maxLeafSize << "build time:" << zoneBuildTime
+			<< "clip time:" << clipTime << "(" << kPlaneNum * 4 << "planes, sum" << sectionSum << ")"
+			<< "pick time:" << pickTime << "(" << kRayNum << "rays, sum" << pickSum << ")";
 	}
 
-	node->bound.reset();
-	resetBVHTree(node->children[0]);
-	resetBVHTree(node->children[1]);
+	// ʱ߳ı仯1߳μӱȡе̺ʱ߳봮йһ
+	const int kBuildRepeatNum = 5;
+	auto sameTree = [](const LinearBVH& a, const LinearBVH& b)
+	{
+		if (a.primitives != b.primitives || a.nodes.count() != b.nodes.count())
+		{
+			return false;
+		}
+		for (int i = 0; i < a.nodes.count(); ++i)
+		{
+			const LinearBVHNode& na = a.nodes[i];
+			const LinearBVHNode& nb = b.nodes[i];
+			if (na.bound.min != nb.bound.min || na.bound.max != nb.bound.max || na.offset != nb.offset || na.primitiveNum != nb.primitiveNum)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	QVector<int> threadCounts;
+	int idealThreadCount = QThread::idealThreadCount();
+	for (int threadCount = 1; threadCount < idealThreadCount; threadCount *= 2)
+	{
+		threadCounts.append(threadCount);
+	}
+	threadCounts.append(qMax(1, idealThreadCount));
+
+	LinearBVH serialZoneTree = buildBVHTree(zones, sahOptions);
+	qint64 serialTime = 0;
+	for (int threadCount : threadCounts)
+	{
+		BVHBuildOptions options = sahOptions;
+		options.threadCount = threadCount;
+		qint64 zoneBuildTime = std::numeric_limits<qint64>::max();
+		bool same = true;
+		for (int r = 0; r < kBuildRepeatNum; ++r)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			LinearBVH zoneTree = buildBVHTree(zones, options);
+			zoneBuildTime = qMin(zoneBuildTime, timer.elapsed());
+			same = same && sameTree(zoneTree, serialZoneTree);
+		}
+
+		if (threadCount == 1)
+		{
+			serialTime = zoneBuildTime;
+		}
+		qDebug() << "bvh build scaling threads:" << threadCount << "zone tree time:" << zoneBuildTime
+			<< "speedup:" << (zoneBuildTime > 0 ? (double)serialTime / zoneBuildTime : 1.0)
+			<< "same as serial:" << same;
+	}
 }
 
-void GeoUtil::clipZones(QVector<Zone>& zones, const Plane& plane, BVHTreeNode* node, QVector<NodeVertex>& nodeVertices, QMap<Edge, uint32_t>& intersectionIndexMap, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QSet<Edge>& sectionWireframes)
+template <typename PrimitiveBound>
+void GeoUtil::refitBVHNodes(LinearBVH& tree, PrimitiveBound primitiveBound, int threadCount)
 {
-	if (node->isLeaf)
+	// ṹ䣬ڽڵӽڵλڸڵ֮һΪԵ¼Χ
+	auto refitRange = [&tree, &primitiveBound](int begin, int end)
 	{
-		for (uint32_t z : node->zones)
+		for (int i = end - 1; i >= begin; --i)
 		{
-			Zone& zone = zones[z];
-			if (!zone.visited)
+			LinearBVHNode& node = tree.nodes[i];
+			AABB bound;
+			if (node.isLeaf())
+			{
+				for (int j = node.offset; j < node.offset + node.primitiveNum; ++j)
+				{
+					bound.combine(primitiveBound(tree.primitives[j]));
+				}
+			}
+			else
 			{
-				zone.visited = true;
-				clipZone(zone, plane, nodeVertices, intersectionIndexMap, sectionVertices, sectionIndices, sectionWireframes);
+				bound = tree.nodes[i + 1].bound;
+				bound.combine(tree.nodes[node.offset].bound);
 			}
+			node.bound = bound;
 		}
+	};
+
+	if (threadCount <= 0)
+	{
+		threadCount = QThread::idealThreadCount();
 	}
-	else
+	if (threadCount <= 1 || tree.nodes.count() < kBVHTaskSize)
 	{
-		if (node->children[0]->bound.intersect(plane))
+		refitRange(0, tree.nodes.count());
+		return;
+	}
+
+	// Ըڵ»֣ڵֵΪи£ϵĽڵɺ󰴱
+	QVector<int> topNodes;
+	QVector<QPair<int, int>> subtrees;
+	QVector<QPair<int, int>> stack = { qMakePair(0, tree.nodes.count()) };
+	while (!stack.isEmpty())
+	{
+		QPair<int, int> range = stack.takeLast();
+		const LinearBVHNode& node = tree.nodes[range.first];
+		if (node.isLeaf() || range.second - range.first < kBVHTaskSize)
+		{
+			subtrees.append(range);
+		}
+		else
+		{
+			topNodes.append(range.first);
+			stack.append(qMakePair(node.offset, range.second));
+			stack.append(qMakePair(range.first + 1, node.offset));
+		}
+	}
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(threadCount);
+	QFutureSynchronizer<void> synchronizer;
+	for (const QPair<int, int>& subtree : subtrees)
+	{
+		synchronizer.addFuture(QtConcurrent::run(&threadPool, [&refitRange, subtree]() {
+			refitRange(subtree.first, subtree.second);
+		}));
+	}
+	synchronizer.waitForFinished();
+
+	for (int k = topNodes.count() - 1; k >= 0; --k)
+	{
+		int i = topNodes[k];
+		LinearBVHNode& node = tree.nodes[i];
+		node.bound = tree.nodes[i + 1].bound;
+		node.bound.combine(tree.nodes[node.offset].bound);
+	}
+}
+
+void GeoUtil::refitBVHTree(const ZoneSet& zones, LinearBVH& tree, int threadCount)
+{
+	refitBVHNodes(tree, [&zones](uint32_t zoneIndex)
+	{
+		return AABB{ zones.boundMins[zoneIndex], zones.boundMaxs[zoneIndex] };
+	}, threadCount);
+}
+
+void GeoUtil::updateZoneGeometry(ZoneSet& zones, const QVector<QVector3D>& positions, int threadCount)
+{
+	// Ԫļֻڵ㣬Ԫֿ鲢м
+	if (threadCount <= 0)
+	{
+		threadCount = QThread::idealThreadCount();
+	}
+	if (threadCount <= 1 || zones.count() < kBVHParallelPassSize)
+	{
+		zones.updateGeometry(positions, 0, zones.count());
+		return;
+	}
+
+	QThreadPool threadPool;
+	threadPool.setMaxThreadCount(threadCount);
+	runBVHChunks(&threadPool, 0, zones.count(), [&zones, &positions](int, int chunkBegin, int chunkEnd)
+	{
+		zones.updateGeometry(positions, chunkBegin, chunkEnd);
+	});
+}
+
+quint64 GeoUtil::updateBVHGroupMask(const ZoneSet& zones, LinearBVH& tree)
+{
+	// ԵϺϲеԪλ
+	tree.groupMasks.fill(0, tree.nodes.count());
+	for (int i = tree.nodes.count() - 1; i >= 0; --i)
+	{
+		const LinearBVHNode& node = tree.nodes[i];
+		quint64& groupMask = tree.groupMasks[i];
+		if (node.isLeaf())
 		{
-			clipZones(zones, plane, node->children[0], nodeVertices, intersectionIndexMap, sectionVertices, sectionIndices, sectionWireframes);
+			for (int j = node.offset; j < node.offset + node.primitiveNum; ++j)
+			{
+				groupMask |= qZoneGroupBit(zones.groups[tree.primitives[j]]);
+			}
 		}
-		if (node->children[1]->bound.intersect(plane))
+		else
 		{
-			clipZones(zones, plane, node->children[1], nodeVertices, intersectionIndexMap, sectionVertices, sectionIndices, sectionWireframes);
+			groupMask = tree.groupMasks[i + 1] | tree.groupMasks[node.offset];
 		}
 	}
+	return tree.isEmpty() ? 0 : tree.groupMasks[0];
 }
 
-void GeoUtil::pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* node, const QVector<NodeVertex>& nodeVertices, QMap<float, QSet<Edge>>& pickEdgesMap, bool pickZoneMode)
+void GeoUtil::clipZones(const ZoneSet& zones, const Plane& plane, const LinearBVH& tree, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<uint32_t>& edgeIntersections, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, EdgeIndex& sectionWireframes, quint64 groupMask)
 {
-	if (node->isLeaf)
+	// ֻĵԪʱֱÿԪֻλһҶڵУҪʱǡ
+	// ҶڵеĵԪΧУֻӴĵԪУĻַʽ޹
+	traverseBVH(tree,
+		[&tree, &plane, groupMask](int index)
+	{
+		return (tree.groupMask(index) & groupMask) && tree.nodes[index].bound.intersect(plane);
+	},
+		[&](const uint32_t* zoneIndices, int zoneNum)
 	{
-		for (uint32_t z : node->zones)
+		for (int i = 0; i < zoneNum; ++i)
 		{
-			Zone& zone = zones[z];
-			if (!zone.visited)
+			uint32_t z = zoneIndices[i];
+			if ((qZoneGroupBit(zones.groups[z]) & groupMask) && AABB{ zones.boundMins[z], zones.boundMaxs[z] }.intersect(plane))
 			{
-				zone.visited = true;
+				clipZone(zones, z, plane, positions, nodeValues, edgeIntersections, sectionVertices, sectionIndices, sectionWireframes);
+			}
+		}
+		return false;
+	});
+}
 
+void GeoUtil::pickZone(const ZoneSet& zones, const Ray& ray, const LinearBVH& tree, const QVector<QVector3D>& positions, QMap<float, QSet<Edge>>& pickEdgesMap, bool pickZoneMode, quint64 groupMask)
+{
+	traverseBVH(tree,
+		[&tree, &ray, groupMask](int index)
+	{
+		return (tree.groupMask(index) & groupMask) && tree.nodes[index].bound.intersect(ray);
+	},
+		[&](const uint32_t* zoneIndices, int zoneNum)
+	{
+		for (int k = 0; k < zoneNum; ++k)
+		{
+			uint32_t z = zoneIndices[k];
+			if (qZoneGroupBit(zones.groups[z]) & groupMask)
+			{
+				int facetNum = zones.facetNum(z);
 				if (pickZoneMode)
 				{
-					for (const Facet& facet : zone.facets)
+					for (int i = 0; i < facetNum; ++i)
 					{
 						float t;
 						QSet<Edge> pickEdges;
-						if (facet.intersect(nodeVertices, ray, t))
+						if (zones.facet(z, i).intersect(positions, ray, t))
 						{
 							float minT = 1e8f;
-							for (const Facet& f : zone.facets)
+							for (int j = 0; j < facetNum; ++j)
 							{
-								if (f.intersect(nodeVertices, ray, t))
+								Facet f = zones.facet(z, j);
+								if (f.intersect(positions, ray, t))
 								{
 									minT = qMin(minT, t);
 								}
@@ -808,10 +1865,11 @@ void GeoUtil::pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* node,
 				}
 				else
 				{
-					for (const Facet& facet : zone.facets)
+					for (int i = 0; i < facetNum; ++i)
 					{
 						float t;
-						if (facet.intersect(nodeVertices, ray, t))
+						Facet facet = zones.facet(z, i);
+						if (facet.intersect(positions, ray, t))
 						{
 							pickEdgesMap[t] = facet.getEdges();
 						}
@@ -819,16 +1877,6 @@ void GeoUtil::pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* node,
 				}
 			}
 		}
-	}
-	else
-	{
-		if (node->children[0]->bound.intersect(ray))
-		{
-			pickZone(zones, ray, node->children[0], nodeVertices, pickEdgesMap, pickZoneMode);
-		}
-		if (node->children[1]->bound.intersect(ray))
-		{
-			pickZone(zones, ray, node->children[1], nodeVertices, pickEdgesMap, pickZoneMode);
-		}
-	}
+		return false;
+	});
 }
@@ -1,43 +1,152 @@
 #pragma once
 
 #include "geotypes.h"
+#include <QBitArray>
+#include <QVarLengthArray>
+#include <QFuture>
+
+class QThreadPool;
 
 /**
 	μʵ
 */
 
+// ʱ߽бʾѼ㵫ཻıǣδıΪkInvalidIndex
+const uint32_t kNoIntersection = kInvalidIndex + 1;
+
+// λʱbvhҶڵͼԪջԤȣʱջתΪѷ䣩
+const int kBVHLeafSize = 3;
+const int kBVHStackSize = 64;
+
+// ͰSAHֵĬͰͰޡҶڵͼԪ
+const int kBVHBinNum = 16;
+const int kBVHMaxBinNum = 64;
+const int kBVHMaxLeafSize = 8;
+
+// йʱΪһ񹹽ͼԪޣֿ鲢мΧСͰŵͼԪ
+const int kBVHTaskSize = 1024;
+const int kBVHParallelPassSize = 8192;
+
+enum BVHSplitMethod
+{
+	BVHSplitMedian, BVHSplitSAH
+};
+
+// bvhSAHΪ  + ཻ * (ӽڵͼԪ * ӽڵ) / ڵ
+// ʱҶڵΪ ཻ * ͼԪ߳Ϊ0ʱȡ߳Ϊ1ʱй
+struct BVHBuildOptions
+{
+	BVHSplitMethod method = BVHSplitSAH;
+	int binNum = kBVHBinNum;
+	float traversalCost = 1.0f;
+	float intersectionCost = 1.0f;
+	int maxLeafSize = kBVHMaxLeafSize;
+	int threadCount = 0;
+	int taskSize = kBVHTaskSize;
+};
+
+// bvhͳƣSAH۰еĴϵ㣬Ըڵһ
+struct BVHStats
+{
+	double sahCost = 0.0;
+	int nodeNum = 0;
+	int leafNum = 0;
+	int depth = 0;
+	int maxLeafSize = 0;
+	double averageLeafSize = 0.0;
+	double averageLeafDepth = 0.0;
+};
+
 class GeoUtil
 {
+	// ֿģ鸴õԪмʰȡ
+	friend class BrickedModel;
+
 public:
 	static void loadObjMesh(const char* fileName, Mesh& mesh);
 	static void addFace(Mesh& mesh, uint32_t v0, uint32_t v1, uint32_t v2);
 	static void cleanMesh(Mesh& mesh);
+	static void buildFaceAdjacency(Mesh& mesh);
 	static void fixWindingOrder(Mesh& mesh);
-	static void clipZones(QVector<Zone>& zones, const Plane& plane, BVHTreeNode* root, QVector<NodeVertex>& nodeVertices, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices);
-	static void pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* root, const QVector<NodeVertex>& nodeVertices, QVector<uint32_t>& pickIndices, bool pickZoneMode = true);
-	static QVector<ClipLine> genIsolines(Mesh& mesh, QVector<NodeVertex>& nodeVertices, float value, BVHTreeNode* root);
+	static void clipZones(const ZoneSet& zones, const Plane& plane, const LinearBVH& tree, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QVector<uint32_t>& sectionWireframeIndices, quint64 groupMask = kAllZoneGroups);
+	static void pickZone(const ZoneSet& zones, const Ray& ray, const LinearBVH& tree, const QVector<QVector3D>& positions, QVector<uint32_t>& pickIndices, bool pickZoneMode = true, quint64 groupMask = kAllZoneGroups);
+	static QVector<ClipLine> genIsolines(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, float value, const IntervalTree& tree);
+	static void flattenIsolines(const QVector<ClipLine>& clipLines, float value, QVector<NodeVertex>& isolineVertices);
+	static void genIsosurface(const UniformGrids& uniformGrids, float value, QVector<NodeVertex>& isosurfaceVertices, QVector<uint32_t>& isosurfaceIndices);
 	static bool validateMesh(Mesh& mesh);
-	static bool interpZones(const QVector<Zone>& zones, BVHTreeNode* node, const QVector3D& point, float& value);
-	static bool inZones(const QVector<Zone>& zones, BVHTreeNode* node, const QVector3D& point);
+	static bool interpZones(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point, float& value);
+	static bool inZones(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point);
+	static bool locateZone(const ZoneSet& zones, const LinearBVH& tree, const QVector3D& point, uint32_t& zoneIndex);
+	static void sampleUniformGrids(const ZoneSet& zones, const LinearBVH& tree, UniformGrids& uniformGrids);
+	static void resampleUniformGrids(const ZoneSet& zones, UniformGrids& uniformGrids);
+	static void updateUniformGridPoints(UniformGrids& uniformGrids);
+	static void benchmarkMeshEdges(const Mesh& mesh);
+
+	static IntervalTree buildIntervalTree(const Mesh& mesh, const QVector<float>& nodeValues);
+	static void updateVoxelBlockTree(UniformGrids& uniformGrids);
+	static void benchmarkIntervalTree(const Mesh& mesh, const QVector<float>& nodeValues);
 
-	static BVHTreeNode* buildBVHTree(const QVector<Zone>& zones);
-	static BVHTreeNode* buildBVHTree(const Mesh& mesh);
-	static void destroyBVHTree(BVHTreeNode* root);
+	static LinearBVH buildBVHTree(const ZoneSet& zones, const BVHBuildOptions& options = BVHBuildOptions());
+	static BVHStats getBVHStats(const LinearBVH& tree, const BVHBuildOptions& options = BVHBuildOptions());
+	static void benchmarkBVH(const ZoneSet& zones, const QVector<QVector3D>& positions, const QVector<float>& nodeValues);
+	static void refitBVHTree(const ZoneSet& zones, LinearBVH& tree, int threadCount = 0);
+	static void updateZoneGeometry(ZoneSet& zones, const QVector<QVector3D>& positions, int threadCount = 0);
+	static quint64 updateBVHGroupMask(const ZoneSet& zones, LinearBVH& tree);
 
 private:
+	// ֵߵĽ㣬߱
+	struct IsoEdgeHits
+	{
+		QVector<qint32> edgeHits;		// ߱ŵţ-1ʾ޽
+		QVector<qint32> edges;
+		QVector<QVector3D> positions;
+	};
+
+	// йʱڵǰֵ̻߳ϲڵ㣬subtreeΪţleftΪ-1ҷʱΪҶڵ
+	struct BVHBuildNode
+	{
+		AABB bound;
+		int begin = 0;
+		int end = 0;
+		int left = -1;
+		int right = -1;
+		int subtree = -1;
+	};
+
 	static void fixWindingOrder(Mesh& mesh, const Face& mainFace, Face& neighborFace);
 	static void flipWindingOrder(Face& face);
-	static bool clipZone(const Zone& zone, const Plane& plane, QVector<NodeVertex>& nodeVertices, QMap<Edge, uint32_t>& intersectionIndexMap, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QSet<Edge>& sectionWireframes);
+	static bool clipZone(const ZoneSet& zones, int zoneIndex, const Plane& plane, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<uint32_t>& edgeIntersections, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, EdgeIndex& sectionWireframes);
 	static bool isManifordFace(const Mesh& mesh, const Face& face, bool strict = true);
-	static void traverseMesh(Mesh& mesh);
-	static void resetMeshVisited(Mesh& mesh);
-	static void resetZoneVisited(QVector<Zone>& zones);
-	static void resetBVHTree(BVHTreeNode* node);
-	static void clipZones(QVector<Zone>& zones, const Plane& plane, BVHTreeNode* node, QVector<NodeVertex>& nodeVertices, QMap<Edge, uint32_t>& intersectionIndexMap, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, QSet<Edge>& sectionWireframes);
-	static void pickZone(QVector<Zone>& zones, const Ray& ray, BVHTreeNode* node, const QVector<NodeVertex>& nodeVertices, QMap<float, QSet<Edge>>& pickEdgesMap, bool pickZoneMode);
-	static void findAllIsoEdges(Mesh& mesh, QVector<NodeVertex>& nodeVertices, float value, BVHTreeNode* node, QMap<Edge, QVector3D>& hits);
-	static void findIsoEdges(const Mesh& mesh, QVector<NodeVertex>& nodeVertices, const Face& face, float value, QMap<Edge, QVector3D>& hits);
-
-	static BVHTreeNode* buildBVHTree(const QVector<Zone>& zones, QVector<uint32_t>& zoneIndices, int begin, int end);
-	static BVHTreeNode* buildBVHTree(const Mesh& mesh, QVector<uint32_t>& faces, int begin, int end);
+	static QBitArray traverseMesh(const Mesh& mesh);
+	static void clipZones(const ZoneSet& zones, const Plane& plane, const LinearBVH& tree, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, QVector<uint32_t>& edgeIntersections, QVector<NodeVertex>& sectionVertices, QVector<uint32_t>& sectionIndices, EdgeIndex& sectionWireframes, quint64 groupMask);
+	static void pickZone(const ZoneSet& zones, const Ray& ray, const LinearBVH& tree, const QVector<QVector3D>& positions, QMap<float, QSet<Edge>>& pickEdgesMap, bool pickZoneMode, quint64 groupMask);
+	static void findAllIsoEdges(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, float value, const IntervalTree& tree, IsoEdgeHits& hits);
+	static void findIsoEdges(const Mesh& mesh, const QVector<QVector3D>& positions, const QVector<float>& nodeValues, int faceIndex, float value, IsoEdgeHits& hits);
+
+	static IntervalTree buildIntervalTree(const QVector<float>& mins, const QVector<float>& maxs);
+	static int buildIntervalNode(const QVector<float>& mins, const QVector<float>& maxs, uint32_t* primitives, IntervalTree& tree, int begin, int end);
+
+	static LinearBVH buildBVHTree(const QVector<AABB>& bounds, const BVHBuildOptions& options);
+	static int buildBVHNode(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const BVHBuildOptions& options, uint32_t* primitives, QVector<LinearBVHNode>& nodes, int begin, int end);
+	static int buildBVHTopNode(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const BVHBuildOptions& options, uint32_t* primitives, QThreadPool& threadPool, QVector<BVHBuildNode>& topNodes, QVector<QFuture<QVector<LinearBVHNode>>>& subtrees, int begin, int end);
+	static int spliceBVHNode(const QVector<BVHBuildNode>& topNodes, const QVector<QFuture<QVector<LinearBVHNode>>>& subtrees, LinearBVH& tree, int topIndex);
+	static void combineBVHBounds(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const uint32_t* primitives, int begin, int end, AABB& bound, AABB& centriodBound, QThreadPool* threadPool);
+	static int splitMedian(const QVector<QVector3D>& centriods, const AABB& centriodBound, uint32_t* primitives, int begin, int end);
+	static int splitSAH(const QVector<AABB>& bounds, const QVector<QVector3D>& centriods, const AABB& bound, const AABB& centriodBound, const BVHBuildOptions& options, uint32_t* primitives, int begin, int end, QThreadPool* threadPool);
+
+	// ֿ鲢ִchunkFunc(ֿ, ʼ, )̳߳Ϊʱڵǰִ߳
+	template <typename ChunkFunc>
+	static void runBVHChunks(QThreadPool* threadPool, int begin, int end, ChunkFunc chunkFunc);
+
+	// ͼԪΧprimitiveBound(ͼԪ)Եϸ½ڵΧУڵ϶ʱи
+	template <typename PrimitiveBound>
+	static void refitBVHNodes(LinearBVH& tree, PrimitiveBound primitiveBound, int threadCount);
+
+	// bvhnodeTest(ڵ)Ƿýڵ㣬leafVisitor(ͼԪ, ͼԪ)trueʱ
+	template <typename NodeTest, typename LeafVisitor>
+	static bool traverseBVH(const LinearBVH& tree, NodeTest nodeTest, LeafVisitor leafVisitor);
+
+	// ѯֵΧvalueͼԪÿͼԪvisitor(ͼԪ)
+	template <typename Visitor>
+	static void queryIntervalTree(const IntervalTree& tree, float value, Visitor visitor);
 };
\ No newline at end of file
@@ -1,6 +1,12 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QStatusBar>
+#include <QMessageBox>
+#include "modelloader.h"
+#include "edbwriter.h"
+#include "resultfieldstore.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -13,11 +19,68 @@ MainWindow::MainWindow(QWidget *parent) :
     displayModeLayouts.append(ui->isolineHorizontalLayout);
     onDisplayModeComboBoxCurrentIndexChanged(ui->displayModeComboBox->currentIndex());
 
+    // ״̬ʾģͼء
+    taskLabel = new QLabel(this);
+    taskProgressBar = new QProgressBar(this);
+    cancelTaskButton = new QPushButton(QStringLiteral("ȡ"), this);
+    statusBar()->addWidget(taskLabel);
+    statusBar()->addWidget(taskProgressBar);
+    statusBar()->addWidget(cancelTaskButton);
+    setTaskProgressVisible(false);
+
+    // ״̬Ҳʾʱ䲽ſؼ򿪽кɼ
+    playButton = new QPushButton(QStringLiteral(""), this);
+    timeStepSlider = new QSlider(Qt::Horizontal, this);
+    timeStepLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(playButton);
+    statusBar()->addPermanentWidget(timeStepSlider);
+    statusBar()->addPermanentWidget(timeStepLabel);
+    setTimeStepControlsVisible(false);
+
+    // ״̬ҲʾʾؼŴϵ飬ģֱ֧ʾʱɼ
+    deformationCheckBox = new QCheckBox(QStringLiteral(""), this);
+    deformationScaleSlider = new QSlider(Qt::Horizontal, this);
+    deformationScaleSlider->setRange(0, kDeformationScaleSteps);
+    deformationScaleLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(deformationCheckBox);
+    statusBar()->addPermanentWidget(deformationScaleSlider);
+    statusBar()->addPermanentWidget(deformationScaleLabel);
+    defaultDeformationScale = 1.0f;
+    resetDeformationControls();
+
+    // ״̬Ҳʾֶѡģжֶʱɼ
+    displayFieldComboBox = new QComboBox(this);
+    displayFieldComboBox->setToolTip(QStringLiteral("ʾֶ"));
+    statusBar()->addPermanentWidget(displayFieldComboBox);
+    displayFieldComboBox->setVisible(false);
+
+    // ҲͣгԪ飬ѡʾ/
+    zoneGroupDock = new QDockWidget(QStringLiteral("Ԫ"), this);
+    zoneGroupList = new QListWidget(zoneGroupDock);
+    zoneGroupDock->setWidget(zoneGroupList);
+    addDockWidget(Qt::RightDockWidgetArea, zoneGroupDock);
+    zoneGroupDock->setVisible(false);
+
     connect(ui->openGLWidget, SIGNAL(onModelStartLoad()), this, SLOT(onModelStartLoad()));
+    connect(ui->openGLWidget, SIGNAL(onModelLoadProgress(int, int)), this, SLOT(onModelLoadProgress(int, int)));
     connect(ui->openGLWidget, SIGNAL(onModelFinishLoad()), this, SLOT(onModelFinishLoad()));
+    connect(ui->openGLWidget, SIGNAL(onModelCancelLoad()), this, SLOT(onModelCancelLoad()));
+    connect(ui->openGLWidget, SIGNAL(onModelStartExport()), this, SLOT(onModelStartExport()));
+    connect(ui->openGLWidget, SIGNAL(onModelExportProgress(int, int)), this, SLOT(onModelExportProgress(int, int)));
+    connect(ui->openGLWidget, SIGNAL(onModelFinishExport()), this, SLOT(onModelFinishExport()));
+    connect(cancelTaskButton, SIGNAL(clicked()), this, SLOT(cancelTask()));
+    connect(ui->openGLWidget, SIGNAL(onTimeStepChanged(int)), this, SLOT(onTimeStepChanged(int)));
+    connect(ui->openGLWidget, SIGNAL(onResultsReloaded()), this, SLOT(onResultsReloaded()));
+    connect(timeStepSlider, SIGNAL(valueChanged(int)), this, SLOT(onTimeStepSliderValueChanged(int)));
+    connect(playButton, SIGNAL(clicked()), this, SLOT(togglePlaying()));
+    connect(zoneGroupList, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(onZoneGroupItemChanged(QListWidgetItem*)));
+    connect(deformationCheckBox, SIGNAL(stateChanged(int)), this, SLOT(onDeformationCheckBoxStateChanged(int)));
+    connect(deformationScaleSlider, SIGNAL(valueChanged(int)), this, SLOT(onDeformationScaleSliderValueChanged(int)));
+    connect(displayFieldComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onDisplayFieldComboBoxCurrentIndexChanged(int)));
 
     connect(ui->openAction, SIGNAL(triggered()), this, SLOT(openFile()));
-    connect(ui->exportAction, SIGNAL(triggered()), this, SLOT(exportToEDB()));
+    connect(ui->openSeriesAction, SIGNAL(triggered()), this, SLOT(openResultSeries()));
+    connect(ui->exportAction, SIGNAL(triggered()), this, SLOT(exportModel()));
 
     connect(ui->displayModeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onDisplayModeComboBoxCurrentIndexChanged(int)));
     connect(ui->pickModeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onPickModeComboBoxCurrentIndexChanged(int)));
@@ -128,22 +191,88 @@ void MainWindow::openFile()
 	}
 }
 
-void MainWindow::exportToEDB()
+void MainWindow::openResultSeries()
+{
+	QString dirPath = QFileDialog::getExistingDirectory(this, QStringLiteral("򿪽"), "asset/data/");
+	if (dirPath.isEmpty())
+	{
+		return;
+	}
+
+	if (!ui->openGLWidget->openResultSeries(dirPath))
+	{
+		setTimeStepControlsVisible(false);
+		QMessageBox::critical(this, QStringLiteral("ʾ"),
+			QStringLiteral("򿪽ʧܣ"),
+			QMessageBox::Ok);
+		return;
+	}
+
+	timeStepSlider->blockSignals(true);
+	timeStepSlider->setRange(0, ui->openGLWidget->getTimeStepCount() - 1);
+	timeStepSlider->blockSignals(false);
+	onTimeStepChanged(0);
+	setTimeStepControlsVisible(true);
+}
+
+void MainWindow::exportModel()
 {
-	QString exportPath = QFileDialog::getSaveFileName(this, QStringLiteral(""), "asset/data/export", tr("Database file(*.edb)"));
-	if (!exportPath.isEmpty())
+	// ׺ѡʽPLYǰĽ桢ֵ漰ֵ
+	QString exportPath = QFileDialog::getSaveFileName(this, QStringLiteral(""), "asset/data/export",
+		tr("Database file(*.edb);;VTK unstructured grid(*.vtu);;PLY geometry(*.ply)"));
+	QString suffix = QFileInfo(exportPath).suffix().toLower();
+	if (suffix == "vtu")
+	{
+		ui->openGLWidget->exportToVTU(exportPath);
+	}
+	else if (suffix == "ply")
+	{
+		ui->openGLWidget->exportToPLY(exportPath);
+	}
+	else if (!exportPath.isEmpty())
 	{
 		ui->openGLWidget->exportToEDB(exportPath);
 	}
 }
 
+void MainWindow::cancelTask()
+{
+	if (ui->openGLWidget->isExporting())
+	{
+		ui->openGLWidget->cancelExport();
+	}
+	else
+	{
+		ui->openGLWidget->cancelLoad();
+	}
+	taskLabel->setText(QStringLiteral("ȡ..."));
+}
+
 void MainWindow::onModelStartLoad()
 {
+	// ڼֹ򿪼ǰģԿɲ
+	setFileActionsEnabled(false);
+	taskLabel->clear();
+	taskProgressBar->setRange(0, LoadStageNum * 100);
+	taskProgressBar->setValue(0);
+	setTaskProgressVisible(true);
+}
 
+void MainWindow::onModelLoadProgress(int stage, int progress)
+{
+	taskLabel->setText(ModelLoader::getStageName(stage));
+	taskProgressBar->setValue(stage * 100 + progress);
 }
 
 void MainWindow::onModelFinishLoad()
 {
+	setFileActionsEnabled(true);
+	setTaskProgressVisible(false);
+	setTimeStepControlsVisible(false);
+	updateZoneGroupList();
+	resetDeformationControls();
+	updateDisplayFieldList();
+
 	clipPlane.origin = QVector3D(0.0f, 0.0f, 100.0f);
 	clipPlane.normal = QVector3D(0.0f, -2.0f, -1.0f);
 	isoValueRange = ui->openGLWidget->getIsoValueRange();
@@ -160,6 +289,65 @@ void MainWindow::onModelFinishLoad()
 	ui->isolineValueSlider->setValue(ui->isosurfaceValueSlider->value());
 }
 
+void MainWindow::onModelCancelLoad()
+{
+	setFileActionsEnabled(true);
+	setTaskProgressVisible(false);
+}
+
+void MainWindow::onModelStartExport()
+{
+	// ڼֹ򿪼ǰģԿСʰȡ
+	setFileActionsEnabled(false);
+	taskLabel->clear();
+	taskProgressBar->setRange(0, ExportTableNum * 100);
+	taskProgressBar->setValue(0);
+	setTaskProgressVisible(true);
+}
+
+void MainWindow::onModelExportProgress(int table, int progress)
+{
+	taskLabel->setText(EDBWriter::getTableName(table));
+	taskProgressBar->setValue(table * 100 + progress);
+}
+
+void MainWindow::onModelFinishExport()
+{
+	setFileActionsEnabled(true);
+	setTaskProgressVisible(false);
+}
+
+void MainWindow::onTimeStepSliderValueChanged(int value)
+{
+	ui->openGLWidget->setTimeStep(value);
+}
+
+void MainWindow::onTimeStepChanged(int index)
+{
+	// ʱOpenGLWindowֵͬʱظлʱ䲽
+	timeStepSlider->setValue(index);
+	timeStepLabel->setText(QStringLiteral("ʱ䲽 %1 (%2/%3)")
+		.arg(ui->openGLWidget->getTimeStepNumber(index))
+		.arg(index + 1)
+		.arg(ui->openGLWidget->getTimeStepCount()));
+}
+
+void MainWindow::onResultsReloaded()
+{
+	// ֵΧܱ仯λӳֵ
+	isoValueRange = ui->openGLWidget->getIsoValueRange();
+	onIsosurfaceValueChanged(ui->isosurfaceValueSlider->value());
+	onIsolineValueChanged(ui->isolineValueSlider->value());
+	statusBar()->showMessage(QStringLiteral("Ѹ"), 3000);
+}
+
+void MainWindow::togglePlaying()
+{
+	bool playing = !ui->openGLWidget->isPlaying();
+	ui->openGLWidget->setPlaying(playing);
+	playButton->setText(playing ? QStringLiteral("ͣ") : QStringLiteral(""));
+}
+
 void MainWindow::setLayoutVisible(QLayout* layout, bool flag)
 {
 	for (int i = 0; i < layout->count(); ++i)
@@ -175,3 +363,118 @@ void MainWindow::setLayoutVisible(QLayout* layout, bool flag)
         }
 	}
 }
+
+void MainWindow::setTaskProgressVisible(bool flag)
+{
+	taskLabel->setVisible(flag);
+	taskProgressBar->setVisible(flag);
+	cancelTaskButton->setVisible(flag);
+}
+
+void MainWindow::setFileActionsEnabled(bool flag)
+{
+	ui->openAction->setEnabled(flag);
+	ui->openSeriesAction->setEnabled(flag);
+	ui->exportAction->setEnabled(flag);
+}
+
+void MainWindow::setTimeStepControlsVisible(bool flag)
+{
+	playButton->setText(QStringLiteral(""));
+	playButton->setVisible(flag);
+	timeStepSlider->setVisible(flag);
+	timeStepLabel->setVisible(flag);
+}
+
+void MainWindow::onZoneGroupItemChanged(QListWidgetItem* item)
+{
+	ui->openGLWidget->setZoneGroupVisible(zoneGroupList->row(item), item->checkState() == Qt::Checked);
+}
+
+void MainWindow::updateZoneGroupList()
+{
+	// бʱźţ
+	QStringList groupNames = ui->openGLWidget->getZoneGroupNames();
+	zoneGroupList->blockSignals(true);
+	zoneGroupList->clear();
+	for (int i = 0; i < groupNames.count(); ++i)
+	{
+		QListWidgetItem* item = new QListWidgetItem(groupNames[i], zoneGroupList);
+		item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+		item->setCheckState(ui->openGLWidget->isZoneGroupVisible(i) ? Qt::Checked : Qt::Unchecked);
+	}
+	zoneGroupList->blockSignals(false);
+	zoneGroupDock->setVisible(groupNames.count() > 1);
+}
+
+void MainWindow::onDeformationCheckBoxStateChanged(int state)
+{
+	if (!ui->openGLWidget->setShowDeformation(state == Qt::Checked))
+	{
+		deformationCheckBox->blockSignals(true);
+		deformationCheckBox->setChecked(false);
+		deformationCheckBox->blockSignals(false);
+	}
+	deformationScaleSlider->setEnabled(ui->openGLWidget->isShowingDeformation());
+}
+
+void MainWindow::onDeformationScaleSliderValueChanged(int value)
+{
+	float scale = defaultDeformationScale * value / kDefaultDeformationScaleStep;
+	deformationScaleLabel->setText(QStringLiteral("Ŵ %1 ").arg(scale, 0, 'g', 3));
+	ui->openGLWidget->setDeformationScale(scale);
+}
+
+void MainWindow::resetDeformationControls()
+{
+	// ģͰλƷΧģͳߴȷĬϷŴϵʾĬϹر
+	bool visible = ui->openGLWidget->canShowDeformation();
+	defaultDeformationScale = ui->openGLWidget->getDefaultDeformationScale();
+	deformationCheckBox->blockSignals(true);
+	deformationCheckBox->setChecked(false);
+	deformationCheckBox->blockSignals(false);
+	deformationScaleSlider->setValue(kDefaultDeformationScaleStep);
+	onDeformationScaleSliderValueChanged(deformationScaleSlider->value());
+	deformationScaleSlider->setEnabled(false);
+	deformationCheckBox->setVisible(visible);
+	deformationScaleSlider->setVisible(visible);
+	deformationScaleLabel->setVisible(visible);
+}
+
+void MainWindow::onDisplayFieldComboBoxCurrentIndexChanged(int index)
+{
+	// ֶ״ʾʱӽļȡȡʧʱָԭѡ
+	int field = displayFieldComboBox->itemData(index).toInt();
+	if (!ui->openGLWidget->setDisplayField(field))
+	{
+		displayFieldComboBox->blockSignals(true);
+		displayFieldComboBox->setCurrentIndex(displayFieldComboBox->findData(ui->openGLWidget->getDisplayField()));
+		displayFieldComboBox->blockSignals(false);
+		QMessageBox::critical(this, QStringLiteral("ʾ"),
+			QStringLiteral("ȡֶʧܣ"),
+			QMessageBox::Ok);
+		return;
+	}
+
+	// ֵΧʾֶα仯λӳֵ
+	isoValueRange = ui->openGLWidget->getIsoValueRange();
+	onIsosurfaceValueChanged(ui->isosurfaceValueSlider->value());
+	onIsolineValueChanged(ui->isolineValueSlider->value());
+}
+
+void MainWindow::updateDisplayFieldList()
+{
+	// гģṩĽֶΣģĬʾλ
+	displayFieldComboBox->blockSignals(true);
+	displayFieldComboBox->clear();
+	for (int field = 0; field < ResultFieldTypeNum; ++field)
+	{
+		if (ui->openGLWidget->hasResultField(field))
+		{
+			displayFieldComboBox->addItem(ResultFieldStore::getFieldName(field), field);
+		}
+	}
+	displayFieldComboBox->setCurrentIndex(displayFieldComboBox->findData(ui->openGLWidget->getDisplayField()));
+	displayFieldComboBox->blockSignals(false);
+	displayFieldComboBox->setVisible(displayFieldComboBox->count() > 1);
+}
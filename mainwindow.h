@@ -2,9 +2,21 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSlider>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDockWidget>
+#include <QListWidget>
 
 #include "openglwindow.h"
 
+// ηŴϵĿ̶ĬϿ̶ȣĬϿ̶ȶӦĬϷŴϵŴϵ̶ȳȣ
+const int kDeformationScaleSteps = 100;
+const int kDefaultDeformationScaleStep = 20;
+
 namespace Ui {
 class MainWindow;
 }
@@ -36,19 +48,63 @@ public slots:
 	void onIsolineShowWireframeCheckBoxStateChanged(int state);
 
 	void openFile();
-	void exportToEDB();
+	void openResultSeries();
+	void exportModel();
+
+	void cancelTask();
 
 	void onModelStartLoad();
+	void onModelLoadProgress(int stage, int progress);
 	void onModelFinishLoad();
+	void onModelCancelLoad();
+	void onModelStartExport();
+	void onModelExportProgress(int table, int progress);
+	void onModelFinishExport();
+
+	void onTimeStepSliderValueChanged(int value);
+	void onTimeStepChanged(int index);
+	void togglePlaying();
+	void onResultsReloaded();
+
+	void onZoneGroupItemChanged(QListWidgetItem* item);
+
+	void onDeformationCheckBoxStateChanged(int state);
+	void onDeformationScaleSliderValueChanged(int value);
+
+	void onDisplayFieldComboBoxCurrentIndexChanged(int index);
 
 private:
 	void setLayoutVisible(QLayout* layout, bool flag);
+	void setTaskProgressVisible(bool flag);
+	void setFileActionsEnabled(bool flag);
+	void setTimeStepControlsVisible(bool flag);
+	void updateZoneGroupList();
+	void resetDeformationControls();
+	void updateDisplayFieldList();
 
     Ui::MainWindow *ui;
 
 	QVector<QLayout*> displayModeLayouts;
 	Plane clipPlane;
 	QVector2D isoValueRange;
+
+	QLabel* taskLabel;
+	QProgressBar* taskProgressBar;
+	QPushButton* cancelTaskButton;
+
+	QPushButton* playButton;
+	QSlider* timeStepSlider;
+	QLabel* timeStepLabel;
+
+	QCheckBox* deformationCheckBox;
+	QSlider* deformationScaleSlider;
+	QLabel* deformationScaleLabel;
+	float defaultDeformationScale;
+
+	QComboBox* displayFieldComboBox;
+
+	QDockWidget* zoneGroupDock;
+	QListWidget* zoneGroupList;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,326 @@
+#include "meshwriter.h"
+#include "resultfieldstore.h"
+#include <QSaveFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+// ԪͶӦVTKԪͼڵ˳FLAC3Dڵ˳ӳ䵽VTKڵ˳
+const int kVTKTetra = 10;
+const int kVTKHexahedron = 12;
+const int kVTKWedge = 13;
+const int kVTKPyramid = 14;
+const int kVTKConvexPointSet = 41;
+
+static const int kBrickOrder[8] = { 0, 1, 4, 2, 3, 6, 7, 5 };
+static const int kDegeneratedBrickOrder[8] = { 0, 1, 4, 2, 3, 6, 6, 5 };
+static const int kWedgeOrder[6] = { 0, 3, 1, 2, 5, 4 };
+static const int kPyramidOrder[5] = { 0, 1, 4, 2, 3 };
+static const int kTetrahedronOrder[4] = { 0, 1, 2, 3 };
+static const int kIdentityOrder[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// MeshWriter::StreamԱʵ
+MeshWriter::Stream::Stream(QSaveFile& file) : file(file)
+{
+	buffer.reserve(kMeshWriteBufferSize);
+	failed = false;
+}
+
+void MeshWriter::Stream::write(const void* src, qint64 length)
+{
+	// Сƴӵֱд
+	if (buffer.size() + length > kMeshWriteBufferSize)
+	{
+		flush();
+	}
+
+	if (length >= kMeshWriteBufferSize)
+	{
+		failed |= file.write(reinterpret_cast<const char*>(src), length) != length;
+	}
+	else
+	{
+		buffer.append(reinterpret_cast<const char*>(src), length);
+	}
+}
+
+void MeshWriter::Stream::writeText(const QString& text)
+{
+	QByteArray bytes = text.toLatin1();
+	write(bytes.constData(), bytes.size());
+}
+
+bool MeshWriter::Stream::flush()
+{
+	if (!buffer.isEmpty())
+	{
+		failed |= file.write(buffer) != buffer.size();
+		buffer.clear();
+	}
+	return !failed;
+}
+
+// MeshWriterԱʵ
+bool MeshWriter::saveVTU(const QString& fileName, const NodeAttributes& nodeAttributes, const ZoneSet& zones, ResultFieldStore* resultFields)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	qint64 nodeNum = nodeAttributes.count();
+	qint64 zoneNum = zones.count();
+	qint64 connectivityNum = 0;
+	for (int z = 0; z < zoneNum; ++z)
+	{
+		const int* order;
+		int count;
+		vtkCellType(zones, z, order, count);
+		connectivityNum += count;
+	}
+
+	// ݿĳ֪ԤappendedеƫƣÿǰUInt64ȣ
+	qint64 offset = 0;
+	auto dataArray = [&offset](const QString& type, const QString& name, int componentNum, qint64 length) {
+		QString text = QString("        <DataArray type=\"%1\"").arg(type);
+		if (!name.isEmpty())
+		{
+			text += QString(" Name=\"%1\"").arg(name);
+		}
+		if (componentNum > 1)
+		{
+			text += QString(" NumberOfComponents=\"%1\"").arg(componentNum);
+		}
+		text += QString(" format=\"appended\" offset=\"%1\"/>\n").arg(offset);
+		offset += sizeof(quint64) + length;
+		return text;
+	};
+
+	QString header;
+	header += "<?xml version=\"1.0\"?>\n";
+	header += "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\">\n";
+	header += "  <UnstructuredGrid>\n";
+	header += QString("    <Piece NumberOfPoints=\"%1\" NumberOfCells=\"%2\">\n").arg(nodeNum).arg(zoneNum);
+	// λƷȫʱŵλʸдȱʸ
+	bool hasDeformation = nodeAttributes.hasDeformation();
+	header += hasDeformation ? "      <PointData Scalars=\"USUM\" Vectors=\"U\">\n" : "      <PointData Scalars=\"USUM\">\n";
+	header += dataArray("Float32", ResultFieldStore::getFieldName(FieldUSUM), 1, nodeNum * sizeof(float));
+	if (hasDeformation)
+	{
+		header += dataArray("Float32", "U", 3, nodeNum * sizeof(float) * 3);
+	}
+	for (int f = FieldUZ + 1; f < ResultFieldTypeNum; ++f)
+	{
+		header += dataArray("Float32", ResultFieldStore::getFieldName(f), 1, nodeNum * sizeof(float));
+	}
+	header += "      </PointData>\n";
+	header += "      <CellData Scalars=\"Group\">\n";
+	header += dataArray("Int32", "Group", 1, zoneNum * sizeof(qint32));
+	header += "      </CellData>\n";
+	header += "      <Points>\n";
+	header += dataArray("Float32", "", 3, nodeNum * sizeof(float) * 3);
+	header += "      </Points>\n";
+	header += "      <Cells>\n";
+	header += dataArray("UInt32", "connectivity", 1, connectivityNum * sizeof(quint32));
+	header += dataArray("Int64", "offsets", 1, zoneNum * sizeof(qint64));
+	header += dataArray("UInt8", "types", 1, zoneNum * sizeof(quint8));
+	header += "      </Cells>\n";
+	header += "    </Piece>\n";
+	header += "  </UnstructuredGrid>\n";
+	header += "  <AppendedData encoding=\"raw\">\n   _";
+
+	Stream stream(file);
+	stream.writeText(header);
+
+	// ڵλȡԽڵݣֶδصڵʱʽ洢ȡд꼴ͷţ
+	const QVector<float>& totalDeformation = nodeAttributes.fields[FieldUSUM];
+	stream.write(quint64(nodeNum * sizeof(float)));
+	stream.write(totalDeformation.constData(), nodeNum * sizeof(float));
+
+	if (hasDeformation)
+	{
+		const QVector<float>& deformationX = nodeAttributes.fields[FieldUX];
+		const QVector<float>& deformationY = nodeAttributes.fields[FieldUY];
+		const QVector<float>& deformationZ = nodeAttributes.fields[FieldUZ];
+		stream.write(quint64(nodeNum * sizeof(float) * 3));
+		for (int i = 0; i < nodeNum; ++i)
+		{
+			stream.write(QVector3D(deformationX[i], deformationY[i], deformationZ[i]));
+		}
+	}
+
+	for (int f = FieldUZ + 1; f < ResultFieldTypeNum; ++f)
+	{
+		QVector<float> values;
+		if (nodeAttributes.hasField(f))
+		{
+			values = nodeAttributes.fields[f];
+		}
+		else if (!resultFields || !resultFields->field(f, values) || values.count() != nodeNum)
+		{
+			values.fill(0.0f, nodeNum);
+		}
+		stream.write(quint64(nodeNum * sizeof(float)));
+		stream.write(values.constData(), nodeNum * sizeof(float));
+	}
+
+	// Ԫ
+	stream.write(quint64(zoneNum * sizeof(qint32)));
+	stream.write(zones.groups.constData(), zoneNum * sizeof(qint32));
+
+	// ڵ
+	stream.write(quint64(nodeNum * sizeof(float) * 3));
+	stream.write(nodeAttributes.positions.constData(), nodeNum * sizeof(QVector3D));
+
+	// Ԫ
+	stream.write(quint64(connectivityNum * sizeof(quint32)));
+	for (int z = 0; z < zoneNum; ++z)
+	{
+		const int* order;
+		int count;
+		vtkCellType(zones, z, order, count);
+		const quint32* vertices = zones.zoneVertices(z);
+		for (int i = 0; i < count; ++i)
+		{
+			stream.write(vertices[order[i]]);
+		}
+	}
+
+	stream.write(quint64(zoneNum * sizeof(qint64)));
+	qint64 end = 0;
+	for (int z = 0; z < zoneNum; ++z)
+	{
+		const int* order;
+		int count;
+		vtkCellType(zones, z, order, count);
+		end += count;
+		stream.write(end);
+	}
+
+	stream.write(quint64(zoneNum * sizeof(quint8)));
+	for (int z = 0; z < zoneNum; ++z)
+	{
+		const int* order;
+		int count;
+		stream.write(quint8(vtkCellType(zones, z, order, count)));
+	}
+
+	stream.writeText("\n  </AppendedData>\n</VTKFile>\n");
+	if (!stream.flush() || !file.commit())
+	{
+		return false;
+	}
+
+	qint64 saveTime = profileTimer.elapsed();
+	qDebug() << "save vtu time:" << saveTime << "size(KB):" << (file.size() >> 10);
+	return true;
+}
+
+bool MeshWriter::savePLY(const QString& fileName, const QVector<NodeVertex>& vertices, const QVector<uint32_t>& indices, int primitiveSize, int field)
+{
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	int primitiveNum = (indices.isEmpty() ? vertices.count() : indices.count()) / primitiveSize;
+
+	// ʾֶεֵĬΪλƣдΪfaceԪأ߶дΪedgeԪ
+	QString header;
+	header += "ply\n";
+	header += "format binary_little_endian 1.0\n";
+	header += "comment NumericalModelingViewer\n";
+	header += QString("element vertex %1\n").arg(vertices.count());
+	header += "property float x\n";
+	header += "property float y\n";
+	header += "property float z\n";
+	header += QString("property float %1\n").arg(ResultFieldStore::getFieldName(field).toLower());
+	if (primitiveSize == 2)
+	{
+		header += QString("element edge %1\n").arg(primitiveNum);
+		header += "property uint vertex1\n";
+		header += "property uint vertex2\n";
+	}
+	else
+	{
+		header += QString("element face %1\n").arg(primitiveNum);
+		header += "property list uchar uint vertex_indices\n";
+	}
+	header += "end_header\n";
+
+	Stream stream(file);
+	stream.writeText(header);
+
+	for (const NodeVertex& vertex : vertices)
+	{
+		stream.write(vertex.position);
+		stream.write(vertex.value);
+	}
+
+	for (int i = 0; i < primitiveNum; ++i)
+	{
+		if (primitiveSize != 2)
+		{
+			stream.write(quint8(primitiveSize));
+		}
+
+		if (indices.isEmpty())
+		{
+			for (int j = 0; j < primitiveSize; ++j)
+			{
+				stream.write(quint32(i * primitiveSize + j));
+			}
+		}
+		else
+		{
+			stream.write(indices.constData() + i * primitiveSize, primitiveSize * sizeof(uint32_t));
+		}
+	}
+
+	if (!stream.flush() || !file.commit())
+	{
+		return false;
+	}
+
+	qint64 saveTime = profileTimer.elapsed();
+	qDebug() << "save ply time:" << saveTime << "size(KB):" << (file.size() >> 10);
+	return true;
+}
+
+int MeshWriter::vtkCellType(const ZoneSet& zones, int zoneIndex, const int*& order, int& count)
+{
+	switch (zones.type(zoneIndex))
+	{
+	case Brick:
+		order = kBrickOrder;
+		count = 8;
+		return kVTKHexahedron;
+	case DegeneratedBrick:
+		order = kDegeneratedBrickOrder;
+		count = 8;
+		return kVTKHexahedron;
+	case Wedge:
+		order = kWedgeOrder;
+		count = 6;
+		return kVTKWedge;
+	case Pyramid:
+		order = kPyramidOrder;
+		count = 5;
+		return kVTKPyramid;
+	case Tetrahedron:
+		order = kTetrahedronOrder;
+		count = 4;
+		return kVTKTetra;
+	default:
+		order = kIdentityOrder;
+		count = zones.vertexNum(zoneIndex);
+		return kVTKConvexPointSet;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "geotypes.h"
+#include <QByteArray>
+
+class QSaveFile;
+class ResultFieldStore;
+
+/**
+	񵼳ࣨģдΪVTUappended raw桢ֵ漰ֵдΪPLY
+	ݴڴ鰴ֱдļıʽ
+*/
+
+const int kMeshWriteBufferSize = 1 << 20;
+
+class MeshWriter
+{
+public:
+	static bool saveVTU(const QString& fileName, const NodeAttributes& nodeAttributes, const ZoneSet& zones, ResultFieldStore* resultFields = nullptr);
+
+	// indicesΪʱ㰴ͼԪУ벻ʹĻƷʽһ£
+	static bool savePLY(const QString& fileName, const QVector<NodeVertex>& vertices, const QVector<uint32_t>& indices, int primitiveSize = 3, int field = FieldUSUM);
+
+private:
+	class Stream
+	{
+	public:
+		Stream(QSaveFile& file);
+
+		template <typename T>
+		void write(const T& value)
+		{
+			write(&value, sizeof(T));
+		}
+		void write(const void* src, qint64 length);
+		void writeText(const QString& text);
+		bool flush();
+
+	private:
+		QSaveFile& file;
+		QByteArray buffer;
+		bool failed;
+	};
+
+	static int vtkCellType(const ZoneSet& zones, int zoneIndex, const int*& order, int& count);
+};
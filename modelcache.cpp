@@ -0,0 +1,373 @@
+#include "modelcache.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QDebug>
+
+// ModelCacheԱʵ
+ModelCache::ModelCache()
+{
+	saveFile = nullptr;
+	written = 0;
+	data = nullptr;
+	size = 0;
+	offset = 0;
+}
+
+ModelCache::~ModelCache()
+{
+	if (saveFile)
+	{
+		saveFile->cancelWriting();
+		SAFE_DELETE(saveFile);
+	}
+	close();
+}
+
+QString ModelCache::cacheFileName(const QString& fileName)
+{
+	// ļԴļͬһĿ¼Դļ׺ͬf3grid/edb
+	return fileName + ".nmvcache";
+}
+
+QStringList ModelCache::sourceFileNames(const QString& fileName)
+{
+	QStringList fileNames = { fileName };
+
+	// f3gridģ͵ļͬĿ¼µĽļ
+	QFileInfo fileInfo(fileName);
+	if (fileInfo.suffix() == "f3grid")
+	{
+		fileNames.append(fileInfo.absolutePath() + "/gridpoint_result.txt");
+		fileNames.append(fileInfo.absolutePath() + "/zone_result.txt");
+	}
+	return fileNames;
+}
+
+bool ModelCache::create(const QString& cacheFileName, const QStringList& sourceFileNames)
+{
+	QVector<ModelCacheSource> sources(sourceFileNames.count());
+	for (int i = 0; i < sourceFileNames.count(); ++i)
+	{
+		if (!readSource(sourceFileNames[i], true, sources[i]))
+		{
+			return false;
+		}
+	}
+
+	saveFile = new QSaveFile(cacheFileName);
+	if (!saveFile->open(QIODevice::WriteOnly))
+	{
+		SAFE_DELETE(saveFile);
+		return false;
+	}
+
+	// ļͷʶ汾żԴļϢ
+	writeValue(kModelCacheMagic);
+	writeValue(kModelCacheVersion);
+	writeArray(sources);
+	return true;
+}
+
+bool ModelCache::commit()
+{
+	if (!saveFile)
+	{
+		return false;
+	}
+
+	bool result = saveFile->commit();
+	SAFE_DELETE(saveFile);
+	return result;
+}
+
+qint64 ModelCache::tell() const
+{
+	// дʱΪдĳȣȡʱΪǰȡλ
+	return saveFile ? written : offset;
+}
+
+bool ModelCache::open(const QString& cacheFileName, const QStringList& sourceFileNames)
+{
+	file.setFileName(cacheFileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	size = file.size();
+	data = reinterpret_cast<const char*>(file.map(0, size));
+	offset = 0;
+	if (!data)
+	{
+		close();
+		return false;
+	}
+
+	quint32 magic;
+	quint32 version;
+	QVector<ModelCacheSource> sources;
+	if (!readValue(magic) || magic != kModelCacheMagic ||
+		!readValue(version) || version != kModelCacheVersion ||
+		!readArray(sources) || sources.count() != sourceFileNames.count())
+	{
+		close();
+		return false;
+	}
+
+	// СͬԴļѱ仯޸ʱ䲻ͬʱٱȽݹϣ
+	for (int i = 0; i < sources.count(); ++i)
+	{
+		ModelCacheSource source;
+		if (!readSource(sourceFileNames[i], false, source) || source.size != sources[i].size)
+		{
+			close();
+			return false;
+		}
+
+		if (source.lastModified != sources[i].lastModified &&
+			(!hashFile(sourceFileNames[i], source.hash) || memcmp(source.hash, sources[i].hash, sizeof(source.hash)) != 0))
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void ModelCache::close()
+{
+	if (data)
+	{
+		file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(data)));
+		data = nullptr;
+	}
+	file.close();
+	size = 0;
+	offset = 0;
+}
+
+qint64 ModelCache::fileSize() const
+{
+	return size;
+}
+
+bool ModelCache::seek(qint64 pos)
+{
+	if (!data || pos < 0 || pos > size)
+	{
+		return false;
+	}
+
+	offset = pos;
+	return true;
+}
+
+bool ModelCache::skipArray(qint64* count)
+{
+	// ֻȡͷ
+	quint32 elementSize;
+	quint32 reserved;
+	qint64 num;
+	if (!read(&elementSize, sizeof(elementSize)) || !read(&reserved, sizeof(reserved)) || !read(&num, sizeof(num)))
+	{
+		return false;
+	}
+	if (num < 0 || num * (qint64)elementSize > size - offset)
+	{
+		return false;
+	}
+
+	offset += num * elementSize;
+	skipAlign();
+	if (count)
+	{
+		*count = num;
+	}
+	return true;
+}
+
+void ModelCache::writeZones(const ZoneSet& zones)
+{
+	// Ԫϵĸд룬ȡʱֱӻָΪƽ̹
+	writeArray(zones.types);
+	writeArray(zones.groups);
+	writeArray(zones.vertices);
+	writeArray(zones.boundMins);
+	writeArray(zones.boundMaxs);
+	writeArray(zones.planes);
+	writeArray(zones.origins);
+	writeArray(zones.invertedBases);
+	writeArray(zones.edges);
+	writeArray(zones.edgeOffsets);
+	writeArray(zones.edgeIds);
+}
+
+bool ModelCache::readZones(ZoneSet& zones)
+{
+	return readArray(zones.types) &&
+		readArray(zones.groups) &&
+		readArray(zones.vertices) &&
+		readArray(zones.boundMins) &&
+		readArray(zones.boundMaxs) &&
+		readArray(zones.planes) &&
+		readArray(zones.origins) &&
+		readArray(zones.invertedBases) &&
+		readArray(zones.edges) &&
+		readArray(zones.edgeOffsets) &&
+		readArray(zones.edgeIds) &&
+		zones.isValid();
+}
+
+bool ModelCache::skipZones(qint64* count)
+{
+	return skipArray(count) && skipArray() && skipArray() && skipArray() &&
+		skipArray() && skipArray() && skipArray() && skipArray() &&
+		skipArray() && skipArray() && skipArray();
+}
+
+void ModelCache::writeBVH(const LinearBVH& tree)
+{
+	// ɵԪƵд뻺
+	writeArray(tree.nodes);
+	writeArray(tree.primitives);
+}
+
+bool ModelCache::readBVH(LinearBVH& tree, int primitiveNum)
+{
+	tree.groupMasks.clear();
+	return readArray(tree.nodes) &&
+		readArray(tree.primitives) &&
+		tree.primitives.count() == primitiveNum &&
+		tree.isValid(primitiveNum);
+}
+
+bool ModelCache::skipBVH()
+{
+	return skipArray() && skipArray();
+}
+
+void ModelCache::packZoneGroups(const QVector<ZoneGroup>& zoneGroups, QVector<CachedZoneGroup>& cachedGroups, QVector<char>& names)
+{
+	// UTF-8ţм¼ƫƼ
+	cachedGroups.resize(zoneGroups.count());
+	names.clear();
+	for (int i = 0; i < zoneGroups.count(); ++i)
+	{
+		const ZoneGroup& zoneGroup = zoneGroups[i];
+		QByteArray name = zoneGroup.name.toUtf8();
+		CachedZoneGroup& cachedGroup = cachedGroups[i];
+		cachedGroup.nameOffset = names.count();
+		cachedGroup.nameLength = name.size();
+		cachedGroup.zoneIndexBegin = zoneGroup.zoneIndexBegin;
+		cachedGroup.zoneIndexNum = zoneGroup.zoneIndexNum;
+		cachedGroup.wireframeIndexBegin = zoneGroup.wireframeIndexBegin;
+		cachedGroup.wireframeIndexNum = zoneGroup.wireframeIndexNum;
+		for (char c : name)
+		{
+			names.append(c);
+		}
+	}
+}
+
+bool ModelCache::unpackZoneGroups(const QVector<CachedZoneGroup>& cachedGroups, const QVector<char>& names, QVector<ZoneGroup>& zoneGroups)
+{
+	zoneGroups.resize(cachedGroups.count());
+	for (int i = 0; i < cachedGroups.count(); ++i)
+	{
+		const CachedZoneGroup& cachedGroup = cachedGroups[i];
+		if (cachedGroup.nameOffset < 0 || cachedGroup.nameLength < 0 || cachedGroup.nameOffset + cachedGroup.nameLength > names.count())
+		{
+			return false;
+		}
+
+		ZoneGroup& zoneGroup = zoneGroups[i];
+		zoneGroup.name = QString::fromUtf8(names.constData() + cachedGroup.nameOffset, cachedGroup.nameLength);
+		zoneGroup.zoneIndexBegin = cachedGroup.zoneIndexBegin;
+		zoneGroup.zoneIndexNum = cachedGroup.zoneIndexNum;
+		zoneGroup.wireframeIndexBegin = cachedGroup.wireframeIndexBegin;
+		zoneGroup.wireframeIndexNum = cachedGroup.wireframeIndexNum;
+	}
+	return true;
+}
+
+void ModelCache::write(const void* src, qint64 length)
+{
+	saveFile->write(reinterpret_cast<const char*>(src), length);
+	written += length;
+}
+
+void ModelCache::align()
+{
+	// 鰴8ֽڶ룬ӳֱӷ
+	static const char padding[8] = {};
+	qint64 remainder = written % 8;
+	if (remainder)
+	{
+		write(padding, 8 - remainder);
+	}
+}
+
+bool ModelCache::read(void* dst, qint64 length)
+{
+	if (length > size - offset)
+	{
+		return false;
+	}
+
+	memcpy(dst, data + offset, length);
+	offset += length;
+	return true;
+}
+
+void ModelCache::skipAlign()
+{
+	offset = qMin((offset + 7) / 8 * 8, size);
+}
+
+bool ModelCache::readSource(const QString& fileName, bool withHash, ModelCacheSource& source)
+{
+	QFileInfo fileInfo(fileName);
+	if (!fileInfo.exists())
+	{
+		return false;
+	}
+
+	source.size = fileInfo.size();
+	source.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+	return !withHash || hashFile(fileName, source.hash);
+}
+
+bool ModelCache::hashFile(const QString& fileName, char hash[16])
+{
+	QFile sourceFile(fileName);
+	if (!sourceFile.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	QCryptographicHash cryptographicHash(QCryptographicHash::Md5);
+	qint64 sourceSize = sourceFile.size();
+	if (sourceSize > 0)
+	{
+		uchar* sourceData = sourceFile.map(0, sourceSize);
+		if (!sourceData)
+		{
+			return false;
+		}
+
+		const qint64 kBlockSize = 1 << 30;
+		for (qint64 i = 0; i < sourceSize; i += kBlockSize)
+		{
+			cryptographicHash.addData(reinterpret_cast<const char*>(sourceData) + i, (int)qMin(kBlockSize, sourceSize - i));
+		}
+		sourceFile.unmap(sourceData);
+	}
+	sourceFile.close();
+
+	QByteArray result = cryptographicHash.result();
+	memset(hash, 0, 16);
+	memcpy(hash, result.constData(), qMin(result.size(), 16));
+	return true;
+}
+
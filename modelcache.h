@@ -0,0 +1,134 @@
+#pragma once
+
+#include "geotypes.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+#include <type_traits>
+
+/**
+	Ԥģͻࣨ.nmvcacheļȡʱڴӳļθƵQVectorֱӳڴ棩
+*/
+
+const quint32 kModelCacheMagic = 0x43564D4E;
+const quint32 kModelCacheVersion = 10;
+
+struct ModelCacheSource
+{
+	qint64 size = 0;
+	qint64 lastModified = 0;
+	char hash[16] = {};
+};
+
+struct CachedZoneGroup
+{
+	qint32 nameOffset;
+	qint32 nameLength;
+	qint32 zoneIndexBegin;
+	qint32 zoneIndexNum;
+	qint32 wireframeIndexBegin;
+	qint32 wireframeIndexNum;
+};
+
+class ModelCache
+{
+public:
+	ModelCache();
+	~ModelCache();
+
+	static QString cacheFileName(const QString& fileName);
+	static QStringList sourceFileNames(const QString& fileName);
+
+	// д뻺
+	bool create(const QString& cacheFileName, const QStringList& sourceFileNames);
+	bool commit();
+	qint64 tell() const;
+
+	template <typename T>
+	void writeValue(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cache value must be trivially copyable");
+		write(&value, sizeof(T));
+	}
+
+	template <typename T>
+	void writeArray(const QVector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cache element must be trivially copyable");
+		quint32 elementSize = sizeof(T);
+		quint32 reserved = 0;
+		qint64 count = values.count();
+		write(&elementSize, sizeof(elementSize));
+		write(&reserved, sizeof(reserved));
+		write(&count, sizeof(count));
+		write(values.constData(), count * sizeof(T));
+		align();
+	}
+
+	// ȡ棨ƶȡӳֻʡȥεļȡãرպͷţ
+	bool open(const QString& cacheFileName, const QStringList& sourceFileNames);
+	void close();
+	qint64 fileSize() const;
+	bool seek(qint64 pos);
+	bool skipArray(qint64* count = nullptr);
+
+	template <typename T>
+	bool readValue(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cache value must be trivially copyable");
+		return read(&value, sizeof(T));
+	}
+
+	template <typename T>
+	bool readArray(QVector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cache element must be trivially copyable");
+		quint32 elementSize;
+		quint32 reserved;
+		qint64 count;
+		if (!read(&elementSize, sizeof(elementSize)) || !read(&reserved, sizeof(reserved)) || !read(&count, sizeof(count)))
+		{
+			return false;
+		}
+		if (elementSize != sizeof(T) || count < 0 || count * (qint64)sizeof(T) > size - offset)
+		{
+			return false;
+		}
+
+		// ÿmemcpyһΣQVector޷ⲿڴ
+		values.resize(count);
+		read(values.data(), count * sizeof(T));
+		skipAlign();
+		return true;
+	}
+
+	// ԪϰдʱɷصԪ
+	void writeZones(const ZoneSet& zones);
+	bool readZones(ZoneSet& zones);
+	bool skipZones(qint64* count = nullptr);
+
+	// bvhĽڵ㼰ͼԪֱӶдȡʱڵüͼԪ
+	void writeBVH(const LinearBVH& tree);
+	bool readBVH(LinearBVH& tree, int primitiveNum);
+	bool skipBVH();
+
+	// Ԫ뻺ʽ໥ת
+	static void packZoneGroups(const QVector<ZoneGroup>& zoneGroups, QVector<CachedZoneGroup>& cachedGroups, QVector<char>& names);
+	static bool unpackZoneGroups(const QVector<CachedZoneGroup>& cachedGroups, const QVector<char>& names, QVector<ZoneGroup>& zoneGroups);
+
+private:
+	void write(const void* src, qint64 length);
+	void align();
+	bool read(void* dst, qint64 length);
+	void skipAlign();
+
+	static bool readSource(const QString& fileName, bool withHash, ModelCacheSource& source);
+	static bool hashFile(const QString& fileName, char hash[16]);
+
+	QSaveFile* saveFile;
+	qint64 written;
+	QFile file;
+	const char* data;
+	qint64 size;
+	qint64 offset;
+};
@@ -0,0 +1,743 @@
+#include "modelloader.h"
+#include "f3gridparser.h"
+#include "modelcache.h"
+#include "edbreader.h"
+#include "resultfieldstore.h"
+#include "brickedmodel.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent>
+
+// ModelLoaderԱʵ
+ModelLoader::ModelLoader(QObject* parent) : QObject(parent)
+{
+	resultFields = nullptr;
+	brickedModel = nullptr;
+	valueRange.reset();
+	lastProgress = -1;
+	outOfCoreZoneNum = kOutOfCoreZoneNum;
+}
+
+ModelLoader::~ModelLoader()
+{
+	SAFE_DELETE(resultFields);
+	SAFE_DELETE(brickedModel);
+}
+
+bool ModelLoader::load(const QString& fileName)
+{
+	// ȶȡԤ棬ʧЧʱ½Ԥ
+	setProgress(ParseStage, 0, 1);
+	if (loadCache(fileName))
+	{
+		openResultFields(fileName);
+		buildBrickedModel(fileName);
+		setProgress(VoxelizeStage, 1, 1);
+		return true;
+	}
+
+	bool loaded = false;
+	QFileInfo fileInfo(fileName);
+	QString suffix = fileInfo.suffix();
+	if (suffix == "edb")
+	{
+		loaded = loadDatabase(fileName);
+	}
+	else if (suffix == "f3grid")
+	{
+		loaded = loadDataFiles(fileName);
+	}
+
+	// ļȱʧʱԿʾ񣬵д뻺
+	if (isCanceled() || mesh.faces.isEmpty() || !preprocess())
+	{
+		return false;
+	}
+
+	if (loaded)
+	{
+		saveCache(fileName);
+	}
+	openResultFields(fileName);
+	if (loaded)
+	{
+		buildBrickedModel(fileName);
+	}
+	return true;
+}
+
+void ModelLoader::cancel()
+{
+	canceled.store(1);
+}
+
+bool ModelLoader::isCanceled() const
+{
+	return canceled.load() != 0;
+}
+
+QString ModelLoader::getErrorMessage() const
+{
+	return errorMessage;
+}
+
+void ModelLoader::setOutOfCoreZoneNum(int zoneNum)
+{
+	outOfCoreZoneNum = zoneNum;
+}
+
+void ModelLoader::setBVHBuildOptions(const BVHBuildOptions& options)
+{
+	bvhBuildOptions = options;
+}
+
+QString ModelLoader::getStageName(int stage)
+{
+	switch (stage)
+	{
+	case ParseStage:
+		return QStringLiteral("");
+	case CleanStage:
+		return QStringLiteral("ϴ");
+	case BVHStage:
+		return QStringLiteral("BVH");
+	case VoxelizeStage:
+		return QStringLiteral("ػ");
+	default:
+		return QString();
+	}
+}
+
+bool ModelLoader::loadDatabase(const QString& fileName)
+{
+	// ݱڹ߳ʹöӲжȡ
+	EDBModel model;
+	if (!EDBReader::load(fileName, model))
+	{
+		errorMessage = QObject::tr("Unable to read model database.\n"
+			"This example needs SQLite support. Please read "
+			"the Qt SQL driver documentation for information how "
+			"to build it.");
+		return false;
+	}
+
+	setProgress(ParseStage, 1, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	qSwap(nodeAttributes, model.nodeAttributes);
+	valueRange = model.valueRange;
+	zoneTypes.swap(model.zoneTypes);
+
+	// 񶥵ڵ깲ͬһ
+	mesh.vertices = nodeAttributes.positions;
+	for (const QVector3D& position : nodeAttributes.positions)
+	{
+		uniformGrids.bound.min = qMinVec3(uniformGrids.bound.min, position);
+		uniformGrids.bound.max = qMaxVec3(uniformGrids.bound.max, position);
+	}
+
+	setProgress(ParseStage, 2, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	zones.reserve(model.zones.count());
+	zoneIndices.reserve(model.zones.count() * 36);
+	for (const Zone& zone : model.zones)
+	{
+		addZone(zone);
+	}
+	zones.cacheValues(nodeAttributes.values());
+	buildZoneGroups(QStringList());
+
+	setProgress(ParseStage, 3, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	exteriorFacets.reserve(model.facets.count());
+	for (Facet& facet : model.facets)
+	{
+		addFacet(facet);
+	}
+
+	setProgress(ParseStage, 4, 4);
+	return true;
+}
+
+bool ModelLoader::loadDataFiles(const QString& fileName)
+{
+	// ģ
+	QString modelFileName = fileName;
+	QFileInfo fileInfo(modelFileName);
+	QVector<Zone> fileZones;
+	QVector<Facet> fileFacets;
+	QStringList groupNames;
+	if (!F3GridParser::load(modelFileName, nodeAttributes.positions, fileZones, fileFacets, groupNames))
+	{
+		return false;
+	}
+
+	setProgress(ParseStage, 1, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	nodeAttributes.resize(nodeAttributes.positions.count());
+	for (QVector3D& position : nodeAttributes.positions)
+	{
+		position *= 8.0f;
+	}
+	mesh.vertices = nodeAttributes.positions;
+
+	zones.reserve(fileZones.count());
+	zoneIndices.reserve(fileZones.count() * 36);
+	for (const Zone& zone : fileZones)
+	{
+		addZone(zone);
+	}
+	buildZoneGroups(groupNames);
+
+	exteriorFacets.reserve(fileFacets.count());
+	for (Facet& facet : fileFacets)
+	{
+		facet.facetID = exteriorFacets.count();
+		addFacet(facet);
+	}
+
+	setProgress(ParseStage, 2, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	// XYZλ
+	QString gridPointFileName = modelFileName.replace(fileInfo.fileName(), "gridpoint_result.txt");
+	QFile gridFile(gridPointFileName);
+	if (gridFile.open(QIODevice::ReadOnly))
+	{
+		QVector<float>& deformationX = nodeAttributes.field(FieldUX);
+		QVector<float>& deformationY = nodeAttributes.field(FieldUY);
+		QVector<float>& deformationZ = nodeAttributes.field(FieldUZ);
+		QVector<float>& totalDeformation = nodeAttributes.field(FieldUSUM);
+		QTextStream in(&gridFile);
+		in.readLine();
+		while (!in.atEnd())
+		{
+			int index;
+			in >> index;
+			index -= 1;
+
+			// ΪZλƣͬʱΪʾֶ
+			in >> deformationX[index] >>
+				deformationY[index] >>
+				deformationZ[index];
+			totalDeformation[index] = deformationZ[index];
+
+			valueRange.minTotalDeformation = qMin(valueRange.minTotalDeformation, totalDeformation[index]);
+			valueRange.maxTotalDeformation = qMax(valueRange.maxTotalDeformation, totalDeformation[index]);
+			in.readLine();
+		}
+
+		gridFile.close();
+	}
+	else
+	{
+		return false;
+	}
+
+	setProgress(ParseStage, 3, 4);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	// Ӧݣzone_result.txtڼʱȡResultFieldStore״ʹʱȡ
+
+	// Ԫֵڵֵ
+	zones.cacheValues(nodeAttributes.values());
+
+	setProgress(ParseStage, 4, 4);
+	return true;
+}
+
+void ModelLoader::addFacet(Facet& facet)
+{
+	QSet<uint32_t> indexSet;
+	for (int i = 0; i < facet.num; ++i)
+	{
+		indexSet.insert(facet.indices[i]);
+	}
+
+	if (indexSet.count() == 2)
+	{
+		return;
+	}
+
+	if (indexSet.count() < facet.num && indexSet.count() == 3)
+	{
+		facet.num = 3;
+	}
+	exteriorFacets.append(facet);
+
+	QVector<uint32_t> indices;
+	if (facet.num == 3)
+	{
+		indices.append({ facet.indices[0], facet.indices[1], facet.indices[2] });
+	}
+	else if (facet.num == 4)
+	{
+		indices.append({
+			facet.indices[0], facet.indices[1], facet.indices[2],
+			facet.indices[0], facet.indices[2], facet.indices[3]
+			});
+	}
+
+	facetIndices.append(indices);
+	for (int i = 0; i < indices.count(); i += 3)
+	{
+		uint32_t v0 = indices[i];
+		uint32_t v1 = indices[i + 1];
+		uint32_t v2 = indices[i + 2];
+
+		GeoUtil::addFace(mesh, v0, v1, v2);
+	}
+}
+
+void ModelLoader::addZone(const Zone& zone)
+{
+	if (!zone.isValid() || !zones.append(zone, nodeAttributes.positions))
+	{
+		qDebug() << "Invalid zone!";
+		return;
+	}
+
+	// õɵԪ͵˱ɣıʷƬһ£߿ڷʱΨһɣ
+	int zoneIndex = zones.count() - 1;
+	const ZoneTopology& topology = ZoneSet::topology(zone.type);
+	const quint32* vertices = zones.zoneVertices(zoneIndex);
+	for (int i = 0; i < topology.facetNum; ++i)
+	{
+		const int* facet = topology.facets[i];
+		int last = topology.facetSizes[i] - 1;
+		zoneIndices.append({ vertices[facet[0]], vertices[facet[1]], vertices[facet[last]] });
+		if (topology.facetSizes[i] == 4)
+		{
+			zoneIndices.append({ vertices[facet[1]], vertices[facet[2]], vertices[facet[3]] });
+		}
+	}
+
+	zoneIndexEnds.append(zoneIndices.count());
+}
+
+void ModelLoader::buildZoneGroups(const QStringList& groupNames)
+{
+	// ûзϢʱеԪͬһ
+	zoneGroups.clear();
+	zones.buildEdges();
+	QStringList names = groupNames;
+	if (names.isEmpty())
+	{
+		names.append(QStringLiteral("Default"));
+		zones.groups.fill(0);
+	}
+
+	// ŵԪÿӦеһ䣬Ԫ˳򲻱
+	QVector<QVector<int>> groupZones(names.count());
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		groupZones[qBound(0, zones.groups[i], names.count() - 1)].append(i);
+	}
+
+	// ߿ֻΨһߣڵԪıֻһΣ߽ϵı߸ֱ
+	QVector<uint32_t> groupedZoneIndices;
+	QVector<int> edgeGroups(zones.edges.count(), -1);
+	groupedZoneIndices.reserve(zoneIndices.count());
+	wireframeIndices.clear();
+	wireframeIndices.reserve(zones.edges.count() * 2);
+	for (int g = 0; g < names.count(); ++g)
+	{
+		ZoneGroup zoneGroup;
+		zoneGroup.name = names[g];
+		zoneGroup.zoneIndexBegin = groupedZoneIndices.count();
+		zoneGroup.wireframeIndexBegin = wireframeIndices.count();
+		for (int i : groupZones[g])
+		{
+			int zoneBegin = i > 0 ? zoneIndexEnds[i - 1] : 0;
+			groupedZoneIndices.append(zoneIndices.mid(zoneBegin, zoneIndexEnds[i] - zoneBegin));
+			for (int j = zones.edgeOffsets[i]; j < zones.edgeOffsets[i + 1]; ++j)
+			{
+				quint32 edgeId = zones.edgeIds[j];
+				if (edgeGroups[edgeId] != g)
+				{
+					const Edge& edge = zones.edges[edgeId];
+					edgeGroups[edgeId] = g;
+					wireframeIndices.append({ edge.vertices[0], edge.vertices[1] });
+				}
+			}
+		}
+		zoneGroup.zoneIndexNum = groupedZoneIndices.count() - zoneGroup.zoneIndexBegin;
+		zoneGroup.wireframeIndexNum = wireframeIndices.count() - zoneGroup.wireframeIndexBegin;
+		zoneGroups.append(zoneGroup);
+	}
+	zoneIndices.swap(groupedZoneIndices);
+
+	zoneIndexEnds.clear();
+	qDebug() << "zone groups:" << zoneGroups.count() << "edges:" << zones.edges.count();
+}
+
+bool ModelLoader::loadCache(const QString& fileName)
+{
+	profileTimer.start();
+
+	ModelCache cache;
+	if (!cache.open(ModelCache::cacheFileName(fileName), ModelCache::sourceFileNames(fileName)))
+	{
+		return false;
+	}
+
+	// Чķֿļʱ뵥ԪԪbvh
+	bool outOfCore = openBrickedModel(fileName);
+
+	QVector<uchar> pointMask;
+	QVector<CachedZoneGroup> cachedGroups;
+	QVector<char> groupNames;
+	bool result = cache.readArray(nodeAttributes.positions) &&
+		cache.readArray(nodeAttributes.fields[FieldUSUM]) &&
+		cache.readArray(nodeAttributes.fields[FieldUX]) &&
+		cache.readArray(nodeAttributes.fields[FieldUY]) &&
+		cache.readArray(nodeAttributes.fields[FieldUZ]) &&
+		nodeAttributes.hasField(FieldUSUM) && nodeAttributes.hasField(FieldUX) && nodeAttributes.hasField(FieldUY) && nodeAttributes.hasField(FieldUZ) &&
+		cache.readArray(exteriorFacets) &&
+		cache.readArray(mesh.faces) &&
+		(outOfCore ? cache.skipZones() : cache.readZones(zones)) &&
+		cache.readValue(valueRange) &&
+		cache.readArray(zoneTypes) &&
+		cache.readArray(zoneIndices) &&
+		cache.readArray(wireframeIndices) &&
+		cache.readArray(facetIndices) &&
+		cache.readArray(cachedGroups) &&
+		cache.readArray(groupNames) &&
+		(outOfCore ? cache.skipBVH() : cache.readBVH(zoneBVH, zones.count())) &&
+		cache.readValue(uniformGrids.dim) &&
+		cache.readValue(uniformGrids.bound) &&
+		cache.readArray(pointMask) &&
+		cache.readArray(uniformGrids.voxelData) &&
+		pointMask.count() == uniformGrids.voxelData.count();
+	cache.close();
+
+	result = result && ModelCache::unpackZoneGroups(cachedGroups, groupNames, zoneGroups);
+	if (result && !outOfCore)
+	{
+		GeoUtil::updateBVHGroupMask(zones, zoneBVH);
+	}
+	if (!result)
+	{
+		qDebug() << "Invalid model cache: " << ModelCache::cacheFileName(fileName);
+		clear();
+		return false;
+	}
+
+	// ؽɻƵ񶥵㡢߱ڽӱֵ
+	mesh.vertices = nodeAttributes.positions;
+	for (int i = 0; i < mesh.faces.count(); ++i)
+	{
+		for (const Edge& edge : mesh.faces[i].edges)
+		{
+			mesh.edges[edge].append(i);
+		}
+	}
+	GeoUtil::buildFaceAdjacency(mesh);
+	zones.cacheValues(nodeAttributes.values());
+	faceValueTree = GeoUtil::buildIntervalTree(mesh, nodeAttributes.values());
+
+	// ɱλָλģڲĵ㣬ؿ
+	int index = 0;
+	for (int x = 0; x < uniformGrids.dim[0]; ++x)
+	{
+		for (int y = 0; y < uniformGrids.dim[1]; ++y)
+		{
+			for (int z = 0; z < uniformGrids.dim[2]; ++z, ++index)
+			{
+				if (pointMask[index])
+				{
+					uniformGrids.points.append({ uniformGrids.position(x, y, z), uniformGrids.voxelData[index] });
+				}
+			}
+		}
+	}
+	GeoUtil::updateVoxelBlockTree(uniformGrids);
+
+	qint64 loadCacheTime = profileTimer.restart();
+	qDebug() << "load model cache time:" << loadCacheTime;
+	return true;
+}
+
+bool ModelLoader::saveCache(const QString& fileName)
+{
+	profileTimer.start();
+
+	ModelCache cache;
+	if (!cache.create(ModelCache::cacheFileName(fileName), ModelCache::sourceFileNames(fileName)))
+	{
+		return false;
+	}
+
+	QVector<CachedZoneGroup> cachedGroups;
+	QVector<char> groupNames;
+	ModelCache::packZoneGroups(zoneGroups, cachedGroups, groupNames);
+
+	// ڲֻ¼λλ¼
+	QVector<uchar> pointMask(uniformGrids.voxelData.count(), 0);
+	int pointIndex = 0;
+	int index = 0;
+	for (int x = 0; x < uniformGrids.dim[0]; ++x)
+	{
+		for (int y = 0; y < uniformGrids.dim[1]; ++y)
+		{
+			for (int z = 0; z < uniformGrids.dim[2]; ++z, ++index)
+			{
+				if (pointIndex < uniformGrids.points.count() && uniformGrids.points[pointIndex].position == uniformGrids.position(x, y, z))
+				{
+					pointMask[index] = 1;
+					pointIndex++;
+				}
+			}
+		}
+	}
+
+	cache.writeArray(nodeAttributes.positions);
+	cache.writeArray(nodeAttributes.fields[FieldUSUM]);
+	cache.writeArray(nodeAttributes.fields[FieldUX]);
+	cache.writeArray(nodeAttributes.fields[FieldUY]);
+	cache.writeArray(nodeAttributes.fields[FieldUZ]);
+	cache.writeArray(exteriorFacets);
+	cache.writeArray(mesh.faces);
+	cache.writeZones(zones);
+	cache.writeValue(valueRange);
+	cache.writeArray(zoneTypes);
+	cache.writeArray(zoneIndices);
+	cache.writeArray(wireframeIndices);
+	cache.writeArray(facetIndices);
+	cache.writeArray(cachedGroups);
+	cache.writeArray(groupNames);
+	cache.writeBVH(zoneBVH);
+	cache.writeValue(uniformGrids.dim);
+	cache.writeValue(uniformGrids.bound);
+	cache.writeArray(pointMask);
+	cache.writeArray(uniformGrids.voxelData);
+	bool result = cache.commit();
+
+	qint64 saveCacheTime = profileTimer.restart();
+	qDebug() << "save model cache time:" << saveCacheTime;
+	return result;
+}
+
+void ModelLoader::openResultFields(const QString& fileName)
+{
+	// λĽֶΰȡ
+	resultFields = new ResultFieldStore(nodeAttributes.count());
+	if (QFileInfo(fileName).suffix() == "edb")
+	{
+		resultFields->openDatabase(fileName);
+	}
+	else if (brickedModel)
+	{
+		// ԪڴУԪڵӷֿļȡ
+		QVector<int> zoneNodeOffsets;
+		QVector<uint32_t> zoneNodes;
+		brickedModel->readZoneNodes(zoneNodeOffsets, zoneNodes);
+		resultFields->openDataFiles(fileName, zoneNodeOffsets, zoneNodes);
+	}
+	else
+	{
+		resultFields->openDataFiles(fileName, zones);
+	}
+}
+
+bool ModelLoader::openBrickedModel(const QString& fileName)
+{
+	if (!QFileInfo::exists(BrickedModel::brickFileName(fileName)))
+	{
+		return false;
+	}
+
+	// ֵߺʹеķֿļ
+	brickedModel = new BrickedModel;
+	if (!brickedModel->open(fileName) || brickedModel->getZoneNum() < outOfCoreZoneNum)
+	{
+		SAFE_DELETE(brickedModel);
+		return false;
+	}
+	return true;
+}
+
+bool ModelLoader::buildBrickedModel(const QString& fileName)
+{
+	if (zones.count() < outOfCoreZoneNum)
+	{
+		return false;
+	}
+
+	profileTimer.start();
+	if (!BrickedModel::build(fileName, zones) || !openBrickedModel(fileName))
+	{
+		return false;
+	}
+
+	// ԪԪbvhɷֿģͰ룬ٳפڴ
+	zones = ZoneSet();
+	zoneBVH = LinearBVH();
+	qint64 buildBricksTime = profileTimer.restart();
+	qDebug() << "out of core zones time:" << buildBricksTime;
+	return true;
+}
+
+bool ModelLoader::preprocess()
+{
+	profileTimer.start();
+	setProgress(CleanStage, 0, 1);
+
+	// ϴ
+	GeoUtil::cleanMesh(mesh);
+
+	// ޸˳
+	GeoUtil::fixWindingOrder(mesh);
+
+	// ֤ģ͵ĺϷ
+	bool result = GeoUtil::validateMesh(mesh);
+	Q_ASSERT_X(result, "preprocess", "mesh is not valid!");
+
+	// ֻϷ
+	facetIndices.resize(mesh.faces.count() * 3);
+	for (int i = 0; i < mesh.faces.count(); ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			facetIndices[i * 3 + j] = mesh.faces[i].vertices[j];
+		}
+	}
+	qint64 cleanTime = profileTimer.restart();
+	qDebug() << "clean mesh time:" << cleanTime;
+	setProgress(CleanStage, 1, 1);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	// Ԫbvhֵһ̹߳뵥ԪͬʱУ
+	setProgress(BVHStage, 0, 2);
+	QFuture<IntervalTree> faceValueTreeFuture = QtConcurrent::run([this]() {
+		return GeoUtil::buildIntervalTree(mesh, nodeAttributes.values());
+	});
+	zoneBVH = GeoUtil::buildBVHTree(zones, bvhBuildOptions);
+	GeoUtil::updateBVHGroupMask(zones, zoneBVH);
+	qint64 buildZoneBVHTreeTime = profileTimer.elapsed();
+	setProgress(BVHStage, 1, 2);
+	faceValueTree = faceValueTreeFuture.result();
+	qint64 buildBVHTreeTime = profileTimer.restart();
+
+	BVHStats zoneBVHStats = GeoUtil::getBVHStats(zoneBVH, bvhBuildOptions);
+	qDebug() << "build bvh tree time:" << buildBVHTreeTime << "zone tree time:" << buildZoneBVHTreeTime
+		<< "zone tree sah cost:" << zoneBVHStats.sahCost << "depth:" << zoneBVHStats.depth << "leaf size:" << zoneBVHStats.averageLeafSize << "/" << zoneBVHStats.maxLeafSize
+		<< "face value tree nodes:" << faceValueTree.nodes.count();
+	setProgress(BVHStage, 2, 2);
+	if (isCanceled())
+	{
+		return false;
+	}
+
+	// ֵ
+	if (!interpUniformGrids())
+	{
+		return false;
+	}
+	qint64 interpTime = profileTimer.restart();
+	qDebug() << "interpolate uniform grids time:" << interpTime;
+	return true;
+}
+
+bool ModelLoader::interpUniformGrids()
+{
+	Bound bound = zoneBVH.bound().toBound();
+	QVector3D size = bound.size();
+	float maxDimVal = qMaxDimVal(size);
+	int maxDim = 100;
+	std::array<int, 3> dim;
+	for (int i = 0; i < 3; ++i)
+	{
+		dim[i] = size[i] / maxDimVal * maxDim;
+	}
+	uniformGrids.dim = dim;
+	uniformGrids.bound = bound;
+
+	float value;
+	for (int x = 0; x < dim[0]; ++x)
+	{
+		// xƬ㱨ȲӦȡ
+		setProgress(VoxelizeStage, x, dim[0]);
+		if (isCanceled())
+		{
+			return false;
+		}
+
+		for (int y = 0; y < dim[1]; ++y)
+		{
+			for (int z = 0; z < dim[2]; ++z)
+			{
+				QVector3D position = uniformGrids.position(x, y, z);
+
+				if (GeoUtil::interpZones(zones, zoneBVH, position, value))
+				{
+					uniformGrids.points.append({ position, value });
+				}
+
+				uniformGrids.voxelData.append(value);
+			}
+		}
+	}
+	GeoUtil::updateVoxelBlockTree(uniformGrids);
+
+	setProgress(VoxelizeStage, dim[0], dim[0]);
+	return true;
+}
+
+void ModelLoader::clear()
+{
+	nodeAttributes.clear();
+	exteriorFacets.clear();
+	mesh.clear();
+	zones.clear();
+	valueRange.reset();
+	zoneTypes.clear();
+	zoneBVH.clear();
+	faceValueTree.clear();
+	uniformGrids.clear();
+	wireframeIndices.clear();
+	zoneIndices.clear();
+	facetIndices.clear();
+	zoneGroups.clear();
+	SAFE_DELETE(resultFields);
+	SAFE_DELETE(brickedModel);
+	zoneIndexEnds.clear();
+}
+
+void ModelLoader::setProgress(LoadStage stage, qint64 done, qint64 total)
+{
+	// Ȱٷֱȱ仯ʱŷźţ߳źŹ
+	int progress = total > 0 ? (int)(done * 100 / total) : 100;
+	int key = stage * 1000 + progress;
+	if (key != lastProgress)
+	{
+		lastProgress = key;
+		emit onStageProgress(stage, progress);
+	}
+}
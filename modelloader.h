@@ -0,0 +1,85 @@
+#ifndef MODELLOADER_H
+#define MODELLOADER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+#include "geoutil.h"
+
+// ԪֵʱԪΪֿ
+const int kOutOfCoreZoneNum = 2000000;
+
+enum LoadStage
+{
+	ParseStage, CleanStage, BVHStage, VoxelizeStage, LoadStageNum
+};
+
+/**
+	ģͼࣨڹ߳ɽԤ漰GLԴ
+*/
+
+class ModelLoader : public QObject
+{
+	Q_OBJECT
+public:
+	ModelLoader(QObject* parent = nullptr);
+	~ModelLoader();
+
+	bool load(const QString& fileName);
+	void cancel();
+	bool isCanceled() const;
+	QString getErrorMessage() const;
+	void setOutOfCoreZoneNum(int zoneNum);
+	void setBVHBuildOptions(const BVHBuildOptions& options);
+
+	static QString getStageName(int stage);
+
+	NodeAttributes nodeAttributes;
+	QVector<Facet> exteriorFacets;
+	Mesh mesh;
+	ZoneSet zones;
+	ValueRange valueRange;
+	QVector<int> zoneTypes;
+	LinearBVH zoneBVH;
+	IntervalTree faceValueTree;
+	UniformGrids uniformGrids;
+	QVector<uint32_t> wireframeIndices;
+	QVector<uint32_t> zoneIndices;
+	QVector<uint32_t> facetIndices;
+	QVector<ZoneGroup> zoneGroups;
+	class ResultFieldStore* resultFields;
+	class BrickedModel* brickedModel;
+
+signals:
+	void onStageProgress(int stage, int progress);
+
+private:
+	bool loadDatabase(const QString& fileName);
+	bool loadDataFiles(const QString& fileName);
+	void addFacet(Facet& facet);
+	void addZone(const Zone& zone);
+	void buildZoneGroups(const QStringList& groupNames);
+
+	bool loadCache(const QString& fileName);
+	bool saveCache(const QString& fileName);
+
+	void openResultFields(const QString& fileName);
+	bool openBrickedModel(const QString& fileName);
+	bool buildBrickedModel(const QString& fileName);
+	bool preprocess();
+	bool interpUniformGrids();
+
+	void clear();
+	void setProgress(LoadStage stage, qint64 done, qint64 total);
+
+	QAtomicInt canceled;
+	QString errorMessage;
+	QVector<int> zoneIndexEnds;
+	int lastProgress;
+	int outOfCoreZoneNum;
+	BVHBuildOptions bvhBuildOptions;
+	QElapsedTimer profileTimer;
+};
+
+#endif // MODELLOADER_H
@@ -1,5 +1,12 @@
 #include "openglwindow.h"
 #include "camera.h"
+#include "modelloader.h"
+#include "edbwriter.h"
+#include "meshwriter.h"
+#include "resultseries.h"
+#include "resultfieldstore.h"
+#include "brickedmodel.h"
+#include "modelcache.h"
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
@@ -7,9 +14,9 @@
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QMessageBox>
+#include <QtConcurrent>
 #include <fstream>
 #include <QRandomGenerator>
-#include <dualmc/dualmc.h>
 
 OpenGLWindow::OpenGLWindow(QWidget* parent) : QOpenGLWidget(parent)
 {
@@ -21,8 +28,24 @@ OpenGLWindow::OpenGLWindow(QWidget* parent) : QOpenGLWidget(parent)
 	camera->setClipping(0.1f, 10000.0f);
 	camera->setFovy(45.0f);
 
-	zoneBVHRoot = nullptr;
-	faceBVHRoot = nullptr;
+	visibleGroupMask = kAllZoneGroups;
+
+	modelLoader = nullptr;
+	connect(&loadWatcher, SIGNAL(finished()), this, SLOT(onModelLoaded()));
+	edbWriter = nullptr;
+	connect(&exportWatcher, SIGNAL(finished()), this, SLOT(onModelExported()));
+	resultSeries = nullptr;
+	resultFields = nullptr;
+	brickedModel = nullptr;
+	timeStep = -1;
+	showDeformation = false;
+	deformationScale = 1.0f;
+	uniformGridsOutdated = false;
+	connect(&playTimer, SIGNAL(timeout()), this, SLOT(playNextTimeStep()));
+	connect(&resultWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(onResultFileChanged(const QString&)));
+	reloadTimer.setSingleShot(true);
+	reloadTimer.setInterval(kResultReloadDelay);
+	connect(&reloadTimer, SIGNAL(timeout()), this, SLOT(reloadResults()));
 
 	displayMode = ClipZone;
 	pickMode = PickZone;
@@ -34,6 +57,14 @@ OpenGLWindow::OpenGLWindow(QWidget* parent) : QOpenGLWidget(parent)
 
 OpenGLWindow::~OpenGLWindow()
 {
+	cancelLoad();
+	loadWatcher.waitForFinished();
+	SAFE_DELETE(modelLoader);
+	cancelExport();
+	exportWatcher.waitForFinished();
+	SAFE_DELETE(edbWriter);
+	closeResultSeries();
+
 	makeCurrent();
 
 	delete camera;
@@ -49,6 +80,10 @@ OpenGLWindow::~OpenGLWindow()
 void OpenGLWindow::setDisplayMode(DisplayMode inDisplayMode)
 {
 	displayMode = inDisplayMode;
+	if (displayMode == Isosurface && uniformGridsOutdated)
+	{
+		genIsosurface(isosurfaceValue);
+	}
 }
 
 void OpenGLWindow::setPickMode(PickMode inPickMode)
@@ -92,27 +127,256 @@ void OpenGLWindow::setShowIsolineWireframe(bool flag)
 
 QVector2D OpenGLWindow::getIsoValueRange()
 {
-	return QVector2D(valueRange.minTotalDeformation, valueRange.maxTotalDeformation);
+	return valueRange.getFieldRange(nodeAttributes.displayField);
+}
+
+QStringList OpenGLWindow::getZoneGroupNames() const
+{
+	QStringList names;
+	for (const ZoneGroup& zoneGroup : zoneGroups)
+	{
+		names.append(zoneGroup.name);
+	}
+	return names;
+}
+
+void OpenGLWindow::setZoneGroupVisible(int group, bool flag)
+{
+	if (group < 0 || group >= zoneGroups.count() || zoneGroupVisible[group] == flag)
+	{
+		return;
+	}
+
+	// ʾ/ֻı䣬мʰȡ
+	zoneGroupVisible[group] = flag;
+	updateZoneGroupRanges();
+	pickIndices.clear();
+	clipZones(clipPlane);
+	update();
+}
+
+bool OpenGLWindow::isZoneGroupVisible(int group) const
+{
+	return group >= 0 && group < zoneGroupVisible.count() && zoneGroupVisible[group];
+}
+
+bool OpenGLWindow::canShowDeformation() const
+{
+	// ԪֿʱԪֿ黺棬ֱ֧ʾ
+	return !zones.isEmpty() && !brickedModel && nodeAttributes.hasDeformation();
+}
+
+bool OpenGLWindow::setShowDeformation(bool flag)
+{
+	if (flag && !canShowDeformation())
+	{
+		return false;
+	}
+	if (showDeformation == flag)
+	{
+		return true;
+	}
+
+	showDeformation = flag;
+	updateDeformedShape();
+	return true;
+}
+
+bool OpenGLWindow::isShowingDeformation() const
+{
+	return showDeformation;
+}
+
+void OpenGLWindow::setDeformationScale(float scale)
+{
+	if (deformationScale == scale)
+	{
+		return;
+	}
+
+	deformationScale = scale;
+	if (showDeformation)
+	{
+		updateDeformedShape();
+	}
+}
+
+float OpenGLWindow::getDefaultDeformationScale() const
+{
+	if (!canShowDeformation())
+	{
+		return 1.0f;
+	}
+
+	float maxDeformation = 0.0f;
+	for (int field = FieldUX; field <= FieldUZ; ++field)
+	{
+		for (float value : nodeAttributes.fields[field])
+		{
+			maxDeformation = qMax(maxDeformation, qAbs(value));
+		}
+	}
+	float diagonal = (zoneBVH.bound().max - zoneBVH.bound().min).length();
+	return maxDeformation > 0.0f ? diagonal * kDefaultDeformationRatio / maxDeformation : 1.0f;
+}
+
+bool OpenGLWindow::hasResultField(int field) const
+{
+	// λֶγפڵݣֶʽ洢ṩ
+	if (field >= 0 && field <= FieldUZ)
+	{
+		return nodeAttributes.hasField(field);
+	}
+	return resultFields && resultFields->hasField(field);
+}
+
+bool OpenGLWindow::loadResultField(int field)
+{
+	if (field < 0 || field >= ResultFieldTypeNum)
+	{
+		return false;
+	}
+
+	// λֶγפڵݲʱ䲽£λƷǰֵͳƷΧλƷΧ֡
+	if (field <= FieldUZ)
+	{
+		if (field != FieldUSUM && nodeAttributes.hasField(field))
+		{
+			float minValue = kMaxVal;
+			float maxValue = kMinVal;
+			for (float value : nodeAttributes.fields[field])
+			{
+				minValue = qMin(minValue, value);
+				maxValue = qMax(maxValue, value);
+			}
+			valueRange.setFieldRange(field, minValue, maxValue);
+		}
+		return nodeAttributes.hasField(field);
+	}
+
+	// ֶ״ʹʱʽ洢ȡڵݣֵΧʽ洢ȡʱͳƣ̭Ա
+	QVector<float> values;
+	float minValue;
+	float maxValue;
+	if (!resultFields || !resultFields->field(field, values) || values.count() != nodeAttributes.count() ||
+		!resultFields->getFieldRange(field, minValue, maxValue))
+	{
+		return false;
+	}
+
+	nodeAttributes.fields[field] = values;
+	valueRange.setFieldRange(field, minValue, maxValue);
+	if (!loadedResultFields.contains(field))
+	{
+		loadedResultFields.append(field);
+	}
+	return true;
+}
+
+bool OpenGLWindow::setDisplayField(int field)
+{
+	if (!hasZones() || modelLoader)
+	{
+		return false;
+	}
+	if (field == nodeAttributes.displayField)
+	{
+		return true;
+	}
+	if (!loadResultField(field))
+	{
+		return false;
+	}
+
+	// лʾֶκԪڵֵءGPUеֵ桢ֵ桢ֵȫ
+	nodeAttributes.displayField = field;
+	updateResultValues(0, nodeAttributes.count());
+	update();
+	return true;
+}
+
+int OpenGLWindow::getDisplayField() const
+{
+	return nodeAttributes.displayField;
 }
 
 void OpenGLWindow::openFile(const QString& fileName)
 {
+	if (modelLoader)
+	{
+		return;
+	}
+
 	emit onModelStartLoad();
-	cleanResources();
 
-	QFileInfo fileInfo(fileName);
-	QString suffix = fileInfo.suffix();
-	if (suffix == "edb")
+	// Ԥڹ߳нУڼʾǰģ
+	loadingFileName = fileName;
+	modelLoader = new ModelLoader;
+	connect(modelLoader, SIGNAL(onStageProgress(int, int)), this, SIGNAL(onModelLoadProgress(int, int)));
+	ModelLoader* loader = modelLoader;
+	loadWatcher.setFuture(QtConcurrent::run([loader, fileName]() {
+		return loader->load(fileName);
+	}));
+	//printDatabase(fileName);
+}
+
+void OpenGLWindow::cancelLoad()
+{
+	if (modelLoader)
 	{
-		loadDatabase(fileName);
-		//printDatabase(fileName);
+		modelLoader->cancel();
 	}
-	else if (suffix == "f3grid")
+}
+
+bool OpenGLWindow::isLoading() const
+{
+	return modelLoader != nullptr;
+}
+
+void OpenGLWindow::onModelLoaded()
+{
+	if (!modelLoader)
 	{
-		loadDataFiles(fileName);
+		return;
 	}
 
-	preprocess();
+	if (!loadWatcher.result())
+	{
+		QString errorMessage = modelLoader->getErrorMessage();
+		SAFE_DELETE(modelLoader);
+		if (!errorMessage.isEmpty())
+		{
+			QMessageBox::critical(this, QObject::tr("Cannot open model"), errorMessage, QMessageBox::Cancel);
+		}
+		emit onModelCancelLoad();
+		return;
+	}
+
+	// GUI߳滻ģݣϴGPU
+	closeResultSeries();
+	cleanResources();
+	qSwap(nodeAttributes, modelLoader->nodeAttributes);
+	qSwap(exteriorFacets, modelLoader->exteriorFacets);
+	qSwap(mesh, modelLoader->mesh);
+	qSwap(zones, modelLoader->zones);
+	qSwap(valueRange, modelLoader->valueRange);
+	qSwap(zoneTypes, modelLoader->zoneTypes);
+	qSwap(zoneBVH, modelLoader->zoneBVH);
+	qSwap(faceValueTree, modelLoader->faceValueTree);
+	qSwap(uniformGrids, modelLoader->uniformGrids);
+	qSwap(wireframeIndices, modelLoader->wireframeIndices);
+	qSwap(zoneIndices, modelLoader->zoneIndices);
+	qSwap(facetIndices, modelLoader->facetIndices);
+	qSwap(zoneGroups, modelLoader->zoneGroups);
+	qSwap(resultFields, modelLoader->resultFields);
+	qSwap(brickedModel, modelLoader->brickedModel);
+	SAFE_DELETE(modelLoader);
+
+	zoneGroupVisible.fill(true, zoneGroups.count());
+	updateZoneGroupRanges();
+	modelFileName = loadingFileName;
+	watchResultFiles();
+
 	initResources();
 
 	// ʼ
@@ -131,222 +395,449 @@ void OpenGLWindow::openFile(const QString& fileName)
 
 bool OpenGLWindow::exportToEDB(const QString& exportPath)
 {
-	if (zones.empty())
+	// Ԫֿʱֵ֧
+	if (zones.isEmpty() || edbWriter)
 	{
 		return false;
 	}
 
-	QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-	db.setDatabaseName(exportPath);
+	emit onModelStartExport();
 
-	if (!db.open())
+	// ʽĸΪգڼGUI߳޸ʱз
+	edbWriter = new EDBWriter;
+	connect(edbWriter, SIGNAL(onTableProgress(int, int)), this, SIGNAL(onModelExportProgress(int, int)));
+	EDBWriter* writer = edbWriter;
+	NodeAttributes nodeAttributesSnapshot = nodeAttributes;
+	ZoneSet zonesSnapshot = zones;
+	QVector<Facet> exteriorFacetsSnapshot = exteriorFacets;
+	ResultFieldStore* fields = resultFields;
+	exportWatcher.setFuture(QtConcurrent::run([writer, exportPath, nodeAttributesSnapshot, zonesSnapshot, exteriorFacetsSnapshot, fields]() {
+		return writer->save(exportPath, nodeAttributesSnapshot, zonesSnapshot, exteriorFacetsSnapshot, fields);
+	}));
+	return true;
+}
+
+bool OpenGLWindow::exportToVTU(const QString& exportPath)
+{
+	// Ԫֿʱֵ֧
+	if (zones.isEmpty() || edbWriter)
 	{
-		QMessageBox::critical(nullptr, QObject::tr("Cannot open database"),
-			QObject::tr("Unable to establish a database connection.\n"
-				"This example needs SQLite support. Please read "
-				"the Qt SQL driver documentation for information how "
-				"to build it.\n\n"
-				"Click Cancel to exit."), QMessageBox::Cancel);
 		return false;
 	}
 
-	QSqlQuery query;
-	db.transaction();
-
-	// ڵռ
-	query.exec("create table NODES(ID INTEGER primary key, X REAL, Y REAL, Z REAL)");
-	for (int i = 0; i < nodeVertices.size(); ++i)
-	{
-		const NodeVertex& nodeVertice = nodeVertices[i];
-		query.exec(QString("INSERT INTO NODES VALUES(%1, %2, %3, %4)").
-			arg(i + 1).
-			arg(nodeVertice.position[0]).
-			arg(nodeVertice.position[1]).
-			arg(nodeVertice.position[2]));
-	}
-
-	// ÿڵӦļֵ
-	query.exec("create table RESULTS(NODEID INTEGER primary key, \
-		USUM REAL, UX REAL, UY REAL, UZ REAL, \
-		EPTOX REAL, EPTOY REAL, EPTOZ REAL, \
-		EPTOXY REAL, EPTOYZ REAL, EPTOXZ REAL, \
-		S1 REAL, S2 REAL, S3 REAL, \
-		SX REAL, SY REAL, SZ REAL, \
-		SXY REAL, SYZ REAL, SXZ REAL)");
-	for (int i = 0; i < nodeVertices.size(); ++i)
-	{
-		const NodeVertex& nodeVertice = nodeVertices[i];
-		query.exec(QString("INSERT INTO RESULTS VALUES(%1, %2, %3, %4, %5, %6, %7,\
-			%8, %9, %10, %11, %12, %13, %14, %15, %16, %17, %18, %19, %20)").
-			arg(i + 1).
-			arg(nodeVertice.totalDeformation).
-			arg(nodeVertice.deformation[0]).
-			arg(nodeVertice.deformation[1]).
-			arg(nodeVertice.deformation[2]).
-			arg(nodeVertice.normalElasticStrain[0]).
-			arg(nodeVertice.normalElasticStrain[1]).
-			arg(nodeVertice.normalElasticStrain[2]).
-			arg(nodeVertice.shearElasticStrain[0]).
-			arg(nodeVertice.shearElasticStrain[1]).
-			arg(nodeVertice.shearElasticStrain[2]).
-			arg(nodeVertice.maximumPrincipalStress).
-			arg(nodeVertice.middlePrincipalStress).
-			arg(nodeVertice.minimumPrincipalStress).
-			arg(nodeVertice.normalStress[0]).
-			arg(nodeVertice.normalStress[1]).
-			arg(nodeVertice.normalStress[2]).
-			arg(nodeVertice.shearStress[0]).
-			arg(nodeVertice.shearStress[1]).
-			arg(nodeVertice.shearStress[2]));
-	}
-
-	// ԪϢ
-	query.exec("create table ELETYPE(ID INTEGER primary key, TYPE INTEGER, TYPENAME TEXT)");
-	query.exec(QString("INSERT INTO ELETYPE VALUES(1, 0, \"185\")"));
-	query.exec(QString("INSERT INTO ELETYPE VALUES(2, 4, \"154\")"));
-
-	// Ԫڵ
-	QString elementsTableCreateSql("create table ELEMENTS(ID INTEGER primary key, TYPE INTEGER, NUM INTEGER");
-	for (int i = 0; i < 50; ++i)
-	{
-		elementsTableCreateSql += QString(", N%1 INTEGER").arg(i + 1);
-	}
-	elementsTableCreateSql += ")";
-
-	query.exec(elementsTableCreateSql);
-	for (int i = 0; i < zones.size(); ++i)
-	{
-		const Zone& zone = zones[i];
-		QString elementsTableInsertSql(QString("INSERT INTO ELEMENTS VALUES(%1, %2, %3").
-			arg(i + 1).
-			arg(zone.type).
-			arg(zone.vertexNum));
-		static const int reorders[8] = { 0, 1, 4, 2, 3, 6, 7, 5 };
-		for (int j = 0; j < 50; ++j)
+	bool saved = MeshWriter::saveVTU(exportPath, nodeAttributes, zones, resultFields);
+	showExportResult(saved);
+	return saved;
+}
+
+bool OpenGLWindow::exportToPLY(const QString& exportPath)
+{
+	if (!hasZones())
+	{
+		return false;
+	}
+
+	// 桢ֵ漰ֵ߷ֱд<ļ>_section.ply<ļ>_isosurface.ply<ļ>_isoline.ply
+	QFileInfo fileInfo(exportPath);
+	QString basePath = fileInfo.absolutePath() + "/" + fileInfo.completeBaseName();
+	int field = nodeAttributes.displayField;
+	bool saved = MeshWriter::savePLY(basePath + "_section.ply", sectionVertices, sectionIndices, 3, field) &&
+		MeshWriter::savePLY(basePath + "_isosurface.ply", isosurfaceVertices, isosurfaceIndices, 3, field) &&
+		MeshWriter::savePLY(basePath + "_isoline.ply", isolineVertices, QVector<uint32_t>(), 2, field);
+	showExportResult(saved);
+	return saved;
+}
+
+void OpenGLWindow::cancelExport()
+{
+	if (edbWriter)
+	{
+		edbWriter->cancel();
+	}
+}
+
+bool OpenGLWindow::isExporting() const
+{
+	return edbWriter != nullptr;
+}
+
+void OpenGLWindow::onModelExported()
+{
+	if (!edbWriter)
+	{
+		return;
+	}
+
+	bool canceled = edbWriter->isCanceled();
+	SAFE_DELETE(edbWriter);
+	emit onModelFinishExport();
+
+	if (canceled)
+	{
+		return;
+	}
+
+	showExportResult(exportWatcher.result());
+}
+
+void OpenGLWindow::showExportResult(bool succeeded)
+{
+	if (succeeded)
+	{
+		QMessageBox::information(this, QStringLiteral("ʾ"),
+			QStringLiteral("ɹ"),
+			QMessageBox::Ok);
+	}
+	else
+	{
+		QMessageBox::critical(this, QStringLiteral("ʾ"),
+			QStringLiteral("ʧܣ"),
+			QMessageBox::Ok);
+	}
+}
+
+bool OpenGLWindow::openResultSeries(const QString& dirPath)
+{
+	if (!hasZones())
+	{
+		return false;
+	}
+
+	closeResultSeries();
+	resultSeries = new ResultSeries(nodeAttributes.count());
+	if (!resultSeries->open(dirPath))
+	{
+		closeResultSeries();
+		return false;
+	}
+
+	// ڵԪֻ뼸أʱһ
+	sampleUniformGrids();
+
+	resultSeries->prefetch(0, kPrefetchFrameNum);
+	setTimeStep(0);
+	return timeStep == 0;
+}
+
+void OpenGLWindow::closeResultSeries()
+{
+	playTimer.stop();
+	SAFE_DELETE(resultSeries);
+	timeStep = -1;
+}
+
+int OpenGLWindow::getTimeStepCount() const
+{
+	return resultSeries ? resultSeries->count() : 0;
+}
+
+int OpenGLWindow::getTimeStepNumber(int index) const
+{
+	return resultSeries ? resultSeries->stepNumber(index) : 0;
+}
+
+void OpenGLWindow::setTimeStep(int index)
+{
+	if (!resultSeries || !hasZones() || index == timeStep)
+	{
+		return;
+	}
+
+	profileTimer.start();
+	ResultFrame resultFrame;
+	if (!resultSeries->frame(index, resultFrame))
+	{
+		qDebug() << "Cannot load result frame:" << resultSeries->fileName(index);
+		return;
+	}
+	timeStep = index;
+
+	// ȷʱ䲽Ԥȡ뱾֡ĸ²
+	resultSeries->prefetch(index + 1, kPrefetchFrameNum);
+	qint64 loadTime = profileTimer.restart();
+
+	// ֻ½ֵ񡢵ԪBVHṹֲ䣬Ԥ
+	resultFrame.apply(nodeAttributes);
+	valueRange.minTotalDeformation = resultFrame.minValue;
+	valueRange.maxTotalDeformation = resultFrame.maxValue;
+	updateResultValues(0, nodeAttributes.count());
+
+	qDebug() << "time step:" << resultSeries->stepNumber(index) << "load time:" << loadTime;
+	emit onTimeStepChanged(index);
+}
+
+void OpenGLWindow::updateResultValues(int nodeBegin, int nodeEnd)
+{
+	// ¼ֵݣʾλƷΧκĵԪΡԪڵֵֵؼؿ
+	profileTimer.start();
+	if (nodeAttributes.displayField != FieldUSUM && nodeAttributes.displayField <= FieldUZ)
+	{
+		loadResultField(nodeAttributes.displayField);
+	}
+	if (showDeformation)
+	{
+		updateDeformedGeometry();
+	}
+	zones.cacheValues(nodeAttributes.values());
+	faceValueTree = GeoUtil::buildIntervalTree(mesh, nodeAttributes.values());
+	if (uniformGridsOutdated || uniformGrids.sampleZones.count() != uniformGrids.voxelData.count())
+	{
+		sampleUniformGrids();
+	}
+	if (brickedModel)
+	{
+		brickedModel->invalidateValues();
+		brickedModel->resampleUniformGrids(nodeAttributes, uniformGrids);
+	}
+	else
+	{
+		GeoUtil::resampleUniformGrids(zones, uniformGrids);
+	}
+	qint64 updateTime = profileTimer.restart();
+
+	// ԭظGPU㻺漰ֵΧڵ㻺ֻϴֵб仯䣬鲻
+	makeCurrent();
+	if (nodeBegin < nodeEnd)
+	{
+		nodeVBO.bind();
+		nodeVBO.write(nodeAttributes.count() * sizeof(QVector3D) + nodeBegin * sizeof(float), nodeAttributes.values().constData() + nodeBegin, (nodeEnd - nodeBegin) * sizeof(float));
+	}
+	uploadUniformGridPoints();
+
+	pointShaderProgram->bind();
+	QVector2D displayRange = getIsoValueRange();
+	pointShaderProgram->setUniformValue("valueRange.minValue", displayRange[0]);
+	pointShaderProgram->setUniformValue("valueRange.maxValue", displayRange[1]);
+	shadedShaderProgram->bind();
+	setShadedValueRangeUniforms();
+	qint64 uploadTime = profileTimer.restart();
+
+	// ɽ桢ֵ漰ֵ
+	clipZones(clipPlane);
+	genIsosurface(isosurfaceValue);
+	genIsolines(isolineValue);
+	qint64 regenTime = profileTimer.restart();
+
+	qDebug() << "update result values time:" << updateTime << "upload time:" << uploadTime
+		<< "upload nodes:" << qMax(0, nodeEnd - nodeBegin) << "regenerate time:" << regenTime;
+}
+
+const QVector<QVector3D>& OpenGLWindow::displayPositions() const
+{
+	return showDeformation ? deformedPositions : nodeAttributes.positions;
+}
+
+void OpenGLWindow::updateDeformedGeometry()
+{
+	// ǰλƼŴϵƶڵ㣬иµԪΣԪbvhֽṹֻԵ¼Χ
+	QElapsedTimer timer;
+	timer.start();
+	if (showDeformation)
+	{
+		nodeAttributes.deform(deformationScale, deformedPositions);
+	}
+	else
+	{
+		deformedPositions.clear();
+	}
+	const QVector<QVector3D>& positions = displayPositions();
+	GeoUtil::updateZoneGeometry(zones, positions);
+	qint64 geometryTime = timer.restart();
+	GeoUtil::refitBVHTree(zones, zoneBVH);
+	qint64 refitTime = timer.restart();
+
+	// ڵԪ״仯ʾֵʱ²
+	uniformGrids.bound = zoneBVH.bound().toBound();
+	uniformGridsOutdated = true;
+
+	makeCurrent();
+	nodeVBO.bind();
+	nodeVBO.write(0, positions.constData(), positions.count() * sizeof(QVector3D));
+	qint64 uploadTime = timer.restart();
+	qDebug() << "update deformed geometry time:" << geometryTime << "refit zone bvh tree time:" << refitTime << "upload time:" << uploadTime;
+}
+
+void OpenGLWindow::updateDeformedShape()
+{
+	updateDeformedGeometry();
+
+	// ʰȡԭ״㣬״仯
+	pickIndices.clear();
+	clipZones(clipPlane);
+	genIsolines(isolineValue);
+	if (displayMode == Isosurface)
+	{
+		genIsosurface(isosurfaceValue);
+	}
+	update();
+}
+
+void OpenGLWindow::watchResultFiles()
+{
+	// ֻӽļģļ仯ʱ´
+	if (!resultWatcher.files().isEmpty())
+	{
+		resultWatcher.removePaths(resultWatcher.files());
+	}
+	changedResultFiles.clear();
+	loadedResultFields.clear();
+	reloadTimer.stop();
+
+	resultFileNames = ModelCache::sourceFileNames(modelFileName);
+	resultFileNames.removeAll(modelFileName);
+	for (const QString& resultFileName : resultFileNames)
+	{
+		if (QFileInfo::exists(resultFileName))
 		{
-			int index = 0;
-			if (j < zone.vertexNum)
-			{
-				index = zone.vertices[zone.type == Brick ? reorders[j] : j];
-				index++;
-			}
-			elementsTableInsertSql += QString(", %1").arg(index);
+			resultWatcher.addPath(resultFileName);
+		}
+	}
+}
+
+void OpenGLWindow::onResultFileChanged(const QString& path)
+{
+	// ֶд룬һα仯ӳ¶ȡ
+	if (!changedResultFiles.contains(path))
+	{
+		changedResultFiles.append(path);
+	}
+	reloadTimer.start();
+}
+
+void OpenGLWindow::reloadResults()
+{
+	if (!hasZones() || changedResultFiles.isEmpty() || modelLoader)
+	{
+		return;
+	}
+
+	// 滻ʽļӼбƳ¼
+	QStringList changedFiles;
+	changedFiles.swap(changedResultFiles);
+	for (const QString& resultFileName : resultFileNames)
+	{
+		if (!resultWatcher.files().contains(resultFileName) && QFileInfo::exists(resultFileName))
+		{
+			resultWatcher.addPath(resultFileName);
 		}
-		elementsTableInsertSql += ")";
+	}
+
+	// ѶȡĽֶʧЧʾֶ¶ȡ
+	profileTimer.start();
+	if (resultFields)
+	{
+		resultFields->invalidate();
+	}
+	QVector<int> fields;
+	fields.swap(loadedResultFields);
+	for (int field : fields)
+	{
+		loadResultField(field);
+	}
 
-		query.exec(elementsTableInsertSql);
+	// ʱ䲽ʱλļӰ죻ֻʾֶ¶ȡʱʾ
+	QString gridPointFileName = resultFileNames.value(0);
+	if (!changedFiles.contains(gridPointFileName) || resultSeries)
+	{
+		if (fields.contains(nodeAttributes.displayField))
+		{
+			updateResultValues(0, nodeAttributes.count());
+		}
+		qDebug() << "reload result fields time:" << profileTimer.elapsed() << "fields:" << fields.count();
+		emit onResultsReloaded();
+		return;
 	}
 
-	// ģӦĽڵϢ
-	QString exteriorTableCreateSql("create table EXTERIOR(ID INT primary key, ELEMID INT, FACETID INT, NUM INT");
-	for (int i = 0; i < 50; ++i)
+	ResultFrame resultFrame;
+	if (!ResultSeries::loadFrame(gridPointFileName, nodeAttributes.count(), resultFrame))
 	{
-		exteriorTableCreateSql += QString(", N%1 INT").arg(i + 1);
+		qDebug() << "Cannot reload results:" << gridPointFileName;
+		return;
 	}
-	exteriorTableCreateSql += ")";
 
-	query.exec(exteriorTableCreateSql);
-	for (int i = 0; i < exteriorFacets.size(); ++i)
+	// ¼ֵ仯Ľڵ
+	int nodeBegin = nodeAttributes.count();
+	int nodeEnd = 0;
+	const QVector<float>& deformationX = nodeAttributes.fields[FieldUX];
+	const QVector<float>& deformationY = nodeAttributes.fields[FieldUY];
+	const QVector<float>& deformationZ = nodeAttributes.fields[FieldUZ];
+	const QVector<float>& totalDeformation = nodeAttributes.fields[FieldUSUM];
+	const float* value = resultFrame.values.constData();
+	for (int i = 0; i < nodeAttributes.count(); ++i, value += kResultFieldNum)
 	{
-		const Facet& facet = exteriorFacets[i];
-		QString exteriorTableInsertSql(QString("INSERT INTO EXTERIOR VALUES(%1, %2, %3, %4").
-			arg(i + 1).
-			arg(facet.elemID + 1).
-			arg(facet.facetID + 1).
-			arg(facet.num));
-		for (int j = 0; j < 50; ++j)
+		if (deformationX[i] != value[0] || deformationY[i] != value[1] || deformationZ[i] != value[2] || totalDeformation[i] != value[2])
 		{
-			exteriorTableInsertSql += QString(", %1").arg(j < facet.num ? facet.indices[j] + 1 : 0);
+			nodeBegin = qMin(nodeBegin, i);
+			nodeEnd = i + 1;
 		}
-		exteriorTableInsertSql += ")";
+	}
+	resultFrame.apply(nodeAttributes);
+	valueRange.minTotalDeformation = resultFrame.minValue;
+	valueRange.maxTotalDeformation = resultFrame.maxValue;
+	qint64 loadTime = profileTimer.elapsed();
+	qDebug() << "reload results load time:" << loadTime << "fields:" << fields.count();
+
+	updateResultValues(nodeBegin, nodeEnd);
+	emit onResultsReloaded();
+}
 
-		query.exec(exteriorTableInsertSql);
+void OpenGLWindow::sampleUniformGrids()
+{
+	profileTimer.start();
+	if (brickedModel)
+	{
+		brickedModel->sampleUniformGrids(nodeAttributes, uniformGrids);
+	}
+	else
+	{
+		GeoUtil::sampleUniformGrids(zones, zoneBVH, uniformGrids);
+	}
+	uniformGridsOutdated = false;
+	qint64 sampleTime = profileTimer.restart();
+	qDebug() << "sample uniform grids time:" << sampleTime;
+}
+
+void OpenGLWindow::uploadUniformGridPoints()
+{
+	// ²ڲܱ仯ʱ·㻺
+	pointVBO.bind();
+	int pointSize = uniformGrids.points.count() * sizeof(NodeVertex);
+	if (pointVBO.size() != pointSize)
+	{
+		pointVBO.allocate(uniformGrids.points.constData(), pointSize);
 	}
-
-	// ԪϢÿͨ
-	QString facetsTableCreateSql("create table FACETS(ID INTEGER primary key, ELEMID INTEGER, NUM INTEGER");
-	for (int i = 0; i < 50; ++i)
+	else
 	{
-		facetsTableCreateSql += QString(", N%1 INTEGER").arg(i + 1);
+		pointVBO.write(0, uniformGrids.points.constData(), pointSize);
 	}
-	facetsTableCreateSql += ")";
+}
 
-	query.exec(facetsTableCreateSql);
-	int facetID = 0;
-	for (const Zone& zone : zones)
+void OpenGLWindow::setPlaying(bool flag)
+{
+	if (flag && resultSeries)
 	{
-		for (const Facet& facet : zone.facets)
-		{
-			QString facetsTableInsertSql(QString("INSERT INTO FACETS VALUES(%1, %2, %3").
-				arg(++facetID).
-				arg(facet.elemID + 1).
-				arg(facet.num));
-			for (int i = 0; i < 50; ++i)
-			{
-				facetsTableInsertSql += QString(", %1").arg(i < facet.num ? facet.indices[i] + 1 : 0);
-			}
-			facetsTableInsertSql += ")";
-
-			query.exec(facetsTableInsertSql);
-		}
+		playTimer.start(kPlayInterval);
 	}
-
-	// ģбӦĽڵϢ
-	QString elemEdgesTableCreateSql("create table FACETS(ID INTEGER primary key, ELEMID INTEGER, EDGENUM INTEGER");
-	for (int i = 0; i < 20; ++i)
+	else
 	{
-		elemEdgesTableCreateSql += QString(", startIdx%1 INTEGER, endIdx1%1 INTEGER").arg(i + 1);
+		playTimer.stop();
 	}
-	elemEdgesTableCreateSql += ")";
+}
 
-	query.exec(elemEdgesTableCreateSql);
-	for (int i = 0; i < zones.size(); ++i)
+bool OpenGLWindow::isPlaying() const
+{
+	return playTimer.isActive();
+}
+
+void OpenGLWindow::playNextTimeStep()
+{
+	if (!resultSeries)
 	{
-		const Zone& zone = zones[i];
-		QString elemEdgesTableInsertSql(QString("INSERT INTO FACETS VALUES(%1, %2, %3").
-			arg(i + 1).
-			arg(i + 1).
-			arg(zone.edgeNum));
-		for (int j = 0; j < 20; ++j)
-		{
-			int startIndex = j < zone.edgeNum ? zone.edges[j * 2] + 1 : 0;
-			int endIndex = j < zone.edgeNum ? zone.edges[j * 2 + 1] + 1 : 0;
-			elemEdgesTableInsertSql += QString(", %1, %2").arg(startIndex, endIndex);
-		}
-		elemEdgesTableInsertSql += ")";
-
-		query.exec(elemEdgesTableInsertSql);
-	}
-
-	// ͡Ʊ
-	query.exec("create table RSTTYPE(ID INTEGER primary key, Code TEXT, Name TEXT, Type TEXT, Unit TEXT)");
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(1, \"USUM\", \"%1\", \"Total Deformation\", \"m\")").arg(QStringLiteral("HDY_λ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(2, \"UX\", \"%1\", \"Directional Deformation(X Axis)\", \"m\")").arg(QStringLiteral("HDY_Xλ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(3, \"UY\", \"%1\", \"Directional Deformation(Y Axis)\", \"m\")").arg(QStringLiteral("HDY_Yλ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(4, \"UZ\", \"%1\", \"Directional Deformation(Z Axis)\", \"m\")").arg(QStringLiteral("HDY_Zλ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(5, \"EPTOX\", \"%1\", \"Normal Elastic Strain(X Axis)\", \"m/m\")").arg(QStringLiteral("HDY_XӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(6, \"EPTOY\", \"%1\", \"Normal Elastic Strain(Y Axis)\", \"m/m\")").arg(QStringLiteral("HDY_YӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(7, \"EPTOZ\", \"%1\", \"Normal Elastic Strain(Z Axis)\", \"m/m\")").arg(QStringLiteral("HDY_ZӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(8, \"EPTOXY\", \"%1\", \"Shear Elastic Strain(XY Plane)\", \"m/m\")").arg(QStringLiteral("HDY_XYƽӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(9, \"EPTOYZ\", \"%1\", \"Shear Elastic Strain(YZ Plane)\", \"m/m\")").arg(QStringLiteral("HDY_YZƽӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(10, \"EPTOXZ\", \"%1\", \"Shear Elastic Strain(XZ Plane)\", \"m/m\")").arg(QStringLiteral("HDY_XZƽӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(11, \"S1\", \"%1\", \"Maximum Principal Stress\", \"Pa\")").arg(QStringLiteral("HDY_Ӧ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(12, \"S2\", \"%1\", \"Middle Principal Stress\", \"Pa\")").arg(QStringLiteral("HDY_мӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(13, \"S3\", \"%1\", \"Minimum Principal Stress\", \"Pa\")").arg(QStringLiteral("HDY_СӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(14, \"SX\", \"%1\", \"Normal Stress(X Axis)\", \"Pa\")").arg(QStringLiteral("HDY_XӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(15, \"SY\", \"%1\", \"Normal Stress(Y Axis)\", \"Pa\")").arg(QStringLiteral("HDY_YӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(16, \"SZ\", \"%1\", \"Normal Stress(Z Axis)\", \"Pa\")").arg(QStringLiteral("HDY_ZӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(17, \"SXY\", \"%1\", \"Shear Stress(XY Plane)\", \"Pa\")").arg(QStringLiteral("HDY_XYƽӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(18, \"SYZ\", \"%1\", \"Shear Stress(YZ Plane)\", \"Pa\")").arg(QStringLiteral("HDY_YZƽӦ")));
-	query.exec(QString("INSERT INTO RSTTYPE VALUES(19, \"SXZ\", \"%1\", \"Shear Stress(XZ Plane)\", \"Pa\")").arg(QStringLiteral("HDY_XZƽӦ")));
-
-	db.commit();
-	db.close();
+		playTimer.stop();
+		return;
+	}
 
-	QMessageBox::information(this, QStringLiteral("ʾ"),
-		QStringLiteral("ɹ"),
-		QMessageBox::Ok);
-	return true;
+	setTimeStep((timeStep + 1) % resultSeries->count());
 }
 
 void OpenGLWindow::initializeGL()
@@ -443,7 +934,7 @@ void OpenGLWindow::paintGL()
 	glClearColor(0.7, 0.7, 0.7, 1.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	if (zones.empty())
+	if (!hasZones())
 	{
 		return;
 	}
@@ -470,7 +961,7 @@ void OpenGLWindow::paintGL()
 		wireframeVAO.bind();
 		wireframeShaderProgram->bind();
 		wireframeShaderProgram->setUniformValue("skipClip", disableClip);
-		glDrawElements(GL_LINES, wireframeIndices.count(), GL_UNSIGNED_INT, nullptr);
+		drawIndexRanges(GL_LINES, wireframeDrawRanges);
 
 		if (!disableClip)
 		{
@@ -487,7 +978,7 @@ void OpenGLWindow::paintGL()
 
 		zoneVAO.bind();
 		shadedShaderProgram->setUniformValue("skipClip", disableClip);
-		glDrawElements(GL_TRIANGLES, zoneIndices.count(), GL_UNSIGNED_INT, nullptr);
+		drawIndexRanges(GL_TRIANGLES, zoneDrawRanges);
 
 		if (!disableClip)
 		{
@@ -505,7 +996,7 @@ void OpenGLWindow::paintGL()
 
 			wireframeVAO.bind();
 			wireframeShaderProgram->setUniformValue("skipClip", true);
-			glDrawElements(GL_LINES, wireframeIndices.count(), GL_UNSIGNED_INT, nullptr);
+			drawIndexRanges(GL_LINES, wireframeDrawRanges);
 		}
 
 		pointShaderProgram->bind();
@@ -522,7 +1013,7 @@ void OpenGLWindow::paintGL()
 
 			wireframeVAO.bind();
 			wireframeShaderProgram->setUniformValue("skipClip", true);
-			glDrawElements(GL_LINES, wireframeIndices.count(), GL_UNSIGNED_INT, nullptr);
+			drawIndexRanges(GL_LINES, wireframeDrawRanges);
 		}
 
 		pointShaderProgram->bind();
@@ -545,13 +1036,20 @@ void OpenGLWindow::mousePressEvent(QMouseEvent* event)
 {
 	camera->onMousePressed(event->button(), event->x(), event->y());
 
-	if (event->button() == Qt::LeftButton && displayMode == ClipZone && pickMode != PickNone && !zones.empty())
+	if (event->button() == Qt::LeftButton && displayMode == ClipZone && pickMode != PickNone && hasZones())
 	{
 		QVector3D start = QVector3D(event->x(), height() - event->y() - 1, 0.0f).unproject(camera->getViewMatrix(), camera->getPerspectiveMatrix(), rect());
 		QVector3D end = QVector3D(event->x(), height() - event->y() - 1, 1.0f).unproject(camera->getViewMatrix(), camera->getPerspectiveMatrix(), rect());
 
 		Ray pickRay(start, end - start);
-		GeoUtil::pickZone(zones, pickRay, zoneBVHRoot, nodeVertices, pickIndices, pickMode == PickZone);
+		if (brickedModel)
+		{
+			brickedModel->pickZone(pickRay, nodeAttributes, pickIndices, pickMode == PickZone, visibleGroupMask);
+		}
+		else
+		{
+			GeoUtil::pickZone(zones, pickRay, zoneBVH, displayPositions(), pickIndices, pickMode == PickZone, visibleGroupMask);
+		}
 
 		makeCurrent();
 		//pickVertices = { NodeVertex{start}, NodeVertex{end} };
@@ -591,207 +1089,6 @@ void OpenGLWindow::keyReleaseEvent(QKeyEvent* event)
 	camera->onKeyReleased(event->key());
 }
 
-bool OpenGLWindow::loadDatabase(const QString& fileName)
-{
-	QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
-	db.setDatabaseName(fileName);
-	if (!db.open())
-	{
-		QMessageBox::critical(nullptr, QObject::tr("Cannot open database"),
-			QObject::tr("Unable to establish a database connection.\n"
-				"This example needs SQLite support. Please read "
-				"the Qt SQL driver documentation for information how "
-				"to build it.\n\n"
-				"Click Cancel to exit."), QMessageBox::Cancel);
-		return false;
-	}
-
-	// ѯڵռ
-	QSqlQuery query("SELECT * FROM NODES");
-	QSqlRecord record = query.record();
-	while (query.next())
-	{
-		NodeVertex nodeVertex;
-		for (int i = 0; i < 3; ++i)
-		{
-			nodeVertex.position[i] = query.value(i + 1).toFloat();
-		}
-
-		uniformGrids.bound.min = qMinVec3(uniformGrids.bound.min, nodeVertex.position);
-		uniformGrids.bound.max = qMaxVec3(uniformGrids.bound.max, nodeVertex.position);
-		mesh.vertices.append(nodeVertex.position);
-
-		nodeVertices.append(nodeVertex);
-	}
-
-	// ѯÿڵӦļֵ
-	query.exec("SELECT * FROM RESULTS");
-	record = query.record();
-	while (query.next())
-	{
-		int index = query.value(0).toInt() - 1;
-		nodeVertices[index].totalDeformation = query.value(1).toFloat();
-		valueRange.minTotalDeformation = qMin(valueRange.minTotalDeformation, nodeVertices[index].totalDeformation);
-		valueRange.maxTotalDeformation = qMax(valueRange.maxTotalDeformation, nodeVertices[index].totalDeformation);
-
-		int i = 2;
-		for (int j = 0; j < 3; ++j)
-		{
-			nodeVertices[index].deformation[j] = query.value(i++).toFloat();
-		}
-		valueRange.minDeformation = qMinVec3(valueRange.minDeformation, nodeVertices[index].deformation);
-		valueRange.maxDeformation = qMaxVec3(valueRange.maxDeformation, nodeVertices[index].deformation);
-
-		for (int j = 0; j < 3; ++j)
-		{
-			nodeVertices[index].normalElasticStrain[j] = query.value(i++).toFloat();
-		}
-		valueRange.minNormalElasticStrain = qMinVec3(valueRange.minNormalElasticStrain, nodeVertices[index].normalElasticStrain);
-		valueRange.maxNormalElasticStrain = qMaxVec3(valueRange.maxNormalElasticStrain, nodeVertices[index].normalElasticStrain);
-
-		for (int j = 0; j < 3; ++j)
-		{
-			nodeVertices[index].shearElasticStrain[j] = query.value(i++).toFloat();
-		}
-		valueRange.minShearElasticStrain = qMinVec3(valueRange.minShearElasticStrain, nodeVertices[index].shearElasticStrain);
-		valueRange.maxShearElasticStrain = qMaxVec3(valueRange.maxShearElasticStrain, nodeVertices[index].shearElasticStrain);
-
-		nodeVertices[index].maximumPrincipalStress = query.value(i++).toFloat();
-		valueRange.minMaximumPrincipalStress = qMin(valueRange.minMaximumPrincipalStress, nodeVertices[index].maximumPrincipalStress);
-		valueRange.maxMaximumPrincipalStress = qMax(valueRange.maxMaximumPrincipalStress, nodeVertices[index].maximumPrincipalStress);
-
-		nodeVertices[index].middlePrincipalStress = query.value(i++).toFloat();
-		valueRange.minMiddlePrincipalStress = qMin(valueRange.minMiddlePrincipalStress, nodeVertices[index].middlePrincipalStress);
-		valueRange.maxMiddlePrincipalStress = qMax(valueRange.maxMiddlePrincipalStress, nodeVertices[index].middlePrincipalStress);
-
-		nodeVertices[index].minimumPrincipalStress = query.value(i++).toFloat();
-		valueRange.minMinimumPrincipalStress = qMin(valueRange.minMinimumPrincipalStress, nodeVertices[index].minimumPrincipalStress);
-		valueRange.maxMinimumPrincipalStress = qMax(valueRange.maxMinimumPrincipalStress, nodeVertices[index].minimumPrincipalStress);
-
-		for (int j = 0; j < 3; ++j)
-		{
-			nodeVertices[index].normalStress[j] = query.value(i++).toFloat();
-		}
-		valueRange.minNormalStress = qMinVec3(valueRange.minNormalStress, nodeVertices[index].normalStress);
-		valueRange.maxNormalStress = qMaxVec3(valueRange.maxNormalStress, nodeVertices[index].normalStress);
-
-		for (int j = 0; j < 3; ++j)
-		{
-			nodeVertices[index].shearStress[j] = query.value(i++).toFloat();
-		}
-		valueRange.minShearStress = qMinVec3(valueRange.minShearStress, nodeVertices[index].shearStress);
-		valueRange.maxShearStress = qMaxVec3(valueRange.maxShearStress, nodeVertices[index].shearStress);
-	}
-
-	// ѯԪϢ
-	query.exec("SELECT * FROM ELETYPE");
-	record = query.record();
-	while (query.next())
-	{
-		int zoneType = query.value(0).toInt();
-		zoneTypes.append(zoneType);
-	}
-
-	// ѯԪڵ
-	query.exec("SELECT * FROM ELEMENTS");
-	record = query.record();
-	static const int orders[8] = { 0, 1, 3, 4, 2, 7, 5, 6 };
-	while (query.next())
-	{
-		Zone zone;
-		int type = query.value(1).toInt();
-		if (type == 1)
-		{
-			zone.type = Brick;
-			zone.edgeNum = 12;
-		}
-		else if (type == 2)
-		{
-			zone.type = Tetrahedron;
-			zone.edgeNum = 6;
-		}
-
-		zone.vertexNum = query.value(2).toInt();
-		for (int i = 0; i < zone.vertexNum; ++i)
-		{
-			int o = zone.type == Brick ? orders[i] : i;
-			zone.vertices[i] = query.value(o + 3).toInt() - 1;
-		}
-
-		addZone(zone);
-	}
-
-	// ѯģӦĽڵϢ
-	query.exec("SELECT * FROM EXTERIOR");
-	record = query.record();
-	while (query.next())
-	{
-		Facet facet;
-		facet.elemID = query.value(1).toInt() - 1;
-		facet.facetID = query.value(2).toInt() - 1;
-		facet.num = query.value(3).toInt();
-		if (facet.num == 4)
-		{
-			facet.type = Q4;
-		}
-		else if (facet.num == 3)
-		{
-			facet.type = T3;
-		}
-
-		for (int i = 0; i < facet.num; ++i)
-		{
-			facet.indices[i] = query.value(i + 4).toInt() - 1;
-		}
-
-		addFacet(facet);
-	}
-
-	// ѯԪϢÿͨ
-	//query.exec("SELECT * FROM ELEMEDGES");
-	//record = query.record();
-	//while (query.next())
-	//{
-	//	int num = query.value(2).toInt() * 2;
-	//	for (int i = 0; i < num; ++i)
-	//	{
-	//		wireframeIndices.append(query.value(i + 3).toInt() - 1);
-	//	}
-	//}
-
-	// ѯģбӦĽڵϢ
-	//query.exec("SELECT * FROM FACETS");
-	//record = query.record();
-	//while (query.next())
-	//{
-	//	Face facet;
-	//	facet.num = query.value(2).toInt();
-	//	for (int i = 0; i < facet.num; ++i)
-	//	{
-	//		facet.indices[i] = query.value(i + 3).toInt() - 1;
-	//	}
-
-	//	allFacets.append(facet);
-	//}
-
-	// ѯ͡
-	//query.exec("SELECT * FROM RSTTYPE");
-	//record = query.record();
-	//while (query.next())
-	//{
-	//	QString str;
-	//	for (int i = 0; i < record.count(); ++i)
-	//	{
-	//		str += query.value(i).toString() + "-";
-	//	}
-
-	//	qDebug() << str;
-	//}
-
-	db.close();
-	return true;
-}
-
 bool OpenGLWindow::printDatabase(const QString& fileName)
 {
 	QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
@@ -853,461 +1150,28 @@ bool OpenGLWindow::printDatabase(const QString& fileName)
 	return true;
 }
 
-bool OpenGLWindow::loadDataFiles(const QString& fileName)
-{
-	// ģ
-	QString modelFileName = fileName;
-	QFileInfo fileInfo(modelFileName);
-	QFile modelFile(modelFileName);
-	if (modelFile.open(QIODevice::ReadOnly))
-	{
-		QTextStream in(&modelFile);
-		while (!in.atEnd())
-		{
-			QString header;
-			in >> header;
-			if (header == "G")
-			{
-				int index;
-				NodeVertex nodeVertex;
-				in >> index >> nodeVertex.position[0] >> nodeVertex.position[1] >> nodeVertex.position[2];
-
-				nodeVertex.position *= 8.0f;
-				mesh.vertices.append(nodeVertex.position);
-				nodeVertices.append(nodeVertex);
-			}
-			else if (header == "Z")
-			{
-				Zone zone;
-				QString type;
-				int Index;
-				in >> type >> Index;
-
-				if (type == "W6")
-				{
-					zone.type = Wedge;
-					zone.vertexNum = 6;
-					zone.edgeNum = 9;
-				}
-				else if (type == "B8")
-				{
-					zone.type = Brick;
-					zone.vertexNum = 8;
-					zone.edgeNum = 12;
-				}
-				else
-				{
-					qDebug() << "Unknown zone type: " << type;
-					return false;
-				}
-
-				for (int i = 0; i < zone.vertexNum; ++i)
-				{
-					in >> zone.vertices[i];
-					zone.vertices[i] -= 1;
-				}
-
-				addZone(zone);
-			}
-			else if (header == "F")
-			{
-				Facet facet;
-				QString type;
-				int Index;
-				in >> type >> Index;
-
-				if (type == "Q4")
-				{
-					facet.type = Q4;
-					facet.num = 4;
-				}
-				else if (type == "T3")
-				{
-					facet.type = T3;
-					facet.num = 3;
-				}
-				else
-				{
-					qDebug() << "Unknown face type: " << type;
-					return false;
-				}
-
-				for (int i = 0; i < facet.num; ++i)
-				{
-					in >> facet.indices[i];
-					facet.indices[i] -= 1;
-				}
-
-				facet.elemID = 0;
-				facet.facetID = exteriorFacets.count();
-				addFacet(facet);
-			}
-			in.readLine();
-		}
-		modelFile.close();
-	}
-	else
-	{
-		return false;
-	}
-
-	// XYZλ
-	QString gridPointFileName = modelFileName.replace(fileInfo.fileName(), "gridpoint_result.txt");
-	QFile gridFile(gridPointFileName);
-	if (gridFile.open(QIODevice::ReadOnly))
-	{
-		QTextStream in(&gridFile);
-		in.readLine();
-		while (!in.atEnd())
-		{
-			int index;
-			in >> index;
-			index -= 1;
-
-			in >> nodeVertices[index].deformation[0] >>
-				nodeVertices[index].deformation[1] >>
-				nodeVertices[index].totalDeformation;
-
-			valueRange.minTotalDeformation = qMin(valueRange.minTotalDeformation, nodeVertices[index].totalDeformation);
-			valueRange.maxTotalDeformation = qMax(valueRange.maxTotalDeformation, nodeVertices[index].totalDeformation);
-			in.readLine();
-		}
-
-		gridFile.close();
-	}
-	else
-	{
-		return false;
-	}
-
-	// Ӧ
-	QString zoneResultFileName = modelFileName.replace(fileInfo.fileName(), "zone_result.txt");
-	QFile zoneResultFile(zoneResultFileName);
-	if (zoneResultFile.open(QIODevice::ReadOnly))
-	{
-		QTextStream in(&zoneResultFile);
-		in.readLine();
-		while (!in.atEnd())
-		{
-			int index;
-			in >> index;
-			index -= 1;
-
-			in >> nodeVertices[index].normalStress[0] >>
-				nodeVertices[index].normalStress[1] >>
-				nodeVertices[index].normalStress[2] >>
-				nodeVertices[index].shearStress[0] >>
-				nodeVertices[index].shearStress[1] >>
-				nodeVertices[index].shearStress[2] >>
-				nodeVertices[index].maximumPrincipalStress;
-			in.readLine();
-		}
-
-		zoneResultFile.close();
-	}
-	else
-	{
-		return false;
-	}
-
-	// zoneĻ
-	for (Zone& zone : zones)
-	{
-		zone.cache(nodeVertices);
-	}
-
-	return true;
-}
-
-void OpenGLWindow::addFacet(Facet& facet)
+bool OpenGLWindow::hasZones() const
 {
-	QSet<uint32_t> indexSet;
-	for (int i = 0; i < facet.num; ++i)
-	{
-		indexSet.insert(facet.indices[i]);
-	}
-
-	if (indexSet.count() == 2)
-	{
-		return;
-	}
-
-	if (indexSet.count() < facet.num && indexSet.count() == 3)
-	{
-		facet.num = 3;
-	}
-	exteriorFacets.append(facet);
-
-	QVector<uint32_t> indices;
-	if (facet.num == 3)
-	{
-		indices.append({ facet.indices[0], facet.indices[1], facet.indices[2] });
-	}
-	else if (facet.num == 4)
-	{
-		indices.append({
-			facet.indices[0], facet.indices[1], facet.indices[2],
-			facet.indices[0], facet.indices[2], facet.indices[3]
-			});
-	}
-
-	facetIndices.append(indices);
-	for (int i = 0; i < indices.count(); i += 3)
-	{
-		uint32_t v0 = indices[i];
-		uint32_t v1 = indices[i + 1];
-		uint32_t v2 = indices[i + 2];
-
-		GeoUtil::addFace(mesh, v0, v1, v2);
-	}
+	return !zones.isEmpty() || brickedModel;
 }
 
-void OpenGLWindow::addZone(Zone& zone)
+void OpenGLWindow::clipZones(const Plane& plane)
 {
-	if (!zone.isValid())
+	if (!hasZones())
 	{
-		qDebug() << "Invalid zone!";
 		return;
 	}
 
-	for (int i = 0; i < zone.vertexNum; ++i)
-	{
-		zone.bound.combine(nodeVertices[zone.vertices[i]].position);
-	}
-	zone.bound.cache();
-
-	int elemID = zones.count();
-	if (zone.vertexNum == 8)
-	{
-		zoneIndices.append({ zone.vertices[0], zone.vertices[2], zone.vertices[1],
-			zone.vertices[1], zone.vertices[2], zone.vertices[4],
-			zone.vertices[0], zone.vertices[3], zone.vertices[2],
-			zone.vertices[2], zone.vertices[3], zone.vertices[5],
-			zone.vertices[2], zone.vertices[5], zone.vertices[4],
-			zone.vertices[4], zone.vertices[5], zone.vertices[7],
-			zone.vertices[1], zone.vertices[4], zone.vertices[6],
-			zone.vertices[4], zone.vertices[7], zone.vertices[6],
-			zone.vertices[0], zone.vertices[1], zone.vertices[3],
-			zone.vertices[1], zone.vertices[6], zone.vertices[3],
-			zone.vertices[3], zone.vertices[6], zone.vertices[5],
-			zone.vertices[6], zone.vertices[7], zone.vertices[5]
-			});
-		
-		zone.facets.append({
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[0], zone.vertices[2], zone.vertices[4], zone.vertices[1]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[0], zone.vertices[3], zone.vertices[5], zone.vertices[2]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[2], zone.vertices[5], zone.vertices[7], zone.vertices[4]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[1], zone.vertices[4], zone.vertices[7], zone.vertices[6]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[0], zone.vertices[1], zone.vertices[6], zone.vertices[3]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[3], zone.vertices[6], zone.vertices[7], zone.vertices[5]}}
-			});
-
-		zone.edges[0] = zone.vertices[0];
-		zone.edges[1] = zone.vertices[1];
-		zone.edges[2] = zone.vertices[1];
-		zone.edges[3] = zone.vertices[4];
-		zone.edges[4] = zone.vertices[4];
-		zone.edges[5] = zone.vertices[2];
-		zone.edges[6] = zone.vertices[2];
-		zone.edges[7] = zone.vertices[0];
-
-		zone.edges[8] = zone.vertices[3];
-		zone.edges[9] = zone.vertices[6];
-		zone.edges[10] = zone.vertices[6];
-		zone.edges[11] = zone.vertices[7];
-		zone.edges[12] = zone.vertices[7];
-		zone.edges[13] = zone.vertices[5];
-		zone.edges[14] = zone.vertices[5];
-		zone.edges[15] = zone.vertices[3];
-
-		zone.edges[16] = zone.vertices[0];
-		zone.edges[17] = zone.vertices[3];
-		zone.edges[18] = zone.vertices[1];
-		zone.edges[19] = zone.vertices[6];
-		zone.edges[20] = zone.vertices[4];
-		zone.edges[21] = zone.vertices[7];
-		zone.edges[22] = zone.vertices[2];
-		zone.edges[23] = zone.vertices[5];
-	}
-	else if (zone.vertexNum == 6)
-	{
-		zoneIndices.append({ zone.vertices[0], zone.vertices[1], zone.vertices[3],
-			zone.vertices[2], zone.vertices[5], zone.vertices[4],
-			zone.vertices[0], zone.vertices[2], zone.vertices[1],
-			zone.vertices[1], zone.vertices[2], zone.vertices[4],
-			zone.vertices[1], zone.vertices[5], zone.vertices[3],
-			zone.vertices[1], zone.vertices[4], zone.vertices[5],
-			zone.vertices[0], zone.vertices[3], zone.vertices[2],
-			zone.vertices[2], zone.vertices[3], zone.vertices[5]
-			});
-
-		zone.facets.append({
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[0], zone.vertices[1], zone.vertices[3], 0}},
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[2], zone.vertices[5], zone.vertices[4], 0}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[0], zone.vertices[2], zone.vertices[4], zone.vertices[1]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[1], zone.vertices[3], zone.vertices[5], zone.vertices[4]}},
-			{FacetType::Q4, elemID, Zone::facetID++, 4, {zone.vertices[0], zone.vertices[3], zone.vertices[5], zone.vertices[2]}}
-			});
-
-		zone.edges[0] = zone.vertices[0];
-		zone.edges[1] = zone.vertices[1];
-		zone.edges[2] = zone.vertices[1];
-		zone.edges[3] = zone.vertices[3];
-		zone.edges[4] = zone.vertices[3];
-		zone.edges[5] = zone.vertices[0];
-		zone.edges[6] = zone.vertices[2];
-		zone.edges[7] = zone.vertices[4];
-		zone.edges[8] = zone.vertices[4];
-		zone.edges[9] = zone.vertices[5];
-		zone.edges[10] = zone.vertices[5];
-		zone.edges[11] = zone.vertices[2];
-		zone.edges[12] = zone.vertices[1];
-		zone.edges[13] = zone.vertices[4];
-		zone.edges[14] = zone.vertices[3];
-		zone.edges[15] = zone.vertices[5];
-		zone.edges[16] = zone.vertices[0];
-		zone.edges[17] = zone.vertices[2];
-	}
-	else if (zone.vertexNum == 4)
-	{
-		zoneIndices.append({ zone.vertices[0], zone.vertices[1], zone.vertices[3],
-			zone.vertices[0], zone.vertices[3], zone.vertices[2],
-			zone.vertices[1], zone.vertices[2], zone.vertices[3],
-			zone.vertices[0], zone.vertices[2], zone.vertices[1],
-			});
-
-		zone.facets.append({
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[0], zone.vertices[1], zone.vertices[3], 0}},
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[0], zone.vertices[3], zone.vertices[2], 0}},
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[1], zone.vertices[2], zone.vertices[3], 0}},
-			{FacetType::T3, elemID, Zone::facetID++, 3, {zone.vertices[0], zone.vertices[2], zone.vertices[1], 0}},
-			});
-
-		zone.edges[0] = zone.vertices[0];
-		zone.edges[1] = zone.vertices[1];
-		zone.edges[2] = zone.vertices[0];
-		zone.edges[3] = zone.vertices[2];
-		zone.edges[4] = zone.vertices[1];
-		zone.edges[5] = zone.vertices[2];
-		zone.edges[6] = zone.vertices[0];
-		zone.edges[7] = zone.vertices[3];
-		zone.edges[8] = zone.vertices[1];
-		zone.edges[9] = zone.vertices[3];
-		zone.edges[10] = zone.vertices[2];
-		zone.edges[11] = zone.vertices[3];
-	}
-
-	for (int i = 0; i < zone.edgeNum * 2; ++i)
-	{
-		wireframeIndices.append(zone.edges[i]);
-	}
-
-	zone.cache(nodeVertices);
-	zones.append(zone);
-}
-
-void OpenGLWindow::preprocess()
-{
 	profileTimer.start();
-
-	// ϴ
-	GeoUtil::cleanMesh(mesh);
-
-	// ޸˳
-	GeoUtil::fixWindingOrder(mesh);
-
-	// ֤ģ͵ĺϷ
-	bool result = GeoUtil::validateMesh(mesh);
-	Q_ASSERT_X(result, "preprocess", "mesh is not valid!");
-
-	// ֻϷ
-	facetIndices.resize(mesh.faces.count() * 3);
-	for (int i = 0; i < mesh.faces.count(); ++i)
-	{
-		for (int j = 0; j < 3; ++j)
-		{
-			facetIndices[i * 3 + j] = mesh.faces[i].vertices[j];
-		}
-	}
-	qint64 cleanTime = profileTimer.restart();
-	qDebug() << "clean mesh time:" << cleanTime;
-
-	// İΧУʹַΧ滻귶Χ
-	for (Face& face : mesh.faces)
-	{
-		const NodeVertex& nv0 = nodeVertices[face.vertices[0]];
-		const NodeVertex& nv1 = nodeVertices[face.vertices[1]];
-		const NodeVertex& nv2 = nodeVertices[face.vertices[2]];
-
-		float minVal = qMin3(nv0.totalDeformation, nv1.totalDeformation, nv2.totalDeformation);
-		float maxVal = qMax3(nv0.totalDeformation, nv1.totalDeformation, nv2.totalDeformation);
-		face.bound.min = QVector3D(minVal, minVal, minVal);
-		face.bound.max = QVector3D(maxVal, maxVal, maxVal);
-		face.bound.cache();
-	}
-
-	// bvh
-	zoneBVHRoot = GeoUtil::buildBVHTree(zones);
-	qint64 buildZoneBVHTreeTime = profileTimer.restart();
-	qDebug() << "build zone bvh tree time:" << buildZoneBVHTreeTime;
-
-	faceBVHRoot = GeoUtil::buildBVHTree(mesh);
-	qint64 buildFaceBVHTreeTime = profileTimer.restart();
-	qDebug() << "build face bvh tree time:" << buildFaceBVHTreeTime;
-
-	// ֵ
-	interpUniformGrids();
-	qint64 interpTime = profileTimer.restart();
-	qDebug() << "interpolate uniform grids time:" << interpTime;
-}
-
-void OpenGLWindow::interpUniformGrids()
-{
-	const Bound& bound = zoneBVHRoot->bound;
-	QVector3D size = bound.size();
-	float maxDimVal = qMaxDimVal(size);
-	int maxDim = 100;
-	std::array<int, 3> dim;
-	for (int i = 0; i < 3; ++i)
-	{
-		dim[i] = size[i] / maxDimVal * maxDim;
-	}
-	uniformGrids.dim = dim;
-	uniformGrids.bound = bound;
-
-	float value;
-	for (int x = 0; x < dim[0]; ++x)
+	if (brickedModel)
 	{
-		for (int y = 0; y < dim[1]; ++y)
-		{
-			for (int z = 0; z < dim[2]; ++z)
-			{
-				QVector3D position;
-				position[0] = qLerp(bound.min[0], bound.max[0], (float)x / (dim[0] - 1));
-				position[1] = qLerp(bound.min[1], bound.max[1], (float)y / (dim[1] - 1));
-				position[2] = qLerp(bound.min[2], bound.max[2], (float)z / (dim[2] - 1));
-
-				if (GeoUtil::interpZones(zones, zoneBVHRoot, position, value))
-				{
-					uniformGrids.points.append({ position, value });
-				}
-
-				uniformGrids.voxelData.append(value);
-			}
-		}
+		brickedModel->clipZones(plane, nodeAttributes, sectionVertices, sectionIndices, sectionWireframeIndices, visibleGroupMask);
 	}
-}
-
-void OpenGLWindow::clipZones(const Plane& plane)
-{
-	if (zones.empty())
+	else
 	{
-		return;
+		GeoUtil::clipZones(zones, plane, zoneBVH, displayPositions(), nodeAttributes.values(), sectionVertices, sectionIndices, sectionWireframeIndices, visibleGroupMask);
 	}
 
-	profileTimer.start();
-	GeoUtil::clipZones(zones, plane, zoneBVHRoot, nodeVertices, sectionVertices, sectionIndices, sectionWireframeIndices);
-
 	// »
 	makeCurrent();
 	sectionVAO.bind();
@@ -1336,42 +1200,32 @@ void OpenGLWindow::clipZones(const Plane& plane)
 
 void OpenGLWindow::genIsosurface(float value)
 {
-	if (zones.empty())
+	if (!hasZones())
 	{
 		return;
 	}
 
-	// ֵ
+	// κʾֵʱ²
+	bool resampled = uniformGridsOutdated && displayMode == Isosurface;
+	if (resampled)
+	{
+		sampleUniformGrids();
+		GeoUtil::resampleUniformGrids(zones, uniformGrids);
+	}
+
+	// ֵ棬ͬʱɶ㻺
 	profileTimer.restart();
-	dualmc::DualMC<float> builder;
-	std::vector<dualmc::Vertex> vertices;
-	std::vector<dualmc::Quad> quads;
-	builder.build(uniformGrids.voxelData.constData(),
-		uniformGrids.dim[2], uniformGrids.dim[1], uniformGrids.dim[0],
-		value, false, false, vertices, quads);
+	GeoUtil::genIsosurface(uniformGrids, value, isosurfaceVertices, isosurfaceIndices);
 
 	qint64 buildIsosurfaceTime = profileTimer.restart();
 	//qDebug() << "build isosurface time:" << buildIsosurfaceTime;
 
-	// ¶㻺
-	isosurfaceVertices.clear();
-	QVector3D dimVector(uniformGrids.dim[0], uniformGrids.dim[1], uniformGrids.dim[2]);
-	for (const auto& vertex : vertices)
-	{
-		QVector3D position(vertex.z, vertex.y, vertex.x);
-		position = qMapClampRange(position, QVector3D(0.0f, 0.0f, 0.0f), dimVector, uniformGrids.bound.min, uniformGrids.bound.max);
-		isosurfaceVertices.append({ position, value });
-	}
-
-	isosurfaceIndices.clear();
-	for (const auto& quad : quads)
-	{
-		isosurfaceIndices.append({ (uint32_t)quad.i0, (uint32_t)quad.i1, (uint32_t)quad.i2 });
-		isosurfaceIndices.append({ (uint32_t)quad.i0, (uint32_t)quad.i2, (uint32_t)quad.i3 });
-	}
-
 	// GPUԴ
 	makeCurrent();
+	if (resampled)
+	{
+		uploadUniformGridPoints();
+	}
 	isosurfaceVAO.bind();
 	isosurfaceVBO.bind();
 	int count = isosurfaceVertices.count() * sizeof(NodeVertex);
@@ -1391,24 +1245,15 @@ void OpenGLWindow::genIsosurface(float value)
 
 void OpenGLWindow::genIsolines(float value)
 {
-	if (zones.empty())
+	if (!hasZones())
 	{
 		return;
 	}
 
 	// ֵ
-	isolineVertices.clear();
 	QVector<ClipLine> clipLines;
-	clipLines = GeoUtil::genIsolines(mesh, nodeVertices, value, faceBVHRoot);
-
-	for (const ClipLine& clipLine : clipLines)
-	{
-		const QList<QVector3D>& vertices = clipLine.vertices;
-		for (int i = 0; i < vertices.count() - 1; ++i)
-		{
-			isolineVertices.append({ NodeVertex{vertices[i], value}, NodeVertex{vertices[i + 1], value} });
-		}
-	}
+	clipLines = GeoUtil::genIsolines(mesh, displayPositions(), nodeAttributes.values(), value, faceValueTree);
+	GeoUtil::flattenIsolines(clipLines, value, isolineVertices);
 
 	// »
 	makeCurrent();
@@ -1422,49 +1267,33 @@ void OpenGLWindow::genIsolines(float value)
 void OpenGLWindow::bindPointShaderProgram()
 {
 	pointShaderProgram->bind();
-	pointShaderProgram->enableAttributeArray(0);
-	pointShaderProgram->enableAttributeArray(1);
-	pointShaderProgram->setAttributeBuffer(0, GL_FLOAT, offsetof(NodeVertex, position), 3, sizeof(NodeVertex));
-	pointShaderProgram->setAttributeBuffer(1, GL_FLOAT, offsetof(NodeVertex, totalDeformation), 1, sizeof(NodeVertex));
+	setVertexAttributes(pointShaderProgram, false, true);
 
-	pointShaderProgram->setUniformValue("valueRange.minValue", valueRange.minTotalDeformation);
-	pointShaderProgram->setUniformValue("valueRange.maxValue", valueRange.maxTotalDeformation);
+	QVector2D displayRange = getIsoValueRange();
+	pointShaderProgram->setUniformValue("valueRange.minValue", displayRange[0]);
+	pointShaderProgram->setUniformValue("valueRange.maxValue", displayRange[1]);
 }
 
-void OpenGLWindow::bindWireframeShaderProgram()
+void OpenGLWindow::bindWireframeShaderProgram(bool nodeBuffer)
 {
 	wireframeShaderProgram->bind();
-	wireframeShaderProgram->enableAttributeArray(0);
-	wireframeShaderProgram->setAttributeBuffer(0, GL_FLOAT, offsetof(NodeVertex, position), 3, sizeof(NodeVertex));
+	setVertexAttributes(wireframeShaderProgram, nodeBuffer, false);
 }
 
-void OpenGLWindow::bindShadedShaderProgram()
+void OpenGLWindow::bindShadedShaderProgram(bool nodeBuffer)
 {
 	shadedShaderProgram->bind();
-	shadedShaderProgram->enableAttributeArray(0);
-	shadedShaderProgram->enableAttributeArray(1);
-	shadedShaderProgram->enableAttributeArray(2);
-	shadedShaderProgram->enableAttributeArray(3);
-	shadedShaderProgram->enableAttributeArray(4);
-	shadedShaderProgram->enableAttributeArray(5);
-	shadedShaderProgram->enableAttributeArray(6);
-	shadedShaderProgram->enableAttributeArray(7);
-	shadedShaderProgram->enableAttributeArray(8);
-	shadedShaderProgram->enableAttributeArray(9);
-
-	shadedShaderProgram->setAttributeBuffer(0, GL_FLOAT, offsetof(NodeVertex, position), 3, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(1, GL_FLOAT, offsetof(NodeVertex, totalDeformation), 1, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(2, GL_FLOAT, offsetof(NodeVertex, deformation), 3, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(3, GL_FLOAT, offsetof(NodeVertex, normalElasticStrain), 3, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(4, GL_FLOAT, offsetof(NodeVertex, shearElasticStrain), 3, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(5, GL_FLOAT, offsetof(NodeVertex, maximumPrincipalStress), 1, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(6, GL_FLOAT, offsetof(NodeVertex, middlePrincipalStress), 1, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(7, GL_FLOAT, offsetof(NodeVertex, minimumPrincipalStress), 1, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(8, GL_FLOAT, offsetof(NodeVertex, normalStress), 3, sizeof(NodeVertex));
-	shadedShaderProgram->setAttributeBuffer(9, GL_FLOAT, offsetof(NodeVertex, shearStress), 3, sizeof(NodeVertex));
-
-	shadedShaderProgram->setUniformValue("valueRange.minTotalDeformation", valueRange.minTotalDeformation);
-	shadedShaderProgram->setUniformValue("valueRange.maxTotalDeformation", valueRange.maxTotalDeformation);
+	setVertexAttributes(shadedShaderProgram, nodeBuffer, true);
+
+	setShadedValueRangeUniforms();
+}
+
+void OpenGLWindow::setShadedValueRangeUniforms()
+{
+	// ڵ㻺еֵΪʾֶΣɫλƵʹʾֶεķΧ
+	QVector2D displayRange = getIsoValueRange();
+	shadedShaderProgram->setUniformValue("valueRange.minTotalDeformation", displayRange[0]);
+	shadedShaderProgram->setUniformValue("valueRange.maxTotalDeformation", displayRange[1]);
 
 	shadedShaderProgram->setUniformValue("valueRange.minDeformation", valueRange.minDeformation);
 	shadedShaderProgram->setUniformValue("valueRange.maxDeformation", valueRange.maxDeformation);
@@ -1494,8 +1323,34 @@ void OpenGLWindow::bindShadedShaderProgram()
 void OpenGLWindow::bindPickShaderProgram()
 {
 	pickShaderProgram->bind();
-	pickShaderProgram->enableAttributeArray(0);
-	pickShaderProgram->setAttributeBuffer(0, GL_FLOAT, offsetof(NodeVertex, position), 3, sizeof(NodeVertex));
+	setVertexAttributes(pickShaderProgram, true, false);
+}
+
+void OpenGLWindow::setVertexAttributes(QOpenGLShaderProgram* program, bool nodeBuffer, bool withValue)
+{
+	// ڵ㻺꼰ֱֵУ桢ֵȻΪеNodeVertex
+	program->enableAttributeArray(0);
+	if (nodeBuffer)
+	{
+		program->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(QVector3D));
+	}
+	else
+	{
+		program->setAttributeBuffer(0, GL_FLOAT, offsetof(NodeVertex, position), 3, sizeof(NodeVertex));
+	}
+
+	if (withValue)
+	{
+		program->enableAttributeArray(1);
+		if (nodeBuffer)
+		{
+			program->setAttributeBuffer(1, GL_FLOAT, nodeAttributes.count() * sizeof(QVector3D), 1, sizeof(float));
+		}
+		else
+		{
+			program->setAttributeBuffer(1, GL_FLOAT, offsetof(NodeVertex, value), 1, sizeof(NodeVertex));
+		}
+	}
 }
 
 void OpenGLWindow::initResources()
@@ -1505,7 +1360,12 @@ void OpenGLWindow::initResources()
 	nodeVBO.create();
 	nodeVBO.bind();
 	nodeVBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
-	nodeVBO.allocate(nodeVertices.constData(), nodeVertices.count() * sizeof(NodeVertex));
+	int positionSize = nodeAttributes.count() * sizeof(QVector3D);
+	int valueSize = nodeAttributes.count() * sizeof(float);
+	nodeVBO.allocate(positionSize + valueSize);
+	nodeVBO.write(0, nodeAttributes.positions.constData(), positionSize);
+	nodeVBO.write(positionSize, nodeAttributes.values().constData(), valueSize);
+	qDebug() << "node attributes(KB):" << (nodeAttributes.memoryUsage() >> 10) << "node vbo(KB):" << ((positionSize + valueSize) >> 10) << "zones(KB):" << (zones.memoryUsage() >> 10);
 
 	// ģʽȾԴ
 	{
@@ -1535,7 +1395,7 @@ void OpenGLWindow::initResources()
 		wireframeIBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
 		wireframeIBO.allocate(wireframeIndices.constData(), wireframeIndices.count() * sizeof(uint32_t));
 
-		bindWireframeShaderProgram();
+		bindWireframeShaderProgram(true);
 	}
 
 	// ԪģʽȾԴ
@@ -1550,7 +1410,7 @@ void OpenGLWindow::initResources()
 		zoneIBO.bind();
 		zoneIBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
 		zoneIBO.allocate(zoneIndices.constData(), zoneIndices.count() * sizeof(uint32_t));
-		bindShadedShaderProgram();
+		bindShadedShaderProgram(true);
 	}
 
 	// FaceȾԴ
@@ -1565,7 +1425,7 @@ void OpenGLWindow::initResources()
 		facetIBO.bind();
 		facetIBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
 		facetIBO.allocate(facetIndices.constData(), facetIndices.count() * sizeof(uint32_t));
-		bindShadedShaderProgram();
+		bindShadedShaderProgram(true);
 	}
 
 	// ȾԴ
@@ -1589,7 +1449,7 @@ void OpenGLWindow::initResources()
 		sectionIBO.bind();
 		sectionIBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
 		sectionIBO.allocate(sectionIndices.constData(), sectionIndices.count() * sizeof(uint32_t));
-		bindShadedShaderProgram();
+		bindShadedShaderProgram(false);
 
 		// ʼ߿Դ
 		sectionWireframeIndices.resize(sectionVertices.count() * 5);
@@ -1608,7 +1468,7 @@ void OpenGLWindow::initResources()
 		sectionVertices.clear();
 		sectionIndices.clear();
 		sectionWireframeIndices.clear();
-		bindWireframeShaderProgram();
+		bindWireframeShaderProgram(false);
 	}
 
 	// ֵȾԴ
@@ -1702,22 +1562,74 @@ void OpenGLWindow::initResources()
 	}
 }
 
+void OpenGLWindow::updateZoneGroupRanges()
+{
+	// ڵĿɼϲΪһ䣻λʱһλһɼмʰȡ
+	visibleGroupMask = 0;
+	zoneDrawRanges.clear();
+	wireframeDrawRanges.clear();
+	for (int i = 0; i < zoneGroups.count(); ++i)
+	{
+		if (!zoneGroupVisible[i])
+		{
+			continue;
+		}
+
+		const ZoneGroup& zoneGroup = zoneGroups[i];
+		visibleGroupMask |= qZoneGroupBit(i);
+		if (!zoneDrawRanges.isEmpty() && zoneDrawRanges.last().first + zoneDrawRanges.last().second == zoneGroup.zoneIndexBegin)
+		{
+			zoneDrawRanges.last().second += zoneGroup.zoneIndexNum;
+		}
+		else
+		{
+			zoneDrawRanges.append({ zoneGroup.zoneIndexBegin, zoneGroup.zoneIndexNum });
+		}
+
+		if (!wireframeDrawRanges.isEmpty() && wireframeDrawRanges.last().first + wireframeDrawRanges.last().second == zoneGroup.wireframeIndexBegin)
+		{
+			wireframeDrawRanges.last().second += zoneGroup.wireframeIndexNum;
+		}
+		else
+		{
+			wireframeDrawRanges.append({ zoneGroup.wireframeIndexBegin, zoneGroup.wireframeIndexNum });
+		}
+	}
+}
+
+void OpenGLWindow::drawIndexRanges(GLenum mode, const QVector<QPair<int, int>>& ranges)
+{
+	for (const auto& range : ranges)
+	{
+		glDrawElements(mode, range.second, GL_UNSIGNED_INT, reinterpret_cast<const void*>((size_t)range.first * sizeof(uint32_t)));
+	}
+}
+
 void OpenGLWindow::cleanResources()
 {
-	Zone::facetID = 0;
-	nodeVertices.clear();
+	nodeAttributes.clear();
 	exteriorFacets.clear();
 	mesh.clear();
 	objMesh.clear();
 	zones.clear();
 	valueRange.reset();
 	zoneTypes.clear();
-	GeoUtil::destroyBVHTree(zoneBVHRoot);
-	GeoUtil::destroyBVHTree(faceBVHRoot);
+	zoneBVH.clear();
+	faceValueTree.clear();
 	uniformGrids.clear();
+	showDeformation = false;
+	deformedPositions.clear();
+	uniformGridsOutdated = false;
 	wireframeIndices.clear();
 	zoneIndices.clear();
 	facetIndices.clear();
+	SAFE_DELETE(resultFields);
+	SAFE_DELETE(brickedModel);
+	zoneGroups.clear();
+	zoneGroupVisible.clear();
+	visibleGroupMask = kAllZoneGroups;
+	zoneDrawRanges.clear();
+	wireframeDrawRanges.clear();
 	sectionVertices.clear();
 	sectionIndices.clear();
 	sectionWireframeIndices.clear();
@@ -11,6 +11,8 @@
 #include <QMouseEvent>
 #include <QElapsedTimer>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QFileSystemWatcher>
 #include <vector>
 
 #include "geoutil.h"
@@ -25,6 +27,14 @@ enum PickMode
 	PickZone, PickFace, PickNone
 };
 
+// ʱ䲽ż룩Ԥȡʱ䲽
+const int kPlayInterval = 100;
+const int kPrefetchFrameNum = 4;
+const int kResultReloadDelay = 500;
+
+// ĬϱηŴϵʹλʾΪģͰΧжԽ߳ȵĸñ
+const float kDefaultDeformationRatio = 0.05f;
+
 class OpenGLWindow : public QOpenGLWidget, protected QOpenGLFunctions
 {
     Q_OBJECT
@@ -44,12 +54,55 @@ public:
 
     QVector2D getIsoValueRange();
 
+	QStringList getZoneGroupNames() const;
+	void setZoneGroupVisible(int group, bool flag);
+	bool isZoneGroupVisible(int group) const;
+
+	bool hasResultField(int field) const;
+	bool loadResultField(int field);
+	bool setDisplayField(int field);
+	int getDisplayField() const;
+
+	bool canShowDeformation() const;
+	bool setShowDeformation(bool flag);
+	bool isShowingDeformation() const;
+	void setDeformationScale(float scale);
+	float getDefaultDeformationScale() const;
+
     void openFile(const QString& fileName);
+    void cancelLoad();
+    bool isLoading() const;
     bool exportToEDB(const QString& exportPath);
+    bool exportToVTU(const QString& exportPath);
+    bool exportToPLY(const QString& exportPath);
+    void cancelExport();
+    bool isExporting() const;
+
+	bool openResultSeries(const QString& dirPath);
+	void closeResultSeries();
+	int getTimeStepCount() const;
+	int getTimeStepNumber(int index) const;
+	void setTimeStep(int index);
+	void setPlaying(bool flag);
+	bool isPlaying() const;
 
 signals:
 	void onModelStartLoad();
+	void onModelLoadProgress(int stage, int progress);
 	void onModelFinishLoad();
+	void onModelCancelLoad();
+	void onModelStartExport();
+	void onModelExportProgress(int table, int progress);
+	void onModelFinishExport();
+	void onTimeStepChanged(int index);
+	void onResultsReloaded();
+
+private slots:
+	void onModelLoaded();
+	void onModelExported();
+	void playNextTimeStep();
+	void onResultFileChanged(const QString& path);
+	void reloadResults();
 
 protected:
     void paintGL() override;
@@ -63,45 +116,84 @@ protected:
     void keyReleaseEvent(QKeyEvent* event) override;
 
 private:
-    bool loadDatabase(const QString& fileName);
     bool printDatabase(const QString& fileName);
 
-    bool loadDataFiles(const QString& fileName);
-    void addFacet(Facet& facet);
-    void addZone(Zone& zone);
-
-	void preprocess();
-    void interpUniformGrids();
-
+	bool hasZones() const;
+	void showExportResult(bool succeeded);
+	void watchResultFiles();
+	void sampleUniformGrids();
+	void uploadUniformGridPoints();
+	void updateResultValues(int nodeBegin, int nodeEnd);
+	const QVector<QVector3D>& displayPositions() const;
+	void updateDeformedGeometry();
+	void updateDeformedShape();
     void clipZones(const Plane& plane);
+	void updateZoneGroupRanges();
+	void drawIndexRanges(GLenum mode, const QVector<QPair<int, int>>& ranges);
     void genIsosurface(float value);
 	void genIsolines(float value);
 
     void bindPointShaderProgram();
-    void bindWireframeShaderProgram();
-    void bindShadedShaderProgram();
+    void bindWireframeShaderProgram(bool nodeBuffer);
+    void bindShadedShaderProgram(bool nodeBuffer);
+	void setShadedValueRangeUniforms();
     void bindPickShaderProgram();
+	void setVertexAttributes(QOpenGLShaderProgram* program, bool nodeBuffer, bool withValue);
 
     void initResources();
     void cleanResources();
 
-    QVector<NodeVertex> nodeVertices;
+    NodeAttributes nodeAttributes;
     QVector<Facet> exteriorFacets;
 
 	Mesh mesh;
 	Mesh objMesh;
-    QVector<Zone> zones;
+    ZoneSet zones;
     ValueRange valueRange;
 	QVector<int> zoneTypes;
-	BVHTreeNode* zoneBVHRoot;
-    BVHTreeNode* faceBVHRoot;
+	LinearBVH zoneBVH;
+	IntervalTree faceValueTree;
 	UniformGrids uniformGrids;
 
+	// Ԫ鼰ɼкϲĻ䣨ʼ
+	QVector<ZoneGroup> zoneGroups;
+	QVector<bool> zoneGroupVisible;
+	quint64 visibleGroupMask;
+	QVector<QPair<int, int>> zoneDrawRanges;
+	QVector<QPair<int, int>> wireframeDrawRanges;
+
+	class ModelLoader* modelLoader;
+	QFutureWatcher<bool> loadWatcher;
+	class EDBWriter* edbWriter;
+	QFutureWatcher<bool> exportWatcher;
+	// ʾڵλƳԷŴϵԪμԪbvh֮£ֻ¼ΧУؽ
+	// ԭʼ걣ڽڵйʹ
+	bool showDeformation;
+	float deformationScale;
+	QVector<QVector3D> deformedPositions;
+	bool uniformGridsOutdated;
+
+	class ResultSeries* resultSeries;
+	class ResultFieldStore* resultFields;
+	class BrickedModel* brickedModel;
+	int timeStep;
+	QTimer playTimer;
+
+	// дļʱֻ¶ȡֵμԤݱֲ
+	QString loadingFileName;
+	QString modelFileName;
+	QStringList resultFileNames;
+	QStringList changedResultFiles;
+	QVector<int> loadedResultFields;
+	QFileSystemWatcher resultWatcher;
+	QTimer reloadTimer;
+
     QOpenGLShaderProgram* pointShaderProgram;
     QOpenGLShaderProgram* wireframeShaderProgram;
 	QOpenGLShaderProgram* shadedShaderProgram;
 	QOpenGLShaderProgram* pickShaderProgram;
 
+	// ڵ㻺Ϊṹ鲼֣ȫڵǰʾֶεֵں
     QOpenGLBuffer nodeVBO;
 
     QOpenGLBuffer pointVBO;
@@ -0,0 +1,305 @@
+#include "resultfieldstore.h"
+#include "edbreader.h"
+#include "f3gridparser.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// ResultFieldStoreԱʵ
+ResultFieldStore::ResultFieldStore(int nodeNum, int maxMemoryMB) :
+	nodeNum(nodeNum), fieldCache(maxMemoryMB * 1024)
+{
+	source = NoFieldSource;
+	rangeValid.fill(false);
+	ranges.fill(QVector2D(kMaxVal, kMinVal));
+}
+
+ResultFieldStore::~ResultFieldStore()
+{
+	printStats();
+}
+
+void ResultFieldStore::openDatabase(const QString& fileName)
+{
+	source = DatabaseFieldSource;
+	databaseFileName = fileName;
+}
+
+void ResultFieldStore::openDataFiles(const QString& modelFileName, const ZoneSet& zones)
+{
+	// ԪԪţ1ʼӦԪ
+	QVector<int> offsets(zones.count() + 1);
+	QVector<uint32_t> nodes;
+	nodes.reserve(zones.count() * 8);
+	offsets[0] = 0;
+	for (int i = 0; i < zones.count(); ++i)
+	{
+		const quint32* vertices = zones.zoneVertices(i);
+		for (int j = 0; j < zones.vertexNum(i); ++j)
+		{
+			nodes.append(vertices[j]);
+		}
+		offsets[i + 1] = nodes.count();
+	}
+	openDataFiles(modelFileName, offsets, nodes);
+}
+
+void ResultFieldStore::openDataFiles(const QString& modelFileName, QVector<int>& zoneNodeOffsets, QVector<uint32_t>& zoneNodes)
+{
+	// ģļͬĿ¼ĽڵλƼԪӦ
+	QFileInfo fileInfo(modelFileName);
+	source = DataFilesFieldSource;
+	gridPointFileName = fileInfo.dir().filePath("gridpoint_result.txt");
+	zoneResultFileName = fileInfo.dir().filePath("zone_result.txt");
+	this->zoneNodeOffsets.swap(zoneNodeOffsets);
+	this->zoneNodes.swap(zoneNodes);
+	if (this->zoneNodeOffsets.isEmpty())
+	{
+		this->zoneNodeOffsets.append(0);
+	}
+}
+
+bool ResultFieldStore::hasField(int field) const
+{
+	if (field < 0 || field >= ResultFieldTypeNum)
+	{
+		return false;
+	}
+
+	if (source == DatabaseFieldSource)
+	{
+		return true;
+	}
+	else if (source == DataFilesFieldSource)
+	{
+		// ıֻλƼӦӦ
+		return field <= FieldUZ || (field >= FieldS1 && field <= FieldSZ);
+	}
+	return false;
+}
+
+bool ResultFieldStore::field(int field, QVector<float>& values)
+{
+	if (!hasField(field))
+	{
+		return false;
+	}
+
+	{
+		QMutexLocker locker(&mutex);
+		QVector<float>* cached = fieldCache.object(field);
+		if (cached)
+		{
+			values = *cached;
+			++stats.hitNum;
+			return true;
+		}
+	}
+
+	// ȡʱռͬһֶβȡʱԺɵΪ׼
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+	if (!loadField(field, values))
+	{
+		return false;
+	}
+
+	float minValue = kMaxVal;
+	float maxValue = kMinVal;
+	for (float value : values)
+	{
+		minValue = qMin(minValue, value);
+		maxValue = qMax(maxValue, value);
+	}
+
+	QMutexLocker locker(&mutex);
+	int cost = qMax(1, (int)(values.count() * sizeof(float) / 1024));
+	int cachedNum = fieldCache.count() + (fieldCache.contains(field) ? 0 : 1);
+	fieldCache.insert(field, new QVector<float>(values), cost);
+	stats.evictNum += qMax(0, cachedNum - fieldCache.count());
+	++stats.loadNum;
+	stats.loadedBytes += values.count() * sizeof(float);
+	stats.loadTime += profileTimer.elapsed();
+	rangeValid[field] = true;
+	ranges[field] = QVector2D(minValue, maxValue);
+	return true;
+}
+
+bool ResultFieldStore::getFieldRange(int field, float& minValue, float& maxValue) const
+{
+	// ֶα̭ԱֵΧ
+	QMutexLocker locker(&mutex);
+	if (field < 0 || field >= ResultFieldTypeNum || !rangeValid[field])
+	{
+		return false;
+	}
+
+	minValue = ranges[field][0];
+	maxValue = ranges[field][1];
+	return true;
+}
+
+void ResultFieldStore::invalidate()
+{
+	// ļ仯ѶȡֶμֵΧȫʧЧ
+	QMutexLocker locker(&mutex);
+	fieldCache.clear();
+	rangeValid.fill(false);
+	ranges.fill(QVector2D(kMaxVal, kMinVal));
+}
+
+void ResultFieldStore::setMemoryBudget(int maxMemoryMB)
+{
+	QMutexLocker locker(&mutex);
+	int cachedNum = fieldCache.count();
+	fieldCache.setMaxCost(maxMemoryMB * 1024);
+	stats.evictNum += cachedNum - fieldCache.count();
+}
+
+int ResultFieldStore::getMemoryUsage() const
+{
+	QMutexLocker locker(&mutex);
+	return fieldCache.totalCost();
+}
+
+ResultFieldStats ResultFieldStore::getStats() const
+{
+	QMutexLocker locker(&mutex);
+	return stats;
+}
+
+void ResultFieldStore::printStats() const
+{
+	QMutexLocker locker(&mutex);
+	qDebug() << "result fields hits:" << stats.hitNum << "loads:" << stats.loadNum << "evictions:" << stats.evictNum
+		<< "loaded(KB):" << stats.loadedBytes / 1024 << "load time:" << stats.loadTime
+		<< "cached fields:" << fieldCache.count() << "cache(KB):" << fieldCache.totalCost() << "/" << fieldCache.maxCost();
+}
+
+QString ResultFieldStore::getFieldName(int field)
+{
+	// EDBһ
+	static const char* fieldNames[ResultFieldTypeNum] = {
+		"USUM", "UX", "UY", "UZ",
+		"EPTOX", "EPTOY", "EPTOZ", "EPTOXY", "EPTOYZ", "EPTOXZ",
+		"S1", "S2", "S3",
+		"SX", "SY", "SZ", "SXY", "SYZ", "SXZ"
+	};
+	return field >= 0 && field < ResultFieldTypeNum ? QString(fieldNames[field]) : QString();
+}
+
+bool ResultFieldStore::loadField(int field, QVector<float>& values) const
+{
+	if (source == DatabaseFieldSource)
+	{
+		return loadDatabaseField(field, values);
+	}
+	else if (source == DataFilesFieldSource)
+	{
+		return loadDataFilesField(field, values);
+	}
+	return false;
+}
+
+bool ResultFieldStore::loadDatabaseField(int field, QVector<float>& values) const
+{
+	return EDBReader::readResultField(databaseFileName, getFieldName(field), nodeNum, values);
+}
+
+bool ResultFieldStore::loadDataFilesField(int field, QVector<float>& values) const
+{
+	QVector<bool> mask;
+	if (field <= FieldUZ)
+	{
+		// loadDataFilesһ£3УZλƣͬʱΪUSUM
+		int column = field == FieldUSUM ? 3 : field - FieldUX + 1;
+		values.fill(0.0f, nodeNum);
+		mask.fill(false, nodeNum);
+		return loadColumn(gridPointFileName, column, values, mask);
+	}
+
+	// ԪӦSig1~3Sxx~SzzƽԪĸڵ
+	QVector<float> zoneValues(zoneNodeOffsets.count() - 1, 0.0f);
+	mask.fill(false, zoneValues.count());
+	if (!loadColumn(zoneResultFileName, field - FieldS1 + 1, zoneValues, mask))
+	{
+		return false;
+	}
+	averageZoneValues(zoneValues, mask, values);
+	return true;
+}
+
+void ResultFieldStore::averageZoneValues(const QVector<float>& zoneValues, const QVector<bool>& zoneMask, QVector<float>& values) const
+{
+	QVector<int> counts(nodeNum, 0);
+	values.fill(0.0f, nodeNum);
+	for (int i = 0; i < zoneValues.count(); ++i)
+	{
+		if (!zoneMask[i])
+		{
+			continue;
+		}
+
+		for (int j = zoneNodeOffsets[i]; j < zoneNodeOffsets[i + 1]; ++j)
+		{
+			values[zoneNodes[j]] += zoneValues[i];
+			counts[zoneNodes[j]]++;
+		}
+	}
+
+	for (int i = 0; i < nodeNum; ++i)
+	{
+		if (counts[i] > 1)
+		{
+			values[i] /= counts[i];
+		}
+	}
+}
+
+bool ResultFieldStore::loadColumn(const QString& fileName, int column, QVector<float>& values, QVector<bool>& mask)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+	{
+		return false;
+	}
+
+	qint64 size = file.size();
+	const char* begin = reinterpret_cast<const char*>(file.map(0, size));
+	if (!begin)
+	{
+		return false;
+	}
+	const char* end = begin + size;
+
+	// ͷÿΪżֵֻȡһ
+	const char* p = F3GridParser::findLineEnd(begin, end) + 1;
+	while (p < end)
+	{
+		const char* lineEnd = F3GridParser::findLineEnd(p, end);
+		int index;
+		if (F3GridParser::parseInt(p, lineEnd, index))
+		{
+			if (index < 1 || index > values.count())
+			{
+				return false;
+			}
+
+			float value = 0.0f;
+			for (int i = 0; i < column; ++i)
+			{
+				if (!F3GridParser::parseFloat(p, lineEnd, value))
+				{
+					return false;
+				}
+			}
+			values[index - 1] = value;
+			mask[index - 1] = true;
+		}
+		p = lineEnd + 1;
+	}
+	return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "geotypes.h"
+#include <QCache>
+#include <QMutex>
+#include <QVector2D>
+
+/**
+	ڵֶʽ洢ֶࣨ״ʹʱŴEDBıȡڴLRṶ̭ٴʹʱ¶ȡ
+*/
+
+const int kDefaultFieldCacheMB = 32;
+
+enum ResultFieldSource
+{
+	NoFieldSource, DatabaseFieldSource, DataFilesFieldSource
+};
+
+struct ResultFieldStats
+{
+	int hitNum = 0;
+	int loadNum = 0;
+	int evictNum = 0;
+	qint64 loadedBytes = 0;
+	qint64 loadTime = 0;		// 
+};
+
+class ResultFieldStore
+{
+public:
+	ResultFieldStore(int nodeNum, int maxMemoryMB = kDefaultFieldCacheMB);
+	~ResultFieldStore();
+
+	void openDatabase(const QString& fileName);
+	void openDataFiles(const QString& modelFileName, const ZoneSet& zones);
+	void openDataFiles(const QString& modelFileName, QVector<int>& zoneNodeOffsets, QVector<uint32_t>& zoneNodes);
+
+	bool hasField(int field) const;
+	bool field(int field, QVector<float>& values);
+	bool getFieldRange(int field, float& minValue, float& maxValue) const;
+	void invalidate();
+
+	void setMemoryBudget(int maxMemoryMB);
+	int getMemoryUsage() const;	// KB
+	ResultFieldStats getStats() const;
+	void printStats() const;
+
+	static QString getFieldName(int field);
+
+private:
+	bool loadField(int field, QVector<float>& values) const;
+	bool loadDatabaseField(int field, QVector<float>& values) const;
+	bool loadDataFilesField(int field, QVector<float>& values) const;
+	void averageZoneValues(const QVector<float>& zoneValues, const QVector<bool>& zoneMask, QVector<float>& values) const;
+
+	static bool loadColumn(const QString& fileName, int column, QVector<float>& values, QVector<bool>& mask);
+
+	int nodeNum;
+	ResultFieldSource source;
+	QString databaseFileName;
+	QString gridPointFileName;
+	QString zoneResultFileName;
+
+	// ԪڵCSRڽԪƽڵ
+	QVector<int> zoneNodeOffsets;
+	QVector<uint32_t> zoneNodes;
+
+	mutable QMutex mutex;
+	QCache<int, QVector<float>> fieldCache;
+	std::array<bool, ResultFieldTypeNum> rangeValid;
+	std::array<QVector2D, ResultFieldTypeNum> ranges;
+	ResultFieldStats stats;
+};
@@ -0,0 +1,327 @@
+#include "resultseries.h"
+#include "f3gridparser.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
+
+// ResultSeriesԱʵ
+ResultSeries::ResultSeries(int nodeNum, int maxCacheMB, int keyframeInterval, float relativeError) :
+	nodeNum(nodeNum), keyframeInterval(keyframeInterval), relativeError(relativeError), frameCache(maxCacheMB * 1024)
+{
+	resultStore = nullptr;
+	hasErrorBounds = false;
+	errorBounds.fill(relativeError);
+	wantedBegin = 0;
+	wantedNum = 0;
+	hitNum = 0;
+	missNum = 0;
+	waitNum = 0;
+	prefetchNum = 0;
+
+	// Ԥȡֻʹһ̨̣߳GUI߳
+	prefetchPool.setMaxThreadCount(1);
+}
+
+ResultSeries::~ResultSeries()
+{
+	canceled.store(1);
+	prefetchPool.waitForDone();
+	printStats();
+	if (resultStore)
+	{
+		resultStore->printStats();
+	}
+	SAFE_DELETE(resultStore);
+}
+
+bool ResultSeries::open(const QString& dirPath)
+{
+	// ļʱ䲽Žβgridpoint_result_0010.txt
+	QDir dir(dirPath);
+	QVector<QPair<int, QString>> steps;
+	for (const QString& name : dir.entryList(QStringList() << "*.txt", QDir::Files))
+	{
+		QString baseName = QFileInfo(name).completeBaseName();
+		int digitBegin = baseName.length();
+		while (digitBegin > 0 && baseName[digitBegin - 1].isDigit())
+		{
+			--digitBegin;
+		}
+
+		if (digitBegin < baseName.length())
+		{
+			steps.append({ baseName.mid(digitBegin).toInt(), dir.filePath(name) });
+		}
+	}
+	std::sort(steps.begin(), steps.end());
+
+	fileNames.clear();
+	stepNumbers.clear();
+	for (const auto& step : steps)
+	{
+		stepNumbers.append(step.first);
+		fileNames.append(step.second);
+	}
+
+	// ѹ洢ʱ䲽
+	SAFE_DELETE(resultStore);
+	resultStore = new ResultStore(fileNames.count(), nodeNum, keyframeInterval, relativeError);
+
+	// δָʱȡĩʱ䲽ֵΧȡ˳޹أ׸ʱ䲽Ϊȫ0
+	if (hasErrorBounds)
+	{
+		resultStore->setErrorBounds(errorBounds);
+	}
+	else if (!fileNames.isEmpty())
+	{
+		QVector<ResultFrame> resultFrames(fileNames.count() > 1 ? 2 : 1);
+		for (int i = 0; i < resultFrames.count(); ++i)
+		{
+			if (!loadFrame(fileNames[i == 0 ? 0 : fileNames.count() - 1], nodeNum, resultFrames[i]))
+			{
+				resultFrames[i].values.clear();
+			}
+		}
+		resultStore->initErrorBounds(resultFrames);
+	}
+
+	qDebug() << "result series steps:" << fileNames.count() << "cache(MB):" << frameCache.maxCost() / 1024;
+	return !fileNames.isEmpty();
+}
+
+int ResultSeries::count() const
+{
+	return fileNames.count();
+}
+
+int ResultSeries::stepNumber(int index) const
+{
+	return stepNumbers[index];
+}
+
+QString ResultSeries::fileName(int index) const
+{
+	return fileNames[index];
+}
+
+void ResultSeries::setErrorBounds(const std::array<float, kResultFieldNum>& bounds)
+{
+	// ڶȡʱ䲽֮ǰָѹʱѹ洢ٽµ
+	hasErrorBounds = true;
+	errorBounds = bounds;
+	if (resultStore)
+	{
+		resultStore->setErrorBounds(bounds);
+	}
+}
+
+std::array<float, kResultFieldNum> ResultSeries::getErrorBounds() const
+{
+	return resultStore ? resultStore->getErrorBounds() : errorBounds;
+}
+
+bool ResultSeries::frame(int index, ResultFrame& resultFrame)
+{
+	if (index < 0 || index >= count())
+	{
+		return false;
+	}
+
+	QFuture<void> pending;
+	{
+		QMutexLocker locker(&mutex);
+		if (takeCached(index, resultFrame))
+		{
+			++hitNum;
+			return true;
+		}
+
+		if (pendingFrames.contains(index))
+		{
+			pending = pendingFrames[index];
+			++waitNum;
+		}
+		else
+		{
+			++missNum;
+		}
+	}
+
+	// Ԥȡ֡ȴɣظȡ
+	pending.waitForFinished();
+	{
+		QMutexLocker locker(&mutex);
+		if (takeCached(index, resultFrame))
+		{
+			return true;
+		}
+	}
+
+	if (!readFrame(index, resultFrame))
+	{
+		return false;
+	}
+
+	QMutexLocker locker(&mutex);
+	insertCached(index, resultFrame);
+	return true;
+}
+
+void ResultSeries::prefetch(int index, int num)
+{
+	if (count() == 0)
+	{
+		return;
+	}
+
+	QMutexLocker locker(&mutex);
+	wantedBegin = index;
+	wantedNum = qMin(num, count());
+	for (int i = 0; i < wantedNum; ++i)
+	{
+		// ѭʱӵһʱ䲽Ԥȡ
+		int next = (index + i) % count();
+		if (frameCache.contains(next) || pendingFrames.contains(next))
+		{
+			continue;
+		}
+
+		pendingFrames.insert(next, QtConcurrent::run(&prefetchPool, [this, next]() {
+			prefetchFrame(next);
+		}));
+	}
+}
+
+void ResultSeries::printStats() const
+{
+	QMutexLocker locker(&mutex);
+	qDebug() << "result series cache hits:" << hitNum << "misses:" << missNum << "waits:" << waitNum
+		<< "prefetched:" << prefetchNum << "cached frames:" << frameCache.count() << "cache(KB):" << frameCache.totalCost();
+}
+
+bool ResultSeries::loadFrame(const QString& fileName, int nodeNum, ResultFrame& resultFrame)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+	{
+		return false;
+	}
+
+	qint64 size = file.size();
+	const char* begin = reinterpret_cast<const char*>(file.map(0, size));
+	if (!begin)
+	{
+		return false;
+	}
+	const char* end = begin + size;
+
+	// loadDataFilesһ£ͷÿΪڵżλ
+	resultFrame.values.fill(0.0f, nodeNum * 3);
+	resultFrame.minValue = kMaxVal;
+	resultFrame.maxValue = kMinVal;
+	float* values = resultFrame.values.data();
+	const char* p = F3GridParser::findLineEnd(begin, end) + 1;
+	while (p < end)
+	{
+		const char* lineEnd = F3GridParser::findLineEnd(p, end);
+		int index;
+		if (F3GridParser::parseInt(p, lineEnd, index))
+		{
+			if (index < 1 || index > nodeNum)
+			{
+				return false;
+			}
+
+			float* value = values + (index - 1) * 3;
+			if (!F3GridParser::parseFloat(p, lineEnd, value[0]) ||
+				!F3GridParser::parseFloat(p, lineEnd, value[1]) ||
+				!F3GridParser::parseFloat(p, lineEnd, value[2]))
+			{
+				return false;
+			}
+
+			resultFrame.minValue = qMin(resultFrame.minValue, value[2]);
+			resultFrame.maxValue = qMax(resultFrame.maxValue, value[2]);
+		}
+		p = lineEnd + 1;
+	}
+	return true;
+}
+
+ResultStoreStats ResultSeries::getStoreStats() const
+{
+	return resultStore ? resultStore->getStats() : ResultStoreStats();
+}
+
+bool ResultSeries::readFrame(int index, ResultFrame& resultFrame)
+{
+	// ѹ洢ʱ䲽ֱӽ룬ٶȡļ
+	if (resultStore->decode(index, resultFrame))
+	{
+		return true;
+	}
+
+	// ֡Ĺؼ֡ؼ֡δ洢ʱȶȡؼ֡
+	int keyIndex = resultStore->keyframeIndex(index);
+	if (keyIndex != index && !resultStore->contains(keyIndex))
+	{
+		ResultFrame keyframe;
+		if (!loadFrame(fileNames[keyIndex], nodeNum, keyframe) || !resultStore->encode(keyIndex, keyframe))
+		{
+			return false;
+		}
+	}
+
+	// ֵ֤״ζȡ֮Ľһ
+	return loadFrame(fileNames[index], nodeNum, resultFrame) &&
+		resultStore->encode(index, resultFrame) &&
+		resultStore->decode(index, resultFrame);
+}
+
+bool ResultSeries::takeCached(int index, ResultFrame& resultFrame)
+{
+	ResultFrame* cached = frameCache.object(index);
+	if (!cached)
+	{
+		return false;
+	}
+
+	resultFrame = *cached;
+	return true;
+}
+
+void ResultSeries::insertCached(int index, const ResultFrame& resultFrame)
+{
+	frameCache.insert(index, new ResultFrame(resultFrame), resultFrame.cacheCost());
+}
+
+bool ResultSeries::isWanted(int index) const
+{
+	int offset = (index - wantedBegin + count()) % count();
+	return offset < wantedNum;
+}
+
+void ResultSeries::prefetchFrame(int index)
+{
+	bool wanted;
+	{
+		QMutexLocker locker(&mutex);
+		wanted = isWanted(index);
+	}
+
+	// תҪֱ֡ӷ
+	ResultFrame resultFrame;
+	bool loaded = wanted && canceled.load() == 0 && readFrame(index, resultFrame);
+
+	QMutexLocker locker(&mutex);
+	if (loaded)
+	{
+		insertCached(index, resultFrame);
+		++prefetchNum;
+	}
+	pendingFrames.remove(index);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "resultstore.h"
+#include <QCache>
+#include <QFuture>
+#include <QMutex>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QStringList>
+
+/**
+	ʱ䲽ࣨĿ¼ʱ䲽Ľļȡʱ䲽ѹפڴ棬LRU֡棬̨Ԥȡʱ䲽
+*/
+
+const int kDefaultFrameCacheMB = 64;
+
+class ResultSeries
+{
+public:
+	ResultSeries(int nodeNum, int maxCacheMB = kDefaultFrameCacheMB,
+		int keyframeInterval = kDefaultKeyframeInterval, float relativeError = kDefaultRelativeError);
+	~ResultSeries();
+
+	bool open(const QString& dirPath);
+	int count() const;
+	int stepNumber(int index) const;
+	QString fileName(int index) const;
+
+	void setErrorBounds(const std::array<float, kResultFieldNum>& bounds);
+	std::array<float, kResultFieldNum> getErrorBounds() const;
+
+	bool frame(int index, ResultFrame& resultFrame);
+	void prefetch(int index, int num);
+	void printStats() const;
+	ResultStoreStats getStoreStats() const;
+
+	static bool loadFrame(const QString& fileName, int nodeNum, ResultFrame& resultFrame);
+
+private:
+	bool readFrame(int index, ResultFrame& resultFrame);
+	bool takeCached(int index, ResultFrame& resultFrame);
+	void insertCached(int index, const ResultFrame& resultFrame);
+	bool isWanted(int index) const;
+	void prefetchFrame(int index);
+
+	int nodeNum;
+	int keyframeInterval;
+	float relativeError;
+	bool hasErrorBounds;
+	std::array<float, kResultFieldNum> errorBounds;
+	QStringList fileNames;
+	QVector<int> stepNumbers;
+
+	ResultStore* resultStore;
+
+	mutable QMutex mutex;
+	QCache<int, ResultFrame> frameCache;
+	QMap<int, QFuture<void>> pendingFrames;
+	int wantedBegin;
+	int wantedNum;
+	QThreadPool prefetchPool;
+	QAtomicInt canceled;
+
+	int hitNum;
+	int missNum;
+	int waitNum;
+	int prefetchNum;
+};
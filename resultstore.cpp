@@ -0,0 +1,324 @@
+#include "resultstore.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <cmath>
+
+// ResultFrameԱʵ
+int ResultFrame::cacheCost() const
+{
+	// 濪KB
+	return qMax(1, (int)(values.count() * sizeof(float) / 1024));
+}
+
+void ResultFrame::apply(NodeAttributes& nodeAttributes) const
+{
+	int nodeNum = qMin(nodeAttributes.count(), values.count() / kResultFieldNum);
+	float* deformationX = nodeAttributes.field(FieldUX).data();
+	float* deformationY = nodeAttributes.field(FieldUY).data();
+	float* deformationZ = nodeAttributes.field(FieldUZ).data();
+	float* totalDeformation = nodeAttributes.field(FieldUSUM).data();
+	const float* value = values.constData();
+	for (int i = 0; i < nodeNum; ++i, value += kResultFieldNum)
+	{
+		deformationX[i] = value[0];
+		deformationY[i] = value[1];
+		deformationZ[i] = value[2];
+		totalDeformation[i] = value[2];
+	}
+}
+
+// ResultStoreStatsԱʵ
+double ResultStoreStats::compressionRatio() const
+{
+	return storedBytes > 0 ? (double)rawBytes / storedBytes : 0.0;
+}
+
+double ResultStoreStats::decodeThroughput() const
+{
+	return decodeTime > 0 ? decodedBytes / 1048576.0 / (decodeTime * 1e-9) : 0.0;
+}
+
+// ResultStoreԱʵ
+ResultStore::ResultStore(int stepNum, int nodeNum, int keyframeInterval, float relativeError) :
+	nodeNum(nodeNum), keyframeInterval(qMax(1, keyframeInterval)), relativeError(relativeError)
+{
+	// δָʱֵΧΪ1
+	errorBounds.fill(relativeError);
+	blocks.resize(stepNum);
+}
+
+void ResultStore::setErrorBounds(const std::array<float, kResultFieldNum>& bounds)
+{
+	// бʱ޸
+	QMutexLocker locker(&mutex);
+	if (stats.frameNum == 0)
+	{
+		errorBounds = bounds;
+	}
+}
+
+void ResultStore::initErrorBounds(const QVector<ResultFrame>& resultFrames)
+{
+	// ȡ֡ϲֵֶΧԱΧΪ0ֶʹֶηΧ
+	std::array<float, kResultFieldNum> minValues;
+	std::array<float, kResultFieldNum> maxValues;
+	minValues.fill(kMaxVal);
+	maxValues.fill(kMinVal);
+	for (const ResultFrame& resultFrame : resultFrames)
+	{
+		const float* value = resultFrame.values.constData();
+		int valueNum = qMin(nodeNum, resultFrame.values.count() / kResultFieldNum);
+		for (int i = 0; i < valueNum; ++i, value += kResultFieldNum)
+		{
+			for (int f = 0; f < kResultFieldNum; ++f)
+			{
+				minValues[f] = qMin(minValues[f], value[f]);
+				maxValues[f] = qMax(maxValues[f], value[f]);
+			}
+		}
+	}
+
+	float maxRange = 0.0f;
+	for (int f = 0; f < kResultFieldNum; ++f)
+	{
+		maxRange = qMax(maxRange, maxValues[f] - minValues[f]);
+	}
+
+	std::array<float, kResultFieldNum> bounds;
+	for (int f = 0; f < kResultFieldNum; ++f)
+	{
+		float range = maxValues[f] - minValues[f];
+		bounds[f] = (range > 0.0f ? range : (maxRange > 0.0f ? maxRange : 1.0f)) * relativeError;
+	}
+	setErrorBounds(bounds);
+}
+
+std::array<float, kResultFieldNum> ResultStore::getErrorBounds() const
+{
+	QMutexLocker locker(&mutex);
+	return errorBounds;
+}
+
+int ResultStore::getKeyframeInterval() const
+{
+	return keyframeInterval;
+}
+
+int ResultStore::keyframeIndex(int index) const
+{
+	return index - index % keyframeInterval;
+}
+
+bool ResultStore::contains(int index) const
+{
+	QMutexLocker locker(&mutex);
+	return index >= 0 && index < blocks.count() && !blocks[index].data.isEmpty();
+}
+
+bool ResultStore::encode(int index, const ResultFrame& resultFrame)
+{
+	if (index < 0 || index >= blocks.count() || resultFrame.values.count() != nodeNum * kResultFieldNum)
+	{
+		return false;
+	}
+
+	QMutexLocker locker(&mutex);
+	if (!blocks[index].data.isEmpty())
+	{
+		return true;
+	}
+
+	// ǹؼ֡ؼ֣֡ؼ֡ʱ䲽洢
+	QVector<qint64> reference;
+	int keyIndex = keyframeIndex(index);
+	if (keyIndex != index && !decodeBlock(blocks[keyIndex].data, nullptr, nodeNum * kResultFieldNum, reference))
+	{
+		return false;
+	}
+
+	QVector<qint64> quantized;
+	quantize(resultFrame, quantized);
+
+	Block& block = blocks[index];
+	encodeBlock(quantized, keyIndex != index ? &reference : nullptr, block.data);
+	block.minValue = resultFrame.minValue;
+	block.maxValue = resultFrame.maxValue;
+
+	++stats.frameNum;
+	stats.keyframeNum += keyIndex == index ? 1 : 0;
+	stats.rawBytes += resultFrame.values.count() * sizeof(float);
+	stats.storedBytes += block.data.size();
+	return true;
+}
+
+bool ResultStore::decode(int index, ResultFrame& resultFrame)
+{
+	if (index < 0 || index >= blocks.count())
+	{
+		return false;
+	}
+
+	// ʽʱռ
+	Block block;
+	Block keyBlock;
+	int keyIndex = keyframeIndex(index);
+	{
+		QMutexLocker locker(&mutex);
+		block = blocks[index];
+		keyBlock = blocks[keyIndex];
+	}
+	if (block.data.isEmpty() || keyBlock.data.isEmpty())
+	{
+		return false;
+	}
+
+	QElapsedTimer profileTimer;
+	profileTimer.start();
+
+	QVector<qint64> quantized;
+	if (keyIndex == index)
+	{
+		if (!decodeBlock(block.data, nullptr, nodeNum * kResultFieldNum, quantized))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		QVector<qint64> reference;
+		if (!decodeBlock(keyBlock.data, nullptr, nodeNum * kResultFieldNum, reference) ||
+			!decodeBlock(block.data, &reference, nodeNum * kResultFieldNum, quantized))
+		{
+			return false;
+		}
+	}
+
+	dequantize(quantized, resultFrame);
+	resultFrame.minValue = block.minValue;
+	resultFrame.maxValue = block.maxValue;
+
+	qint64 decodeTime = profileTimer.nsecsElapsed();
+	QMutexLocker locker(&mutex);
+	stats.decodedBytes += resultFrame.values.count() * sizeof(float);
+	stats.decodeTime += decodeTime;
+	return true;
+}
+
+ResultStoreStats ResultStore::getStats() const
+{
+	QMutexLocker locker(&mutex);
+	return stats;
+}
+
+void ResultStore::printStats() const
+{
+	ResultStoreStats storeStats = getStats();
+	std::array<float, kResultFieldNum> bounds = getErrorBounds();
+	qDebug() << "result store frames:" << storeStats.frameNum << "keyframes:" << storeStats.keyframeNum
+		<< "keyframe interval:" << keyframeInterval << "error bounds:" << bounds[0] << bounds[1] << bounds[2]
+		<< "raw(KB):" << storeStats.rawBytes / 1024 << "stored(KB):" << storeStats.storedBytes / 1024
+		<< "ratio:" << storeStats.compressionRatio() << "decode(MB/s):" << storeStats.decodeThroughput();
+}
+
+void ResultStore::quantize(const ResultFrame& resultFrame, QVector<qint64>& quantized) const
+{
+	// ֶηֿУ
+	quantized.resize(nodeNum * kResultFieldNum);
+	for (int f = 0; f < kResultFieldNum; ++f)
+	{
+		double invStep = 1.0 / quantizationStep(f);
+		qint64* dst = quantized.data() + f * nodeNum;
+		const float* src = resultFrame.values.constData() + f;
+		for (int i = 0; i < nodeNum; ++i, src += kResultFieldNum)
+		{
+			dst[i] = std::llround(*src * invStep);
+		}
+	}
+}
+
+void ResultStore::dequantize(const QVector<qint64>& quantized, ResultFrame& resultFrame) const
+{
+	resultFrame.values.resize(nodeNum * kResultFieldNum);
+	for (int f = 0; f < kResultFieldNum; ++f)
+	{
+		double step = quantizationStep(f);
+		const qint64* src = quantized.constData() + f * nodeNum;
+		float* dst = resultFrame.values.data() + f;
+		for (int i = 0; i < nodeNum; ++i, dst += kResultFieldNum)
+		{
+			*dst = (float)(src[i] * step);
+		}
+	}
+}
+
+double ResultStore::quantizationStep(int field) const
+{
+	// С޵2Ϊתfloatʱ
+	return 1.9 * errorBounds[field];
+}
+
+void ResultStore::encodeBlock(const QVector<qint64>& quantized, const QVector<qint64>* reference, QByteArray& data)
+{
+	// ؼ֡洢ڽڵĲ֣ʱ䲽洢Թؼ֡Ĳ
+	data.clear();
+	data.reserve(quantized.count() * 2);
+	qint64 previous = 0;
+	for (int i = 0; i < quantized.count(); ++i)
+	{
+		qint64 predicted = reference ? (*reference)[i] : previous;
+		writeVarint(data, quantized[i] - predicted);
+		previous = quantized[i];
+	}
+	data.squeeze();
+}
+
+bool ResultStore::decodeBlock(const QByteArray& data, const QVector<qint64>* reference, int valueNum, QVector<qint64>& quantized)
+{
+	quantized.resize(valueNum);
+	qint64* dst = quantized.data();
+	const qint64* predicted = reference ? reference->constData() : nullptr;
+	const char* p = data.constData();
+	const char* end = p + data.size();
+	qint64 previous = 0;
+	for (int i = 0; i < valueNum; ++i)
+	{
+		qint64 delta;
+		if (!readVarint(p, end, delta))
+		{
+			return false;
+		}
+
+		dst[i] = (predicted ? predicted[i] : previous) + delta;
+		previous = dst[i];
+	}
+	return p == end;
+}
+
+void ResultStore::writeVarint(QByteArray& data, qint64 value)
+{
+	// zigzag7λһд
+	quint64 bits = ((quint64)value << 1) ^ (quint64)(value >> 63);
+	while (bits >= 0x80)
+	{
+		data.append((char)(bits | 0x80));
+		bits >>= 7;
+	}
+	data.append((char)bits);
+}
+
+bool ResultStore::readVarint(const char*& p, const char* end, qint64& value)
+{
+	quint64 bits = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7)
+	{
+		quint8 byte = (quint8)*p++;
+		bits |= (quint64)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			value = (qint64)(bits >> 1) ^ -(qint64)(bits & 1);
+			return true;
+		}
+	}
+	return false;
+}
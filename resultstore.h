@@ -0,0 +1,82 @@
+#pragma once
+
+#include "geotypes.h"
+#include <QByteArray>
+#include <QMutex>
+
+/**
+	ʱ䲽ѹ洢ֶࣨؼ֮֡ʱ䲽ֻ洢Թؼ֡Ĳ֣䳤룩
+*/
+
+const int kResultFieldNum = 3;
+const int kDefaultKeyframeInterval = 4;
+const float kDefaultRelativeError = 1e-5f;
+
+struct ResultFrame
+{
+	// ÿڵ3XYZλƣgridpoint_result.txtһ
+	QVector<float> values;
+	float minValue = kMaxVal;
+	float maxValue = kMinVal;
+
+	int cacheCost() const;
+	void apply(NodeAttributes& nodeAttributes) const;
+};
+
+struct ResultStoreStats
+{
+	int frameNum = 0;
+	int keyframeNum = 0;
+	qint64 rawBytes = 0;
+	qint64 storedBytes = 0;
+	qint64 decodedBytes = 0;
+	qint64 decodeTime = 0;		// 
+
+	double compressionRatio() const;
+	double decodeThroughput() const;	// MB/s
+};
+
+class ResultStore
+{
+public:
+	ResultStore(int stepNum, int nodeNum, int keyframeInterval = kDefaultKeyframeInterval, float relativeError = kDefaultRelativeError);
+
+	void setErrorBounds(const std::array<float, kResultFieldNum>& bounds);
+	void initErrorBounds(const QVector<ResultFrame>& resultFrames);
+	std::array<float, kResultFieldNum> getErrorBounds() const;
+	int getKeyframeInterval() const;
+	int keyframeIndex(int index) const;
+	bool contains(int index) const;
+
+	bool encode(int index, const ResultFrame& resultFrame);
+	bool decode(int index, ResultFrame& resultFrame);
+
+	ResultStoreStats getStats() const;
+	void printStats() const;
+
+private:
+	struct Block
+	{
+		QByteArray data;
+		float minValue = kMaxVal;
+		float maxValue = kMinVal;
+	};
+
+	void quantize(const ResultFrame& resultFrame, QVector<qint64>& quantized) const;
+	void dequantize(const QVector<qint64>& quantized, ResultFrame& resultFrame) const;
+	double quantizationStep(int field) const;
+
+	static void encodeBlock(const QVector<qint64>& quantized, const QVector<qint64>* reference, QByteArray& data);
+	static bool decodeBlock(const QByteArray& data, const QVector<qint64>* reference, int valueNum, QVector<qint64>& quantized);
+	static void writeVarint(QByteArray& data, qint64 value);
+	static bool readVarint(const char*& p, const char* end, qint64& value);
+
+	int nodeNum;
+	int keyframeInterval;
+	float relativeError;
+	std::array<float, kResultFieldNum> errorBounds;
+
+	mutable QMutex mutex;
+	QVector<Block> blocks;
+	ResultStoreStats stats;
+};